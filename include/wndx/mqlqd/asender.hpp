@@ -0,0 +1,128 @@
+#pragma once
+/// asynchronous sender: file client embedded into the services. (library API)
+
+#include "aliases.hpp"
+
+#include "codec.hpp"
+#include "config.hpp"
+#include "fclient.hpp"
+#include "proto.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+/// \brief completion of the sent file, called by the thread of the Asender.
+/// rc::SUCCESS - the server has the file (checksummed session: verified),
+/// else the fail code of the transfer. NOTE: must not block or throw.
+using Adone = std::function<void(rc)>;
+
+/// \brief files & the contents in memory, queued one by one by any threads,
+/// are sent by the own thread of the Asender via the long-lived session
+/// (proto::fl_batches, pipelined) => callers never block on the network.
+/// Contents queued meanwhile the batch is sent form the next batch. (batch is
+/// capped by cfg::batch_iov_max files & cfg::asender_batch_bytes)
+/// Each one is completed by its callback or future, in the order of the queue.
+/// Idle connection is kept alive, broken one is reconnected by the next batch.
+class Asender final
+{
+public:
+  Asender()                          = delete;
+  Asender(Asender&&)                 = delete;
+  Asender(Asender const&)            = delete;
+  Asender& operator=(Asender&&)      = delete;
+  Asender& operator=(Asender const&) = delete;
+
+  /// \brief send all queued ones & join the thread.
+  ~Asender() noexcept;
+
+  /// \param flags - requested features of the session: proto::fl_crc and/or
+  ///                proto::fl_tree, others are ignored. (contents in memory)
+  /// \param ctype - compression of the contents. (if the server supports it)
+  explicit Asender(addr_t addr, port_t port, u32 flags = proto::fl_crc,
+                   codec::Ctype ctype = codec::Ctype::NONE,
+                   int          level = cfg::zstd_level);
+
+  /// \brief queue the file at the path. (its name is the file name)
+  /// It is read in chunks while its batch is sent: the file grown meanwhile
+  /// is sent up to its size when the batch started, the truncated one (short
+  /// read) fails its batch.
+  void send(fs::path fpath, Adone done);
+  [[nodiscard]] std::future<rc> send(fs::path fpath);
+
+  /// \brief queue the content in memory, not copied => the memory must
+  /// outlive the completion.
+  ///
+  /// \param name - name of the file on the server. (relative path: fl_tree)
+  void send(fs::path name, std::span<char const> content, Adone done);
+  [[nodiscard]] std::future<rc> send(fs::path              name,
+                                     std::span<char const> content);
+
+  /// \brief queue the content in memory, owned till the completion.
+  void send(fs::path name, std::vector<char>&& content, Adone done);
+  [[nodiscard]] std::future<rc> send(fs::path name, std::vector<char>&& content);
+
+  /// \brief wait till all queued ones are completed.
+  void flush();
+
+private:
+  /// \brief queued file or the content in memory.
+  struct Aitem
+  {
+    fs::path              path; // file, or the name of the content.
+    std::span<char const> content;
+    std::vector<char>     owned; // content owned by the Asender.
+    size_t                size{ 0 }; // bytes: of the content / file queued.
+    bool                  mem{ false };
+    Adone                 done;
+  };
+
+  void push(Aitem&& item);
+
+  /// \brief thread of the Asender: send the queued ones in batches, keep the
+  /// idle connection alive. (till the dtor & the queue is empty)
+  void run();
+
+  /// \brief send the batch & complete each one of it.
+  void send_batch(std::vector<Aitem>& vitems);
+
+  /// \brief send the files by the connection, reconnected if it is broken.
+  ///
+  /// \param  vbad - indexes of the files discarded by the server. (checksum)
+  /// \return 0 on success, else return fail code of the underlying functions.
+  [[nodiscard]] rc transfer(std::vector<file::File> const& vfiles,
+                            std::vector<u64>&              vbad);
+
+  /// \brief connect & negotiate the long-lived session.
+  ///
+  /// \return 0 on success, else return fail code of the underlying functions.
+  [[nodiscard]] rc connect();
+
+  addr_t const       m_addr{};
+  port_t const       m_port{};
+  u32 const          m_flags{ proto::fl_none };
+  codec::Ctype const m_ctype{ codec::Ctype::NONE };
+  int const          m_level{ cfg::zstd_level };
+
+  std::unique_ptr<Fclient> m_fclient; // null - not connected.
+
+  std::deque<Aitem>       m_queue;
+  size_t                  m_busy{ 0 }; // items of the batch being sent.
+  bool                    m_stop{ false };
+  std::mutex              m_mtx;
+  std::condition_variable m_cv_queue; // queued / stop.
+  std::condition_variable m_cv_idle;  // batch is completed.
+
+  std::jthread m_thread; // the last: started after all members.
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,103 @@
+#pragma once
+/// pool of the recycled buffers. (daemon worker)
+
+#include "aliases.hpp"
+
+#include "config.hpp"
+
+#include <array>
+#include <span>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+class Bpool;
+
+/// \brief buffer taken from the pool, given back to it by the dtor.
+class Buf final
+{
+public:
+  Buf(Buf const&)            = delete;
+  Buf& operator=(Buf const&) = delete;
+  ~Buf() noexcept;
+
+  /// \brief empty buffer. (nothing taken yet)
+  Buf() noexcept = default;
+
+  Buf(Buf&& other) noexcept;
+  Buf& operator=(Buf&& other) noexcept;
+
+  [[nodiscard]] char*  data() const noexcept { return m_data; }
+  [[nodiscard]] size_t size() const noexcept { return m_size; }
+  [[nodiscard]] bool   empty() const noexcept { return m_data == nullptr; }
+
+  [[nodiscard]] std::span<char> span() const noexcept
+  {
+    return { m_data, m_size };
+  }
+
+private:
+  friend class Bpool;
+
+  explicit Buf(Bpool* pool, char* data, size_t size) noexcept
+      : m_pool{ pool }
+      , m_data{ data }
+      , m_size{ size }
+  {
+  }
+
+  Bpool* m_pool{ nullptr };
+  char*  m_data{ nullptr };
+  size_t m_size{ 0 };
+};
+
+/// \brief buffers of the power of two size classes (at least a page),
+/// mapped once & recycled => no allocator churn per session or per file.
+/// Large buffers (multiple of the huge page) are backed by the huge pages,
+/// if there are any reserved, else the transparent huge pages are advised.
+/// NOTE: not thread-safe => one pool per worker. (must outlive its buffers)
+class Bpool final
+{
+public:
+  Bpool(Bpool&&)                 = delete;
+  Bpool(Bpool const&)            = delete;
+  Bpool& operator=(Bpool&&)      = delete;
+  Bpool& operator=(Bpool const&) = delete;
+  ~Bpool() noexcept;
+
+  /// \param keep_max - max bytes of the free buffers kept for the reuse.
+  explicit Bpool(size_t keep_max = cfg::pool_keep_max) noexcept;
+
+  /// \brief take the buffer of at least the size bytes (size class).
+  ///
+  /// \return empty Buf on error - and errno msg is logged.
+  [[nodiscard]] Buf take(size_t size);
+
+  /// \brief number of the buffers taken from the free ones / newly mapped.
+  [[nodiscard]] size_t hits() const noexcept { return m_hits; }
+  [[nodiscard]] size_t misses() const noexcept { return m_misses; }
+
+  /// \brief size class of the buffer of the size bytes.
+  [[nodiscard]] static size_t class_size(size_t size) noexcept;
+
+private:
+  friend class Buf;
+
+  /// \brief buffer is not used anymore => kept or unmapped.
+  void give(char* data, size_t size) noexcept;
+
+  static constexpr size_t page_size{ 4096 };
+  static constexpr size_t huge_page_size{ 2 * 1024 * 1024 };
+  static constexpr size_t nclasses{ 64 };
+
+  size_t const m_keep_max{ 0 };
+  size_t       m_kept{ 0 }; // bytes of the free buffers.
+  size_t       m_hits{ 0 };
+  size_t       m_misses{ 0 };
+
+  /// free buffers by the size class. (log2 of the size)
+  std::array<std::vector<char*>, nclasses> m_vfree;
+};
+
+} // namespace wndx::mqlqd
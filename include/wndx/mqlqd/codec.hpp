@@ -0,0 +1,95 @@
+#pragma once
+/// compression of the file content (blocks) via zstd or lz4.
+/// codecs are optional: available only if the libraries were found at build.
+
+#include "aliases.hpp"
+
+#include "config.hpp"
+
+#include <vector>
+
+extern "C" {
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+} // extern "C"
+
+
+namespace wndx::mqlqd::codec {
+
+enum class Ctype : u8
+{
+  NONE,
+  ZSTD, // better ratio, level is selectable.
+  LZ4,  // lower CPU cost.
+};
+
+/// \return session flags of the codecs built into this binary. (proto::fl_*)
+[[nodiscard]] u32 available() noexcept;
+
+/// \return session flag of the codec, 0 for the Ctype::NONE.
+[[nodiscard]] u32 to_flag(Ctype ctype) noexcept;
+
+/// \return codec selected by the session flags. (zstd is preferred)
+[[nodiscard]] Ctype from_flags(u32 flags) noexcept;
+
+/// \brief parse name of the codec: "zstd", "lz4" or "none".
+///
+/// \return 0 on success, -1 on unknown name.
+[[nodiscard]] int parse(sv_t name, Ctype& ctype) noexcept;
+
+class Codec final
+{
+public:
+  Codec()                        = delete;
+  Codec(Codec&&)                 = delete;
+  Codec(Codec const&)            = delete;
+  Codec& operator=(Codec&&)      = delete;
+  Codec& operator=(Codec const&) = delete;
+  ~Codec() noexcept;
+
+  /// \param level - compression level. (zstd only)
+  explicit Codec(Ctype ctype, int level = cfg::zstd_level) noexcept;
+
+  [[nodiscard]] Ctype type() const noexcept { return m_ctype; }
+
+  /// \return max size of the compressed block of len bytes.
+  [[nodiscard]] size_t bound(size_t len) const noexcept;
+
+  /// \brief compress the block.
+  ///
+  /// \return size of the compressed block.
+  /// \return 0 if it is not smaller than the source or on error (=> send raw).
+  [[nodiscard]] size_t compress(char const* src, size_t len, char* dst,
+                                size_t cap);
+
+  /// \brief decompress the block of exactly raw bytes.
+  ///
+  /// \return  0 on success.
+  /// \return -1 on error - malformed block or size mismatch.
+  [[nodiscard]] int decompress(char const* src, size_t clen, char* dst,
+                               size_t raw);
+
+  /// \brief adaptive mode: compress the sample of the content & check the
+  /// ratio => already compressed (media, archives) content is sent raw.
+  ///
+  /// \return true if compression of the content is worth it.
+  [[nodiscard]] bool worth(char const* sample, size_t len);
+
+private:
+  Ctype const m_ctype{ Ctype::NONE };
+  int const   m_level{ cfg::zstd_level };
+
+  /// contexts are reused between the blocks. (lazily created)
+  struct ZSTD_CCtx_s* m_cctx{ nullptr };
+  struct ZSTD_DCtx_s* m_dctx{ nullptr };
+
+  /// lz4 compression state. (lazily allocated)
+  std::vector<char> m_lz4_state;
+
+  /// output of the worth(). (lazily allocated)
+  std::vector<char> m_scratch;
+};
+
+} // namespace wndx::mqlqd::codec
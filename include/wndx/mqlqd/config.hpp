@@ -18,4 +18,90 @@ inline constexpr sv_t log_fpath{ "/tmp/mqlqd/logs/default.log" };
 // default (client UID / device MAC) unique to the client/device.
 inline constexpr sv_t def_uid{ "f000::f000:f000:f000:f000" };
 
+// max number of the daemon worker threads (each with own listening socket).
+inline constexpr unsigned workers_max{ 1024 };
+
+// size of the reusable buffer for the chunked file transfer (bytes).
+inline constexpr std::size_t chunk_size{ 256 * 1024 };
+
+// files up to this size are coalesced into the batches (in zero-copy mode),
+// batch is sent by the single sendmsg() with up to batch_iov_max buffers.
+inline constexpr std::size_t batch_file_max{ 64 * 1024 };
+inline constexpr std::size_t batch_iov_max{ 1024 }; // IOV_MAX on Linux
+
+// pipelined transfer: readahead of the next file while the current one is
+// sent (up to this many bytes from the beginning of the file).
+inline constexpr std::size_t prefetch_max{ 8 * 1024 * 1024 };
+
+// mapped file content (buffered transfer): files up to this size are
+// populated by the mmap() itself, the larger ones are read ahead on access.
+inline constexpr std::size_t mmap_populate_max{ 64 * 1024 * 1024 };
+
+// read-ahead (--max-inflight-bytes): number of the threads reading the
+// contents into the ring of the chunk_size buffers.
+inline constexpr unsigned read_threads{ 4 };
+
+// parallel streams: max number of the connections per client, files of at
+// least stream_file_min bytes are split into ranges sent concurrently.
+inline constexpr unsigned    streams_max{ 64 };
+inline constexpr std::size_t stream_file_min{ 16 * 1024 * 1024 };
+
+// streams of the client do not overlap in time => the incomplete ranges of
+// the file are kept till no range of it arrived for range_stale seconds.
+inline constexpr unsigned range_stale{ 300 };
+
+// recursive transfer: max number of the threads walking the dir trees &
+// size of the buffer for the dir entries of each thread (bytes).
+inline constexpr unsigned    walk_threads_max{ 16 };
+inline constexpr std::size_t walk_buf_size{ 64 * 1024 };
+
+// long-lived session (--watch): paths arriving within watch_linger_ms of
+// each other are sent as one batch (up to batch_iov_max files), the idle
+// connection is kept alive by the empty batch every watch_ping seconds.
+inline constexpr unsigned watch_linger_ms{ 50 };
+inline constexpr unsigned watch_ping{ 30 };
+
+// Asender: the batch is also capped by the bytes of its files (at least one
+// file) => the completions of the queued ones are not held by the huge batch.
+inline constexpr std::size_t asender_batch_bytes{ 64 * 1024 * 1024 };
+
+// TCP keepalive of the idle connection: probes after keepalive_idle seconds,
+// every keepalive_intvl seconds, the peer is dead after keepalive_cnt ones.
+inline constexpr unsigned keepalive_idle{ 60 };
+inline constexpr unsigned keepalive_intvl{ 10 };
+inline constexpr unsigned keepalive_cnt{ 6 };
+
+// max delay between the retries of the interrupted transfer (seconds).
+inline constexpr unsigned retry_backoff_max{ 30 };
+
+// compression: default zstd level, size of the sample of the file content &
+// max compressed size of the sample (percent) => else the file is sent raw.
+inline constexpr int         zstd_level{ 3 };
+inline constexpr std::size_t comp_sample{ 64 * 1024 };
+inline constexpr std::size_t comp_ratio_max{ 90 };
+
+// delta transfer: old copies of at least delta_file_min bytes are the basis,
+// signatures are of the ~sqrt(size) blocks (at least delta_block_min bytes).
+inline constexpr std::size_t delta_file_min{ 64 * 1024 };
+inline constexpr std::size_t delta_block_min{ 2 * 1024 };
+
+// daemon: space of the received files of at least this size is reserved at
+// once, before their contents are written. (fallocate)
+inline constexpr std::size_t prealloc_min{ 1024 * 1024 };
+
+// daemon --durability batch: finished sessions are flushed together (group
+// commit) at most this many ms after the first of them, or right away when
+// their files reach this many bytes.
+inline constexpr unsigned    group_commit_ms{ 10 };
+inline constexpr std::size_t group_commit_bytes{ 256 * 1024 * 1024 };
+
+// daemon worker: max bytes of the free buffers kept by its pool for the reuse
+// (e.g. decompression buffers of the finished sessions).
+inline constexpr std::size_t pool_keep_max{ 64 * 1024 * 1024 };
+
+// io_uring engine: number of the SQ ring entries & registered recv buffers
+// (each of the chunk_size), readable connections wait for the free buffer.
+inline constexpr unsigned    uring_entries{ 1024 };
+inline constexpr std::size_t uring_bufs{ 64 };
+
 } // namespace wndx::mqlqd::cfg
@@ -0,0 +1,18 @@
+#pragma once
+/// CRC32C (Castagnoli) - integrity checksum of the transferred content.
+/// hardware accelerated (SSE4.2 crc32 instruction, selected at runtime),
+/// with the portable table-driven fallback. (same results on all hosts)
+
+#include "aliases.hpp"
+
+
+namespace wndx::mqlqd {
+
+/// \brief CRC32C of the buffer, continued from the crc of the preceding bytes.
+/// (0 - initial value, i.e. the crc of the empty content)
+[[nodiscard]] u32 crc32c(u32 crc, char const* data, size_t len) noexcept;
+
+/// \brief crc32c() is computed by the crc32 instruction of the CPU.
+[[nodiscard]] bool crc32c_hw() noexcept;
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,137 @@
+#pragma once
+/// delta transfer (rsync algorithm): the new content is expressed as the
+/// literal runs & references to the blocks of the old copy on the server.
+
+#include "aliases.hpp"
+
+#include "proto.hpp"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+
+namespace wndx::mqlqd::delta {
+
+/// \return size of the blocks of the signatures: ~sqrt(size) as in rsync.
+[[nodiscard]] u64 block_size(u64 size) noexcept;
+
+/// \brief rolling checksum of the window. (rsync weak checksum, mod 2^16)
+class Rsum final
+{
+public:
+  void init(char const* data, size_t len) noexcept;
+
+  /// \brief slide the window by one byte.
+  void roll(char out, char in) noexcept;
+
+  [[nodiscard]] u32 value() const noexcept
+  {
+    return (m_b << 16U) | (m_a & 0xFFFFU); // NOLINT(*-magic-numbers)
+  }
+
+private:
+  u32 m_a{ 0 };
+  u32 m_b{ 0 };
+  u32 m_len{ 0 };
+};
+
+/// \brief signatures of the full blocks of the file. (reads the whole file)
+///
+/// \param  fd - file opened for reading.
+/// \return  0 on success.
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+[[nodiscard]] int signatures(int fd, u64 size, proto::Fsigs& fsigs);
+
+/// \brief lookup of the blocks of the old copy by the content.
+class Sigset final
+{
+public:
+  Sigset()                         = delete;
+  Sigset(Sigset&&)                 = delete;
+  Sigset(Sigset const&)            = delete;
+  Sigset& operator=(Sigset&&)      = delete;
+  Sigset& operator=(Sigset const&) = delete;
+  ~Sigset() noexcept               = default;
+
+  explicit Sigset(proto::Fsigs const& fsigs);
+
+  static constexpr size_t none{ static_cast<size_t>(-1) };
+
+  [[nodiscard]] size_t block() const noexcept { return m_block; }
+
+  /// \brief cheap negative lookup. (per byte of the scanned content)
+  ///
+  /// \return false if there is no block with the weak checksum for sure.
+  [[nodiscard]] bool candidate(u32 const weak) const noexcept
+  {
+    return m_tag[tag(weak)];
+  }
+
+  /// \param  weak - rolling checksum of the block at the data.
+  /// \param  hint - likely block (next after the previous match).
+  /// \return index of the block with the same content, none if not found.
+  [[nodiscard]] size_t find(u32 weak, char const* data, size_t hint) const;
+
+private:
+  /// bits of the tag => few false positives even for the millions of blocks.
+  static constexpr unsigned tag_bits{ 20 };
+
+  [[nodiscard]] static size_t tag(u32 const weak) noexcept
+  {
+    // multiplicative hashing: the rolling checksum is not uniform.
+    u64 const h{ weak * 0x9E3779B97F4A7C15ULL }; // NOLINT(*-magic-numbers)
+    return static_cast<size_t>(h >> (64U - tag_bits));
+  }
+
+  size_t                               m_block;
+  std::vector<proto::Sig> const&       m_vsig;
+  std::vector<bool>                    m_tag; // see: candidate().
+  std::unordered_multimap<u32, size_t> m_by_weak;
+};
+
+/// \brief scan the new content against the old copy => sequence of the Dop.
+/// Consecutive blocks are merged into the single copy, literal runs are
+/// limited to the cfg::chunk_size.
+class Scanner final
+{
+public:
+  Scanner()                          = delete;
+  Scanner(Scanner&&)                 = delete;
+  Scanner(Scanner const&)            = delete;
+  Scanner& operator=(Scanner&&)      = delete;
+  Scanner& operator=(Scanner const&) = delete;
+  ~Scanner() noexcept                = default;
+
+  Scanner(char const* data, size_t len, Sigset const& sigset) noexcept;
+
+  /// \brief next operation. (LITERAL: off is the position in the new content)
+  ///
+  /// \return false when the whole content is covered.
+  [[nodiscard]] bool next(proto::Dop& op);
+
+protected:
+  /// \brief scan till at least one operation is queued or the end.
+  void step();
+
+  void push_copy();
+
+  void push_literal(size_t end);
+
+private:
+  char const*   m_data;
+  size_t        m_len;
+  Sigset const& m_sigset;
+
+  size_t m_pos{ 0 };       // start of the window.
+  size_t m_lit{ 0 };       // start of the pending literal run.
+  size_t m_hint{ 0 };      // block expected next.
+  bool   m_valid{ false }; // m_rsum is of the window at the m_pos.
+  bool   m_done{ false };
+  Rsum   m_rsum;
+
+  proto::Dop             m_copy{}; // pending copy (extended while contiguous).
+  std::deque<proto::Dop> m_queue;
+};
+
+} // namespace wndx::mqlqd::delta
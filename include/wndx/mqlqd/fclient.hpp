@@ -3,19 +3,45 @@
 
 #include "aliases.hpp"
 
+#include "codec.hpp"
+#include "config.hpp"
 #include "file.hpp"
+#include "proto.hpp"
+#include "reader.hpp"
+#include "walker.hpp"
 
+#include <deque>
+#include <memory>
+#include <string>
 #include <vector>
 
 extern "C" {
 
 #include <netinet/in.h> // Internet domain sockets | sockaddr(3type)
+#include <sys/types.h>  // off_t
+#include <sys/uio.h>    // struct iovec
 
 } // extern "C"
 
 
 namespace wndx::mqlqd {
 
+/// \brief transfer mode of the file client (how the file content is sent).
+enum class Tmode : u8
+{
+  BUFFERED, // from memory: File::map() or File::alloc_and_read() content.
+  CHUNKED,  // read from the disk in chunks into the reusable buffer.
+  SENDFILE, // zero-copy from the page cache to the socket via sendfile(2).
+};
+
+/// \brief part of the large file sent by one of the parallel streams.
+struct Frange
+{
+  file::File const* file{ nullptr };
+  size_t            off{ 0 }; // position in the file.
+  size_t            len{ 0 };
+};
+
 class Fclient final
 {
 public:
@@ -26,24 +52,82 @@ public:
   Fclient& operator=(Fclient const&) = delete;
   ~Fclient() noexcept;
 
-  explicit Fclient(addr_t const& addr, port_t const& port) noexcept;
+  explicit Fclient(addr_t const& addr, port_t const& port,
+                   Tmode const tmode = Tmode::BUFFERED) noexcept;
 
   /// \brief initialize & start on success of all underlying functions.
+  /// (connect & negotiate version of the protocol with the server)
   ///
+  /// \param  flags - requested features of the session. (proto::fl_*)
   /// \return 0 on success, else return fail code of the underlying functions.
-  [[nodiscard]] rc init();
+  [[nodiscard]] rc init(u32 flags = proto::fl_none);
 
-  /// \brief send info files structures, with the files information.
+  /// \brief send info of the upcoming transfer: number of the files &
+  /// the file headers (size & name) encoded into the single buffer.
+  /// resumable session (proto::fl_resume): wait for the Plan of the server,
+  /// so that send_files() sends only the contents not received yet.
   ///
-  /// \param  vfinfo - vector of Finfo objects.
+  /// \param  vfiles - vector of File objects.
   /// \return 0 on success, else return fail code of the underlying functions.
-  [[nodiscard]] rc send_files_info(std::vector<file::Finfo> const& vfinfo);
+  [[nodiscard]] rc send_files_info(std::vector<file::File> const& vfiles);
+
+  /// \brief compress the contents of the files (requested in the init()).
+  /// adaptive: file is sent raw if the sample of its content is incompressible.
+  ///
+  /// \param level - compression level. (zstd only)
+  void set_compression(codec::Ctype const ctype,
+                       int const          level = cfg::zstd_level) noexcept
+  {
+    m_ctype = ctype;
+    m_level = level;
+  }
+
+  /// \brief read the contents ahead of the sends by the threads, up to the
+  /// budget of bytes in memory. (Tmode::CHUNKED only, else ignored)
+  void set_readahead(size_t const budget)
+  {
+    if (m_tmode == Tmode::CHUNKED && budget > 0) {
+      m_reader = std::make_unique<Reader>(budget, cfg::read_threads);
+    }
+  }
+
+  /// \brief features of the session accepted by the server.
+  [[nodiscard]] u32 flags() const noexcept { return m_flags; }
+
+  /// \brief checksummed session (proto::fl_crc): indexes of the files (in the
+  /// order of the headers, ranges after the files) discarded by the server.
+  [[nodiscard]] std::vector<u64> const& bad() const noexcept { return m_vbad; }
+
+  /// \brief proto::fl_publish: indexes of the ranges (the same order as the
+  /// bad()) whose commit published their file.
+  [[nodiscard]] std::vector<u64> const& published() const noexcept
+  {
+    return m_vpub;
+  }
 
   /// \brief send files.
+  /// pipelined session (proto::fl_pipeline): header of each file is sent
+  /// right before its content & the next file is prefetched meanwhile.
+  ///
+  /// \param  vfiles  - vector of File objects.
+  /// \param  vranges - ranges of the large files, sent after the files.
+  ///                   (pipelined session & content not in memory only)
+  /// \return 0 on success, else return fail code of the underlying functions.
+  [[nodiscard]] rc send_files(std::vector<file::File> const& vfiles,
+                              std::vector<Frange> const&     vranges = {});
+
+  /// \brief send files found by the walker, while it walks the dir trees.
+  /// (pipelined session)
+  ///
+  /// \return 0 on success, else return fail code of the underlying functions.
+  [[nodiscard]] rc send_files(Walker& walker);
+
+  /// \brief send the transfer without files, so that the idle connection of
+  /// the long-lived session (proto::fl_batches) stays alive & the dead one
+  /// is detected. (checksummed session: waits for the empty Verdict)
   ///
-  /// \param  vfiles - vector of File objects.
   /// \return 0 on success, else return fail code of the underlying functions.
-  [[nodiscard]] rc send_files(std::vector<file::File> const& vfiles);
+  [[nodiscard]] rc keepalive();
 
 protected:
   /// \brief man socket(2).
@@ -58,6 +142,42 @@ protected:
   /// \return -1 on error.
   [[nodiscard]] int create_connection();
 
+  /// \brief recv the Plan: offsets of the already received contents.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int recv_plan(std::vector<file::File> const& vfiles);
+
+  /// \brief recv the Verdict: files whose checksum did not match.
+  /// (proto::fl_publish: & the ranges which published their file)
+  ///
+  /// \param  count - number of the sent headers.
+  /// \return 0 on success.
+  [[nodiscard]] int recv_verdict(size_t count);
+
+  /// \brief send the header (pipelined) & the content of the file.
+  ///
+  /// \param idx  - index of the file in the transfer. (Plan etc)
+  /// \param next - file sent after this one, if known. (prefetch)
+  /// \return 0 on success.
+  [[nodiscard]] int send_one(file::File const& file, size_t idx,
+                             file::File const* next);
+
+  /// \brief finish the transfer & wait for the Verdict. (proto::fl_crc)
+  ///
+  /// \return 0 on success, else return fail code of the underlying functions.
+  [[nodiscard]] rc send_end(size_t nfiles, size_t nranges);
+
+  /// \brief recv length-prefixed reply of the server.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int recv_reply(std::string& body);
+
+  /// \brief send Hello & wait for the HelloAck of the server.
+  ///
+  /// \return  0 on success.
+  /// \return -1 on error.
+  [[nodiscard]] int negotiate(u32 flags);
+
   ////////////////////////////////////////////////////////////////
   /// following are the helper methods.
 
@@ -66,36 +186,148 @@ protected:
   /// \brief fill the sockaddr_in structure.
   [[nodiscard]] int fill_sockaddr_in();
 
-  /// \brief send num_files_total, so that the server knows how many to expect.
+  /// \brief add file header into the batch. (pipelined session)
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int batch_hdr(proto::Fhdr const& hdr);
+
+  /// \brief recv the Sigs: signatures of the old copies of the files.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int recv_sigs(std::vector<file::File> const& vfiles);
+
+  /// \brief send File content as the delta against the old copy. (proto::Dop)
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int send_file_delta(file::File const&   file,
+                                    proto::Fsigs const& fsigs);
+
+  [[nodiscard]] bool crc() const noexcept
+  {
+    return (m_flags & proto::fl_crc) != 0;
+  }
+
+  /// \brief continue the checksum of the current content by the file bytes,
+  /// read again (sendfile - page cache) or already in memory.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int crc_file(file::File const& file, size_t off, size_t len);
+
+  /// \brief add the checksum of the current content into the batch.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int batch_crc();
+
+  /// \brief hash of the whole content of the file. (dedup)
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int hash_file(file::File const& file, u64& hash);
+
+  /// \brief decide if the content of the file is sent in compressed blocks.
+  /// (by the sample of the content from the offset)
+  [[nodiscard]] bool zframe(file::File const& file, size_t off);
+
+  /// \brief send File content in the compressed blocks. (proto::Zblk)
   ///
-  /// \param num_files_total - total number of the files to send.
+  /// \param off - position in the file from which to send. (resume)
   /// \return 0 on success.
-  [[nodiscard]] int send_num_files_total(size_t const num_files_total) const;
+  [[nodiscard]] int send_file_z(file::File const& file, size_t off);
 
-  /// \brief description
+  /// \brief send header of the range & its content.
   ///
-  /// \param finfo - Finfo structure, with the file information.
   /// \return 0 on success.
-  [[nodiscard]] int send_file_info(file::Finfo const& finfo);
+  [[nodiscard]] int send_range(Frange const& range);
+
+  /// \brief queue the content of the file for the read-ahead, if it is sent
+  /// in chunks. (see: send_one())
+  ///
+  /// \param idx - index of the file in the transfer. (Plan etc)
+  void read_ahead(file::File const& file, size_t idx);
+
+  /// \brief send File content from the chunks read ahead by the m_reader.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int send_file_ahead(file::File const& file, size_t off,
+                                    size_t len);
+
+  /// \brief hint the kernel to start reading the file into the page cache,
+  /// so that it is ready when its turn to be sent comes. (not in memory)
+  void prefetch(file::File const& file) noexcept;
+
+  /// \brief content of the file in memory. (Tmode::BUFFERED)
+  /// The file which is not in memory yet is mapped (or read) into the copy
+  /// held till its content is sent => one mapping per file in flight only.
+  ///
+  /// \return the file itself or its held copy, nullptr on error.
+  [[nodiscard]] file::File const* hold(file::File const& file);
+
+  /// \brief add File into the batch of the small files, which contents are
+  /// sent together by the single sendmsg() call. (sent when the batch is full)
+  ///
+  /// \param file - File object, with the file information.
+  /// \param off  - position in the file from which to send. (resume)
+  /// \return 0 on success.
+  [[nodiscard]] int batch_file(file::File const& file, size_t off = 0);
+
+  /// \brief send contents of all files in the batch & clear the batch.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int send_batch();
+
+  /// \brief man sendmsg(2). gather output of the many buffers.
+  ///
+  /// \param iov    - array of the buffers (modified to track the progress).
+  /// \param iovcnt - number of the buffers.
+  /// \return  0 on success - when all bytes are sent (finish).
+  /// \return -1 on error   - and errno msg is logged to indicate the error.
+  /// \return -2 on sendmsg() -> 0 - nothing to send etc.
+  [[nodiscard]] int send_iov_loop(struct iovec* iov, size_t iovcnt);
 
   /// \brief send File.
   ///
   /// \param file - File object, with the file information.
+  /// \param off  - position in the file from which to send. (resume)
+  /// \return 0 on success.
+  [[nodiscard]] int send_file(file::File const& file, size_t off = 0);
+
+  /// \brief send File content straight from the page cache via sendfile(2).
+  /// Fallback to the send_file_chunked() if sendfile(2) is not supported.
+  /// (Tmode::CHUNKED - always send_file_chunked())
+  ///
+  /// \param file   - File object (memory block is not required).
+  /// \param offset - position in the file from which to start sending.
+  /// \param len    - number of bytes to send.
   /// \return 0 on success.
-  [[nodiscard]] int send_file(file::File const& file);
+  [[nodiscard]] int send_file_zc(file::File const& file, off_t offset,
+                                 size_t len);
 
-  /// \brief man send(2).
+  /// \brief send File content by reading it in chunks into the reusable buffer.
   ///
+  /// \param fd_in  - opened file descriptor of the file.
+  /// \param offset - position in the file from which to start sending.
+  /// \param len    - number of bytes to send.
+  /// \return 0 on success.
+  [[nodiscard]] int send_file_chunked(int fd_in, off_t offset, size_t len);
+
+  /// \brief man sendfile(2).
+  ///
+  /// \param offset - position in the file, updated by the sent bytes.
   /// \return  0 on success - when all bytes are sent (finish).
   /// \return -1 on error   - and errno msg is logged to indicate the error.
-  /// \return -2 on send() -> 0 - nothing to send etc.
-  template <typename T = file::File::char_type>
-  [[nodiscard]] int send_loop(int fd, void const* buf, size_t len);
+  /// \return -2 on sendfile() -> 0 - file was truncated while sending.
+  /// \return -3 on sendfile() is not supported for the fd (nothing sent).
+  [[nodiscard]] int sendfile_loop(int fd_in, off_t& offset, size_t len);
+
 
 private:
   /// initialized via explicit ctor
   addr_t const m_addr{};
   port_t const m_port{};
+  Tmode const  m_tmode{};
+
+  /// negotiated version of the protocol & features of the session.
+  u8  m_version{ 0 };
+  u32 m_flags{ proto::fl_none };
 
   /// reusable for the POSIX return codes
   int m_rc{ static_cast<int>(rc::INIT) };
@@ -108,6 +340,44 @@ private:
 
   struct sockaddr_in m_sockaddr_in{};
 
+  /// reusable buffer for the chunked transfer. (lazily allocated)
+  std::vector<file::File::char_type> m_chunk;
+
+  /// batch of the small files & buffers with their contents.
+  std::vector<file::File const*> m_vbatch;
+  std::vector<struct iovec>      m_viov;
+  std::string m_hdrs; // encoded headers of the batch. (pipelined session)
+  std::deque<file::File> m_vheld; // contents mapped by the hold().
+
+  /// resumable: offsets from which the contents are sent. (the Plan)
+  std::vector<u64> m_vplan;
+
+  /// compression: requested codec & the codec of the session.
+  codec::Ctype                  m_ctype{ codec::Ctype::NONE };
+  int                           m_level{ cfg::zstd_level };
+  std::unique_ptr<codec::Codec> m_codec;
+  std::vector<u8>   m_vzframe; // per-file: content in compressed blocks.
+  std::vector<char> m_zbuf;    // compressed block.
+
+  /// delta: signatures of the old copies & per-file index of them.
+  /// (delta::Sigset::none - content is sent as is)
+  std::vector<proto::Fsigs> m_vfsigs;
+  std::vector<size_t>       m_vdelta;
+  size_t m_batch_len{ 0 }; // bytes of the batch contents read into m_chunk.
+
+  /// checksum of the current content & the files discarded by the server
+  /// & the ranges which published their file. (proto::fl_publish)
+  u32              m_crc{ 0 };
+  std::vector<u64> m_vbad;
+  std::vector<u64> m_vpub;
+
+  /// files found by the walker: referenced by the batch, the Verdict & the
+  /// read-ahead => kept till the end.
+  std::deque<file::File> m_vwalked;
+
+  /// read-ahead of the contents sent in chunks. (bounded memory)
+  std::unique_ptr<Reader> m_reader;
+
   /// TODO: probably better to rewrite later using addrinfo structure.
   ///       If it make sense!
   // addrinfo    m_addrinfo    {};
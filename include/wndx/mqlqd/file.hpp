@@ -4,6 +4,8 @@
 
 #include "wndx/sane/file.hpp"
 
+#include <memory>
+
 
 namespace wndx::mqlqd::file {
 
@@ -32,11 +34,72 @@ public:
   /// \brief construct class instance from the file path & its size.
   explicit File(fs::path fpath, std::size_t sz) noexcept;
 
+  /// \brief construct class instance from the file path, its size & name.
+  ///
+  /// \param name - relative path of the file on the receiving side.
+  explicit File(fs::path fpath, std::size_t sz, fs::path name) noexcept;
+
   /// \brief construct class instance from the file info structure.
   explicit File(Finfo const& finfo, fs::path dpath) noexcept;
 
   /// \brief convert essentials of the instance into file info structure.
   [[nodiscard]] Finfo to_finfo() const noexcept;
+
+  /// \brief name of the file on the wire. (by default, the file name)
+  [[nodiscard]] fs::path const& name() const noexcept { return m_name; }
+
+  /// \brief map the file content into memory (read-only, shared with the
+  /// page cache) instead of reading it into the allocated block.
+  /// small files are populated right away, the large ones are read ahead
+  /// sequentially while they are accessed. (copies share the mapping)
+  /// NOTE: file must not be truncated while mapped. (SIGBUS on access)
+  ///
+  /// \return rc::SUCCESS on success (nothing is mapped for the empty file).
+  /// \return rc::FAILURE on error (e.g. not a regular file) - errno is logged.
+  [[nodiscard]] rc map() noexcept;
+
+  /// \brief content is the memory of the caller (size() bytes), instead of
+  /// the file at the path: neither owned nor copied => must outlive the File
+  /// & its copies.
+  void view(char_type const* content) noexcept { m_view = content; }
+
+  /// \brief file content in memory: mapped, viewed or read by the
+  /// alloc_and_read().
+  [[nodiscard]] char_type const* data() const noexcept
+  {
+    if (m_map) {
+      return m_map->addr;
+    }
+    return m_view != nullptr ? m_view : memory();
+  }
+
+  /// \brief file content is mapped into memory.
+  [[nodiscard]] bool mapped() const noexcept { return m_map != nullptr; }
+
+private:
+  /// \brief mapped file content, unmapped with the last File referencing it.
+  struct Mmap
+  {
+    Mmap()                       = delete;
+    Mmap(Mmap&&)                 = delete;
+    Mmap(Mmap const&)            = delete;
+    Mmap& operator=(Mmap&&)      = delete;
+    Mmap& operator=(Mmap const&) = delete;
+    ~Mmap() noexcept;
+
+    explicit Mmap(char_type* p, std::size_t sz) noexcept
+        : addr{ p }
+        , len{ sz }
+    {
+    }
+
+    char_type* const  addr{ nullptr };
+    std::size_t const len{ 0 };
+  };
+
+  fs::path                    m_name;
+  std::shared_ptr<Mmap const> m_map;
+  char_type const*            m_view{ nullptr };
 };
 
 } // namespace wndx::mqlqd::file
@@ -3,19 +3,74 @@
 
 #include "aliases.hpp"
 
-#include "file.hpp"
-
+#include "bpool.hpp"
+#include "fsession.hpp"
+#include "hindex.hpp"
+#include "poller.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 extern "C" {
 
 #include <netinet/in.h> // Internet domain sockets | sockaddr(3type)
+#include <sys/socket.h> // SOMAXCONN
 
 } // extern "C"
 
 
 namespace wndx::mqlqd {
 
+/// \brief I/O engine of the file server event loop.
+enum class Engine : u8
+{
+  EPOLL, // readiness via the Poller + recv(2) & write(2) syscalls.
+  URING, // batched recv & write submissions via io_uring(7) (liburing).
+};
+
+/// \brief helper thread of the worker: computes the delta signatures off
+/// the event loop. (started by the first job)
+class Sigworker final
+{
+public:
+  Sigworker(Sigworker&&)                 = delete;
+  Sigworker(Sigworker const&)            = delete;
+  Sigworker& operator=(Sigworker&&)      = delete;
+  Sigworker& operator=(Sigworker const&) = delete;
+  ~Sigworker() noexcept;
+
+  Sigworker() noexcept = default;
+
+  /// \return 0 on success, -1 on error. (errno msg is logged)
+  [[nodiscard]] int init();
+
+  /// \brief eventfd(2) signaled when the jobs are done. (watched by the loop)
+  [[nodiscard]] int fd() const noexcept { return m_fd; }
+
+  void push(Sjob job);
+
+  /// \brief take the done jobs. (the fd() is readable)
+  [[nodiscard]] std::vector<Sjob> done();
+
+private:
+  void run();
+
+  int                     m_fd{ -1 };
+  std::mutex              m_mtx;
+  std::condition_variable m_cv;
+  std::deque<Sjob>        m_vtodo;
+  std::vector<Sjob>       m_vdone;
+  bool                    m_stop{ false };
+  std::thread             m_thread;
+};
+
 class Fserver final
 {
 public:
@@ -26,24 +81,46 @@ public:
   Fserver& operator=(Fserver const&) = delete;
   ~Fserver() noexcept;
 
-  explicit Fserver(port_t port, fs::path storage_dir) noexcept;
+  /// \param reuseport - set SO_REUSEPORT on the listening socket, so that many
+  ///                    servers (one per worker thread) may listen on the same
+  ///                    port, while the kernel distributes connections.
+  /// \param engine    - I/O engine, io_uring falls back to epoll if the
+  ///                    daemon is built without liburing or kernel lacks it.
+  explicit Fserver(port_t port, fs::path storage_dir, bool reuseport = false,
+                   Engine engine = Engine::EPOLL) noexcept;
+
+  /// \brief when the received files are flushed to the stable storage.
+  /// (before the sessions are reported as finished to the peers)
+  void set_durability(Durability const durability) noexcept
+  {
+    m_durability = durability;
+  }
 
   /// \brief initialize & start on success of all underlying functions.
+  /// (long-lived non-blocking listening socket watched by the poller)
   ///
   /// \return 0 on success, else return fail code of the underlying functions.
   [[nodiscard]] rc init();
 
-  /// \brief recv info files structures, with the files information.
+  /// \brief event loop: accept connections & serve all sessions concurrently.
+  /// Works infinitely till one of the stop signals received.
   ///
-  /// \return 0 on success, else return fail code of the underlying functions.
-  [[nodiscard]] rc recv_files_info();
+  /// \return fail code of the underlying functions. (on the fatal error,
+  ///         the listening socket is closed)
+  /// \return rc::SUCCESS when stopped by the stop().
+  [[nodiscard]] rc run();
 
-  /// \brief recv files.
-  ///
-  /// \return 0 on success, else return fail code of the underlying functions.
-  [[nodiscard]] rc recv_files();
+  /// \brief make the run() return, e.g. from the other thread of the process
+  /// embedding the server. (thread-safe, after the init())
+  void stop() noexcept;
 
 protected:
+  /// \brief event loop of the Engine::EPOLL.
+  [[nodiscard]] rc run_epoll();
+
+  /// \brief event loop of the Engine::URING. (see: fserver_uring.cpp)
+  [[nodiscard]] rc run_uring();
+
   /// \brief man socket(2).
   ///
   /// \return file descriptor for the new socket (on success).
@@ -62,84 +139,137 @@ protected:
   /// \return -1 on error.
   [[nodiscard]] int set_socket_in_listen_state();
 
-  /// \brief man accept(2).
+  /// \brief man accept(2). accept all pending connections & start sessions.
   ///
-  /// \return file descriptor for the new connected socket (on success).
+  /// \return  0 on success.
   /// \return -1 on error.
-  [[nodiscard]] int accept_connection();
+  [[nodiscard]] int accept_connections();
+
+  /// \brief out of the fds: accept & close the pending connection via the
+  /// spare fd, else the listening socket stays readable & the loop spins.
+  void shed_connection() noexcept;
+
+  /// \brief stop watching & destroy the session (closes its connection).
+  void close_session(int fd_con);
+
+  /// \brief delta: the session waits for the signatures => to the helper.
+  void offload(Fsession& session);
+
+  /// \brief delta: signatures are done (the m_sigworker fd is readable)
+  /// => the sessions reply with the Sigs & receive the contents.
+  ///
+  /// \param vdone - filled with the failed or finished sessions. (to be closed)
+  void sigs_done(std::vector<int>& vdone);
+
+  /// \brief finished session waits for the group commit. (Durability::BATCH)
+  void hold(int fd_con, Fsession const& session);
+
+  /// \brief milliseconds till the group commit is due.
+  ///
+  /// \return -1 if no session waits for it (or the flush is in flight),
+  ///         0 if it is due now.
+  [[nodiscard]] int group_timeout() const noexcept;
+
+  /// \brief start the flush of the storage once for the whole group
+  /// (syncfs(2) by the helper thread, shared by the workers) => the event loop
+  /// is not blocked. The m_fd_synced is signaled when it is done.
+  /// (group commit)
+  void group_commit();
+
+  /// \brief the flush of the group is done (m_fd_synced is readable)
+  /// => release the final replies of its sessions.
+  ///
+  /// \param vdone - filled with the finished sessions. (to be closed)
+  void group_synced(std::vector<int>& vdone);
 
   ////////////////////////////////////////////////////////////////
   /// following are the helper methods.
 
-  [[nodiscard]] std::string host_addr_ipv4() const noexcept;
+  [[nodiscard]] static std::string
+  host_addr_ipv4(struct sockaddr_in const& sa) noexcept;
 
   /// \brief make unique sub-dirs inside the root storage dir.
   /// (to differentiate the source of the files and store them separately).
+  /// Race-free: the same sub-dir may be created concurrently by the workers.
   ///
+  /// \param  peer - address of the peer, name of the sub-dir.
+  /// \param  dir  - on success contains path to the sub-storage dir.
   /// \return 0 on success - when all sub-dirs successfully created.
-  [[nodiscard]] rc mkdir_sub_storage();
+  [[nodiscard]] rc mkdir_sub_storage(std::string const& peer, fs::path& dir);
 
   /// \brief fill the sockaddr_in structure.
   [[nodiscard]] int fill_sockaddr_in();
 
-  /// \brief recv num_files_total, so that the server knows how many to expect.
-  ///
-  /// \return 0 on success.
-  [[nodiscard]] int recv_num_files_total();
-
-  /// \brief recv Finfo structure, with the file information.
-  ///
-  /// \param  i - Finfo index in the transfer queue.
-  /// \return 0 on success.
-  [[nodiscard]] int recv_file_info(size_t const i);
-
-  /// \brief recv File.
-  ///
-  /// \param  i - file index in the transfer queue.
-  /// \return 0 on success.
-  [[nodiscard]] int recv_file(size_t const i);
-
-  /// \brief man recv(2).
-  ///
-  /// \return  0 on success - when all bytes are received (finish).
-  /// \return -1 on error   - and errno msg is logged to indicate the error.
-  /// \return -2 on recv() -> 0 - orderly shutdown etc. ref: recv(2).
-  template <typename T = file::File::char_type>
-  [[nodiscard]] int recv_loop(int fd, void* buf, size_t len);
-
 private:
   /// initialized via explicit ctor
   port_t const m_port{};
+  bool const   m_reuseport{ false };
+  Engine       m_engine{ Engine::EPOLL };
 
   /// path to the storage dir. (root of the storage)
   fs::path const m_storage_dir;
 
-  /// sub-storage inside the storage (for incoming files)
-  /// see: mkdir_sub_storage() - overrides this variable.
-  fs::path m_storage_dir_sub{ m_storage_dir };
-
   /// The backlog defines the maximum length to which
   /// the queue of pending connections may grow. ref: listen(2)
-  int const m_backlog{ 1 };
+  int const m_backlog{ SOMAXCONN };
 
   /// reusable for the POSIX return codes
   int m_rc{ static_cast<int>(rc::INIT) };
 
-  /// file descriptor returned by the socket().
+  /// file descriptor returned by the socket(). (listening socket)
   /// -1 is the socket() return value on error. ref: socket(2)
   int m_fd{ -1 };
 
-  /// new fd (connected socket) returned by the accept().
-  /// -1 is the accept() return value on error. ref: accept(2)
-  int m_fd_con{ -1 };
+  /// reserved fd, given up to shed the connection. (see: shed_connection())
+  int m_fd_spare{ -1 };
+
+  /// eventfd(2) signaled by the stop(), watched by the event loop.
+  int m_fd_stop{ -1 };
 
-  size_t m_num_files_total{ 0 };
+  /// eventfd(2) signaled when the flush of the group is done (1: flushed,
+  /// 2: failed), watched by the event loop. (see: group_commit())
+  int m_fd_synced{ -1 };
 
   socklen_t m_addrlen{};
 
   struct sockaddr_in m_sockaddr_in{};
 
-  std::vector<file::File> m_vfiles;
+  Poller m_poller;
+
+  /// buffers of the worker, recycled between the sessions. (outlives them)
+  Bpool m_pool;
+
+  /// dedup indexes of the sub-storages. (outlives the sessions)
+  Hcache m_hcache;
+
+  /// active sessions by the connected socket fd.
+  std::unordered_map<int, std::unique_ptr<Fsession>> m_sessions;
+
+  /// reusable receive buffer shared between the sessions. (lazily allocated)
+  Buf m_buf;
+
+  /// delta signatures of the sessions & the ids of their jobs.
+  Sigworker m_sigworker;
+  u64       m_sigs_seq{ 0 };
+
+  /// connected sockets accepted since the last check. (Engine::URING only)
+  std::vector<int> m_vaccepted;
+
+  /// sessions with the replies partially sent by the sigs_done() or the
+  /// group_synced() => wait for the writability. (Engine::URING only)
+  std::vector<int> m_vwriting;
+
+  Durability m_durability{ Durability::NONE };
+
+  /// group commit: finished sessions waiting for the flush of the storage,
+  /// bytes of their files & the end of the time window of the group.
+  std::vector<int>                                     m_vgroup;
+  size_t                                               m_group_bytes{ 0 };
+  std::optional<std::chrono::steady_clock::time_point> m_group_due;
+
+  /// sessions of the group whose flush is in flight. (the next group waits)
+  std::vector<int> m_vsyncing;
+  bool             m_syncing{ false };
 };
 
 } // namespace wndx::mqlqd
@@ -0,0 +1,517 @@
+#pragma once
+/// file session (per-connection state of the file server).
+
+#include "aliases.hpp"
+
+#include "bpool.hpp"
+#include "codec.hpp"
+#include "file.hpp"
+#include "hindex.hpp"
+#include "proto.hpp"
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+extern "C" {
+
+#include <sys/types.h> // off_t
+
+} // extern "C"
+
+namespace wndx::mqlqd {
+
+/// \brief state of the file session (phases of the transfer protocol).
+enum class Sstate : u8
+{
+  DETECT,    // recv magic (v1) or the start of the num_files_total (legacy).
+  HELLO,     // recv Hello & reply with the HelloAck.
+  NUM_FILES, // recv num_files_total.
+  FINFO,     // recv Finfo structures (legacy) or Fhdr messages (v1).
+             // (pipelined: Fhdr of the next file or the end of the transfer)
+  SIGS,      // delta: signatures are computed off the event loop (the peer
+             // waits for the Sigs, nothing is expected from it).
+  PAYLOAD,   // recv contents of the files.
+  DONE,      // all files are received.
+};
+
+/// \brief write operation of the received file content. (deferred write)
+struct Wop
+{
+  int         fd{ -1 };
+  char const* data{ nullptr }; // points into the buffer passed to the feed().
+  size_t      len{ 0 };
+  off_t       off{ 0 }; // position in the destination file.
+};
+
+/// \brief delta: signatures of the old copies of the files of the session,
+/// computed off the event loop. (see: Fsession::take_sigs())
+struct Sjob
+{
+  int                       fd_con{ -1 };
+  u64                       id{ 0 }; // unique in the server. (fd is reused)
+  std::vector<fs::path>     vpaths;  // old copies of the files.
+  std::vector<proto::Fsigs> vfsigs;  // idx of the files => their signatures.
+
+  /// \brief compute the signatures (blocking). The Sigs reply is kept within
+  /// the proto::reply_max => files past it (or without the usable old copy)
+  /// are dropped, their contents are sent whole.
+  void run();
+};
+
+/// \brief when the received content is flushed to the stable storage.
+enum class Durability : u8
+{
+  NONE,  // by the kernel (file is still replaced atomically).
+  BATCH, // syncfs(2) of the storage once per the group of the finished
+         // sessions (group commit) before they are reported as received.
+  FILE,  // fdatasync(2) of each file & fsync(2) of its dir before it is
+         // reported as received.
+};
+
+/// \brief completely received file, committed to the storage (takes its
+/// final name) when its deferred writes are performed. (self-contained:
+/// the next transfer of the session may start meanwhile)
+struct Fdone
+{
+  int        fd{ -1 };
+  file::File file;                  // destination.
+  fs::path   tmp;                   // written file (empty: O_TMPFILE).
+  u64        hflags{ proto::hf_none };
+  u64        hash{ 0 };
+  size_t     seq{ 0 };              // number of the file in the session.
+  u64        idx{ 0 };              // index of the file in the Verdict.
+  off_t      off{ 0 };              // range: position in the file.
+  bool       keep{ true };          // false: writes failed => only closed.
+};
+
+class Fsession final
+{
+public:
+  Fsession()                           = delete;
+  Fsession(Fsession&&)                 = delete;
+  Fsession(Fsession const&)            = delete;
+  Fsession& operator=(Fsession&&)      = delete;
+  Fsession& operator=(Fsession const&) = delete;
+  ~Fsession() noexcept;
+
+  /// \brief take ownership of the connected (non-blocking) socket.
+  ///
+  /// \param fd_con      - connected socket returned by the accept().
+  /// \param peer        - address of the peer (for the log messages).
+  /// \param storage_dir - sub-storage dir of the peer (for incoming files).
+  /// \param pool        - buffers of the worker. (outlives the session)
+  /// \param hcache      - dedup indexes of the worker. (outlives the session)
+  explicit Fsession(int fd_con, std::string peer, fs::path storage_dir,
+                    Bpool& pool, Hcache& hcache) noexcept;
+
+  /// \brief recv available bytes into the buffer & advance the state machine.
+  ///
+  /// \param  buf - reusable receive buffer (shared between the sessions).
+  /// \return  0 on success - wait for the next readiness of the socket.
+  /// \return  1 on finish  - all files are received.
+  /// \return -1 on error   - and errno msg is logged to indicate the error.
+  /// \return -2 on recv() -> 0 - orderly shutdown before the finish.
+  [[nodiscard]] int on_readable(std::span<char> buf);
+
+  /// \brief send pending replies to the peer (e.g. the HelloAck).
+  ///
+  /// \return  0 on success - all sent or wait for the next writability.
+  /// \return  1 on finish  - all sent & all files are received.
+  /// \return -1 on error   - and errno msg is logged to indicate the error.
+  [[nodiscard]] int on_writable();
+
+  /// \brief there are pending replies => watch the socket for writability.
+  [[nodiscard]] bool want_write() const noexcept
+  {
+    return m_synced && m_out_off < m_out.size();
+  }
+
+  /// \brief all files of the transfer are received, but the final reply is
+  /// held till they are flushed by the group commit. (Durability::BATCH)
+  /// Durability::FILE: held till the deferred commits, by the writes_done().
+  [[nodiscard]] bool want_sync() const noexcept { return !m_synced; }
+
+  /// \brief files of the session are flushed => release the final reply.
+  void synced() noexcept
+  {
+    m_synced    = true;
+    m_committed = 0;
+  }
+
+  /// \brief bytes of the files committed to the storage since the last flush.
+  [[nodiscard]] size_t committed() const noexcept { return m_committed; }
+
+  /// \brief delta: signatures are to be computed off the event loop.
+  /// (take_sigs(), then sigs_done() when the job is done)
+  [[nodiscard]] bool want_sigs() const noexcept
+  {
+    return !m_sjob.vpaths.empty();
+  }
+
+  /// \param id - of the job, unique in the server.
+  [[nodiscard]] Sjob take_sigs(u64 id);
+
+  /// \brief id of the job the session waits for. (0 - none)
+  [[nodiscard]] u64 sigs_id() const noexcept { return m_sigs_id; }
+
+  /// \brief signatures are computed => reply with the Sigs & receive the
+  /// contents.
+  ///
+  /// \return 0 on success, -1 on error.
+  [[nodiscard]] int sigs_done(Sjob& job);
+
+  /// \brief finished, or waits for the next transfer of the long-lived
+  /// session => the peer may close the connection. (proto::fl_batches)
+  [[nodiscard]] bool idle() const noexcept;
+
+  /// \brief advance the state machine by the received bytes.
+  ///
+  /// \return 0 on success, -1 on error.
+  [[nodiscard]] int feed(char const* data, size_t len);
+
+  /// \brief switch to the deferred writes: feed() does not write the content
+  /// of the files by itself, but collects write operations into the wops().
+  /// The caller must perform them & call writes_done() before the next feed().
+  void set_deferred_writes(bool const deferred) noexcept
+  {
+    m_deferred = deferred;
+  }
+
+  void set_durability(Durability const durability) noexcept
+  {
+    m_durability = durability;
+  }
+
+  /// \brief deferred write operations collected by the last feed().
+  [[nodiscard]] std::vector<Wop>& wops() noexcept { return m_vwops; }
+
+  /// \brief all deferred write operations are performed
+  /// => commit & close the files which are completely written.
+  ///
+  /// \return 0 on success, -1 on error - a file is not committed.
+  [[nodiscard]] int writes_done() noexcept;
+
+  /// \brief some of the deferred write operations have failed => the files
+  /// completed meanwhile are not committed, but reported as bad by the
+  /// Verdict. (before the writes_done())
+  void writes_failed() noexcept;
+
+  [[nodiscard]] int fd() const noexcept { return m_fd_con; }
+
+  [[nodiscard]] Sstate state() const noexcept { return m_state; }
+
+  /// \brief negotiated version of the protocol. (0 - legacy)
+  [[nodiscard]] u8 version() const noexcept { return m_version; }
+
+protected:
+  /// \brief accumulate bytes of the fixed size header (may span many recv()).
+  ///
+  /// \return true when the header is complete. (in the m_hdr)
+  [[nodiscard]] bool take_hdr(char const*& data, size_t& len, size_t hdr_len);
+
+  /// \brief decode variable-length message (may span many recv()),
+  /// consumes only the bytes of the message.
+  ///
+  /// \param  decode - callable: (char const* p, size_t len, size_t& n) -> Pres.
+  /// \return result of the decoding. (Pres::BAD also when exceeds hdr_max)
+  template <typename Fn>
+  [[nodiscard]] proto::Pres take_msg(char const*& data, size_t& len,
+                                     Fn&& decode);
+
+  /// \brief handle complete magic / first bytes of the legacy session.
+  void on_detect();
+
+  /// \brief handle Hello: negotiate version & flags, queue the HelloAck.
+  [[nodiscard]] int on_hello(proto::Hello const& hello);
+
+  /// \brief handle complete Finfo header. (legacy)
+  [[nodiscard]] int on_finfo();
+
+  /// \brief add file to the transfer queue, start the payload after the last.
+  ///
+  /// \param name   - file name sent by the peer (only the filename is kept,
+  ///                 relative path of the file in the proto::fl_tree session).
+  /// \param hflags - per-file flags. (proto::hf_*)
+  /// \param hash   - hash of the content. (proto::hf_hash)
+  /// \param src    - identity of the source file. (proto::hf_src)
+  [[nodiscard]] int add_file(fs::path const& name, size_t size,
+                             u64 hflags = proto::hf_none, u64 hash = 0,
+                             u64 src = 0);
+
+  /// \brief open the next file for writing (skipping the empty files).
+  /// Sets state to DONE when there are no files left.
+  /// (pipelined: to FINFO - wait for the next header)
+  [[nodiscard]] int open_next_file();
+
+  /// \brief open the destination of the file. (the partial file if resumable)
+  [[nodiscard]] int open_file(file::File const& file);
+
+  /// \brief open the anonymous file in the dir of the file (O_TMPFILE),
+  /// or the named temporary file, if the file system does not support it.
+  /// (the file takes its final name only when it is complete)
+  ///
+  /// \param flags - access mode of the file. (O_WRONLY / O_RDWR)
+  /// \return file descriptor, -1 on error.
+  [[nodiscard]] int open_tmp(file::File const& file, int flags);
+
+  /// \brief path of the temporary file of the file in its dir.
+  ///
+  /// \param seq - number of the file in the session. (unique name)
+  [[nodiscard]] fs::path tmp_path(file::File const& file, size_t seq) const;
+
+  /// \brief reserve the space of the rest of the content at once.
+  /// (fewer extents, size of the file is not changed)
+  ///
+  /// \return 0 on success, -1 on error. (no space left)
+  [[nodiscard]] int preallocate(size_t len);
+
+  /// \brief open the destination of the range: the temporary file shared by
+  /// the ranges of the file (preallocated to the total size).
+  [[nodiscard]] int open_range(file::File const& file);
+
+  /// \brief current file is completely received => commit it (or defer).
+  [[nodiscard]] int finish_file();
+
+  /// \brief take the current file out of the session. (to be committed)
+  ///
+  /// \param keep - false: only closed. (e.g. discarded)
+  [[nodiscard]] Fdone take_file(bool keep);
+
+  /// \brief flush the written file (by the durability), atomically replace
+  /// the destination by it & close it.
+  ///
+  /// \return 0 on success, -1 on error. (destination is not replaced)
+  int commit_file(Fdone& done) noexcept;
+
+  /// \brief path of the partial file (kept between the sessions for resume).
+  ///
+  /// \param idx - index of the file in the transfer queue.
+  [[nodiscard]] fs::path part_path(size_t idx) const;
+
+  /// \brief offsets of the already received contents => reply with the Plan.
+  void make_plan();
+
+  /// \brief dedup: plan offset of the file by the index of the sub-storage.
+  ///
+  /// \return size of the file if the content is already stored (same name)
+  ///         or copied locally from the other stored file (into the partial).
+  /// \return 0 if the content must be sent.
+  [[nodiscard]] u64 dedup_plan(size_t idx);
+
+  /// \brief dedup: completely written file => add to the index.
+  void index_file(file::File const& file, u64 hash);
+
+  /// \brief all files are received => finish the session.
+  /// (long-lived session: wait for the next transfer)
+  void on_end();
+
+  /// \brief the files of the ended transfer are committed => the Verdict.
+  /// (deferred writes: by the writes_done())
+  void reply_end();
+
+  /// \brief forget the files of the finished transfer. (proto::fl_batches)
+  void next_batch();
+
+  [[nodiscard]] bool pipelined() const noexcept
+  {
+    return (m_flags & proto::fl_pipeline) != 0;
+  }
+
+  [[nodiscard]] bool resumable() const noexcept
+  {
+    return (m_flags & proto::fl_resume) != 0;
+  }
+
+  [[nodiscard]] bool dedup() const noexcept
+  {
+    return (m_flags & proto::fl_dedup) != 0;
+  }
+
+  [[nodiscard]] bool delta() const noexcept
+  {
+    return (m_flags & proto::fl_delta) != 0;
+  }
+
+  [[nodiscard]] bool crc() const noexcept
+  {
+    return (m_flags & proto::fl_crc) != 0;
+  }
+
+  [[nodiscard]] bool tree() const noexcept
+  {
+    return (m_flags & proto::fl_tree) != 0;
+  }
+
+  [[nodiscard]] bool batches() const noexcept
+  {
+    return (m_flags & proto::fl_batches) != 0;
+  }
+
+  [[nodiscard]] bool publish() const noexcept
+  {
+    return (m_flags & proto::fl_publish) != 0;
+  }
+
+  /// \brief write part of the file content into the currently opened file.
+  [[nodiscard]] int on_payload(char const*& data, size_t& len);
+
+  /// \brief content in the compressed blocks: decompress & write.
+  [[nodiscard]] int on_zpayload(char const*& data, size_t& len);
+
+  /// \brief content as the delta: write the literals & copy the blocks of
+  /// the old copy into the partial file.
+  [[nodiscard]] int on_dpayload(char const*& data, size_t& len);
+
+  /// \brief checksum of the content follows => verify it.
+  [[nodiscard]] int on_trailer(char const*& data, size_t& len);
+
+  /// \brief checksum of the current file did not match => discard it.
+  void discard_file();
+
+  /// \brief take the m_zout from the pool, if it is not taken yet.
+  ///
+  /// \return 0 on success.
+  [[nodiscard]] int zout();
+
+  /// \brief copy the block(s) of the old copy into the current file. (delta)
+  [[nodiscard]] int copy_basis(off_t off, size_t n);
+
+  /// \brief write raw content at the current position (or defer the write).
+  ///
+  /// \param stable - data outlives the feed() => the write may be deferred.
+  [[nodiscard]] int write_out(char const* data, size_t n, bool stable);
+
+  /// \brief current file is complete => proceed to the next one.
+  [[nodiscard]] int next_file();
+
+private:
+  /// connected socket (owned).
+  int m_fd_con{ -1 };
+
+  std::string const m_peer;
+
+  /// sub-storage inside the storage (for incoming files).
+  fs::path const m_storage_dir_sub;
+
+  /// buffers of the worker: session buffers are recycled by the next ones.
+  Bpool& m_pool;
+
+  /// dedup indexes of the worker: shared by the sessions of the sub-storage.
+  Hcache& m_hcache;
+
+  Sstate m_state{ Sstate::DETECT };
+
+  /// negotiated version of the protocol & flags of the session.
+  u8  m_version{ 0 };
+  u32 m_flags{ proto::fl_none };
+
+  /// identity of the client. (from the Hello)
+  std::string m_uid;
+
+  size_t m_num_files_total{ 0 };
+
+  /// index of the current file in the transfer queue.
+  size_t m_idx{ 0 };
+
+  /// pipelined: finished files dropped from the queue. (the file of the
+  /// m_idx is the m_base + m_idx one of the transfer)
+  size_t m_base{ 0 };
+
+  /// files opened by the session. (names of the temporary files)
+  size_t m_seq{ 0 };
+
+  /// accumulation buffer for the partially received header.
+  std::string m_hdr;
+
+  /// pending replies to the peer & position of the next byte to send.
+  std::string m_out;
+  size_t      m_out_off{ 0 };
+
+  std::vector<file::File> m_vfiles;
+
+  /// dir tree: the last dir of the files, which is known to exist.
+  fs::path m_dir_made;
+
+  /// resumable: offsets from which the contents are expected (the Plan) &
+  /// the saved checksums of the contents received before them. (fl_crc)
+  std::vector<u64> m_vplan;
+  std::vector<u32> m_vpart_crc;
+
+  /// per-file flags of the headers. (proto::hf_*)
+  std::vector<u64> m_vhflags;
+
+  /// resumable: identities of the sources of the files. (0 - unknown)
+  std::vector<u64> m_vsrc;
+
+  /// dedup: hashes of the contents, the stored files are already up to date
+  /// & the index of the sub-storage.
+  std::vector<u64> m_vhash;
+  std::vector<u8>  m_vhave;
+  Hindex*          m_index{ nullptr }; // owned by the m_hcache.
+
+  /// delta: job of the signatures (see: want_sigs()) & the one waited for.
+  Sjob m_sjob;
+  u64  m_sigs_id{ 0 };
+
+  /// delta: files sent as the delta & state of the current one.
+  std::vector<u8> m_vdelta;
+  bool            m_delta{ false };
+  bool            m_dhdr{ true }; // next is the Dop.
+  proto::Dop      m_dop{};        // current literal: m_dop.len bytes left.
+  int             m_fd_basis{ -1 }; // old copy of the file.
+  u64             m_basis_size{ 0 };
+
+  /// codec of the session & state of the current compressed content.
+  std::unique_ptr<codec::Codec> m_codec;
+  bool                          m_zframe{ false }; // content in blocks.
+  bool                          m_zhdr{ true };    // next is the Zblk.
+  proto::Zblk                   m_zblk{};
+  Buf                           m_zin; // partially received block.
+  size_t                        m_zin_len{ 0 };
+  Buf                           m_zout; // decompressed block.
+
+  /// checksum of the current content, its trailer is next
+  /// & the files which failed the verification. (reported by the Verdict)
+  u32              m_crc{ 0 };
+  bool             m_trailer{ false };
+  std::vector<u64> m_vbad;
+
+  /// ranges whose commit published the file (fl_publish) & the transfer
+  /// whose Verdict waits for the deferred commits. (number of its files)
+  std::vector<u64> m_vpub;
+  bool             m_end{ false };
+  size_t           m_end_files{ 0 };
+
+  /// destination file of the current payload & bytes left to receive.
+  /// (written as the temporary or the partial file m_tmp, if it is named)
+  int      m_fd_out{ -1 };
+  fs::path m_tmp;
+  size_t   m_left{ 0 };
+  off_t    m_off{ 0 }; // position of the next write in the destination file.
+
+  /// the next file is the range of the file. (proto::hf_range)
+  bool  m_range{ false };
+  off_t m_range_off{ 0 };
+  off_t m_range_total{ 0 };
+
+  /// temporary file of the current range & the ones written by the session.
+  fs::path                 m_range_tmp;
+  std::vector<std::string> m_vranged;
+
+  /// deferred writes (see: set_deferred_writes()).
+  bool             m_deferred{ false };
+  std::vector<Wop> m_vwops;
+
+  /// completely received files with the deferred writes still in flight.
+  std::vector<Fdone> m_vdone;
+
+  Durability m_durability{ Durability::NONE };
+
+  /// the final reply is released. (see: want_sync())
+  bool   m_synced{ true };
+  size_t m_committed{ 0 };
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,106 @@
+#pragma once
+/// persistent index of the content hashes of the stored files. (dedup)
+
+#include "aliases.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+
+namespace wndx::mqlqd {
+
+/// \brief content of the stored file at the moment of the indexing.
+struct Hentry
+{
+  u64 hash{ 0 };  // xxh64 of the content.
+  u64 size{ 0 };
+  u64 mtime{ 0 }; // ns => the entry is stale if the file is modified since.
+};
+
+/// \brief index of the sub-storage, kept in the append-only log file.
+/// Entries are never trusted blindly: size & mtime of the stored file are
+/// checked on every lookup => the file rewritten by other means is re-sent.
+/// Many sessions may append concurrently. (single write(2) per entry)
+class Hindex final
+{
+public:
+  Hindex()                         = delete;
+  Hindex(Hindex&&)                 = delete;
+  Hindex(Hindex const&)            = delete;
+  Hindex& operator=(Hindex&&)      = delete;
+  Hindex& operator=(Hindex const&) = delete;
+  ~Hindex() noexcept               = default;
+
+  /// \param dir - sub-storage dir with the indexed files.
+  explicit Hindex(fs::path dir) noexcept;
+
+  /// \brief read the log (the last entry of the file wins),
+  /// rewrite it when most of the entries are superseded.
+  /// Loaded again: only the entries appended since are read. (the whole log,
+  /// if it is rewritten meanwhile)
+  ///
+  /// \return  0 on success (or if there is no log yet).
+  /// \return -1 on error   - and errno msg is logged to indicate the error.
+  [[nodiscard]] int load();
+
+  /// \return true if the stored file has exactly this content.
+  [[nodiscard]] bool has(std::string const& name, u64 size, u64 hash) const;
+
+  /// \return name of any stored file with this content, empty if none.
+  [[nodiscard]] std::string find(u64 size, u64 hash) const;
+
+  /// \brief index the stored file & append the entry to the log.
+  ///
+  /// \return  0 on success.
+  /// \return -1 on error   - and errno msg is logged to indicate the error.
+  [[nodiscard]] int add(std::string const& name, u64 size, u64 hash);
+
+  /// \brief name of the log file inside of the sub-storage dir.
+  static constexpr sv_t log_name{ ".mqlqd.index" };
+
+protected:
+  /// \return true if the stored file is not modified since the indexing.
+  [[nodiscard]] bool fresh(std::string const& name, Hentry const& e) const;
+
+  /// \brief rewrite the log with only the current entries. (atomic rename)
+  [[nodiscard]] int compact();
+
+private:
+  fs::path const m_dir;
+  fs::path const m_path; // log file.
+
+  std::unordered_map<std::string, Hentry> m_map;     // by the file name.
+  std::unordered_map<u64, std::string>    m_by_hash; // last file with the hash.
+
+  size_t m_lines{ 0 }; // entries in the log. (incl. superseded)
+
+  /// bytes of the log read so far & its inode. (rewritten: the other one)
+  u64 m_loaded{ 0 };
+  u64 m_ino{ 0 };
+};
+
+/// \brief indexes of the sub-storages: the log of the dir is parsed by its
+/// first dedup session only, the next ones read the entries appended since.
+/// NOTE: not thread-safe => one cache per worker. (must outlive the sessions)
+class Hcache final
+{
+public:
+  Hcache(Hcache&&)                 = delete;
+  Hcache(Hcache const&)            = delete;
+  Hcache& operator=(Hcache&&)      = delete;
+  Hcache& operator=(Hcache const&) = delete;
+  ~Hcache() noexcept               = default;
+
+  Hcache() noexcept = default;
+
+  /// \brief index of the sub-storage dir, up to date with its log.
+  ///
+  /// \return nullptr on error. (not fatal: the contents are sent)
+  [[nodiscard]] Hindex* get(fs::path const& dir);
+
+private:
+  std::unordered_map<std::string, std::unique_ptr<Hindex>> m_indexes;
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,88 @@
+#pragma once
+/// thin wrappers over the POSIX I/O calls on the file descriptors.
+
+#include "aliases.hpp"
+
+extern "C" {
+
+#include <sys/types.h> // off_t
+
+} // extern "C"
+
+
+namespace wndx::mqlqd::io {
+
+/// \brief man close(2). close file descriptor & invalidate it (set to -1).
+///
+/// \param  fd   - file descriptor, ignored if not valid (< 0).
+/// \param  name - name of the file descriptor for the log messages.
+/// \return  0 on success (or if there was nothing to close).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+int close_fd(int& fd, sv_t const name) noexcept;
+
+/// \brief man write(2). write all bytes of the buffer.
+///
+/// \return  0 on success - when all bytes are written (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+[[nodiscard]] int write_loop(int fd, void const* buf, size_t len) noexcept;
+
+/// \brief man send(2). send all bytes of the buffer. (EPIPE, not the SIGPIPE)
+///
+/// \param flags - e.g. MSG_MORE: more is sent right after. (coalesced)
+/// \return  0 on success - when all bytes are sent (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+/// \return -2 on send() -> 0 - nothing to send etc.
+[[nodiscard]] int send_loop(int fd, void const* buf, size_t len,
+                            int flags = 0) noexcept;
+
+/// \brief man recv(2). recv exactly len bytes.
+///
+/// \return  0 on success - when all bytes are received (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+/// \return -2 on recv() -> 0 - orderly shutdown of the peer.
+[[nodiscard]] int recv_loop(int fd, void* buf, size_t len) noexcept;
+
+/// \brief man pwrite(2). write all bytes of the buffer at the file offset.
+///
+/// \return  0 on success - when all bytes are written (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+[[nodiscard]] int pwrite_loop(int fd, void const* buf, size_t len,
+                              off_t off) noexcept;
+
+/// \brief man pread(2). read exactly len bytes from the file offset.
+///
+/// \return  0 on success - when all bytes are read (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+/// \return -2 on pread() -> 0 - end of file before all bytes are read.
+[[nodiscard]] int pread_loop(int fd, void* buf, size_t len, off_t off) noexcept;
+
+/// \brief copy len bytes between the files at the offsets.
+/// (in the kernel via copy_file_range(2) if possible, e.g. reflink)
+///
+/// \return  0 on success - when all bytes are copied (finish).
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+/// \return -2 on end of the source file before all bytes are copied.
+[[nodiscard]] int copy_loop(int fd_in, off_t off_in, int fd_out, off_t off_out,
+                            size_t len) noexcept;
+
+/// \brief set O_NONBLOCK flag on the file descriptor. man fcntl(2).
+///
+/// \return  0 on success.
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+[[nodiscard]] int set_nonblock(int fd) noexcept;
+
+/// \brief enable the TCP keepalive probes of the idle connection, so that
+/// the dead peer is detected. (cfg::keepalive_*)
+///
+/// \return  0 on success.
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+[[nodiscard]] int set_keepalive(int fd) noexcept;
+
+/// \brief raise the soft limit of the open file descriptors up to the hard
+/// limit, so that the process may hold as many connections. man getrlimit(2).
+///
+/// \return the soft limit on success.
+/// \return -1 on error - and errno msg is logged to indicate the error.
+[[nodiscard]] long raise_nofile() noexcept;
+
+} // namespace wndx::mqlqd::io
@@ -0,0 +1,82 @@
+#pragma once
+/// readiness notification of the file descriptors (I/O event notification).
+/// epoll(7) on Linux, poll(2) on the other POSIX platforms.
+
+#include "aliases.hpp"
+
+#include <vector>
+
+extern "C" {
+
+#ifndef __linux__
+#include <poll.h> // poll(2)
+#endif // __linux__
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+/// poll event flags (platform independent).
+inline constexpr u32 pev_in{ 1U << 0U };  // available for read / accept.
+inline constexpr u32 pev_out{ 1U << 1U }; // available for write.
+inline constexpr u32 pev_err{ 1U << 2U }; // error condition.
+inline constexpr u32 pev_hup{ 1U << 3U }; // hang up.
+
+/// \brief fd which is ready & the poll event flags (pev_*) for it.
+struct Pevent
+{
+  int fd{ -1 };
+  u32 events{ 0 };
+};
+
+class Poller final
+{
+public:
+  Poller(Poller&&)                 = delete;
+  Poller(Poller const&)            = delete;
+  Poller& operator=(Poller&&)      = delete;
+  Poller& operator=(Poller const&) = delete;
+  ~Poller() noexcept;
+
+  Poller() noexcept = default;
+
+  /// \brief man epoll_create1(2).
+  ///
+  /// \return  0 on success.
+  /// \return -1 on error.
+  [[nodiscard]] int init();
+
+  /// \brief start watching fd for the events. man epoll_ctl(2).
+  ///
+  /// \param  fd     - file descriptor to watch.
+  /// \param  events - poll event flags (pev_*).
+  /// \return  0 on success.
+  /// \return -1 on error.
+  [[nodiscard]] int add(int fd, u32 events);
+
+  /// \brief change the events of the watched fd.
+  [[nodiscard]] int mod(int fd, u32 events);
+
+  /// \brief stop watching fd. (must be called before the close of the fd)
+  int del(int fd);
+
+  /// \brief wait for the events. man epoll_wait(2).
+  ///
+  /// \param  vpev       - filled with the ready fds (cleared beforehand).
+  /// \param  timeout_ms - -1 to wait indefinitely.
+  /// \return number of the ready fds, 0 on timeout or signal interruption.
+  /// \return -1 on error.
+  [[nodiscard]] int wait(std::vector<Pevent>& vpev, int timeout_ms);
+
+private:
+#ifdef __linux__
+  /// file descriptor referring to the epoll instance.
+  int m_epfd{ -1 };
+#else
+  /// watched fds, in the form required by the poll(2).
+  std::vector<struct pollfd> m_vpfd;
+#endif // __linux__
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,251 @@
+#pragma once
+/// wire protocol: versioned, packed, little-endian messages.
+///
+/// session (v1):
+///   client -> server : Hello   { magic u32 | version u8 | flags u32 | uid }
+///   server -> client : HelloAck{ magic u32 | version u8 | flags u32 }
+///   client -> server : num_files varint | Fhdr * num_files | contents...
+///   Fhdr             : { hflags varint | size varint | [range] | [hash] |
+///                        [src] | name }
+///   range (hf_range) : { offset varint | total varint }
+///   hash  (hf_hash)  : { xxh64 u64 } of the whole content of the file.
+///   src   (hf_src)   : { id u64 } of the source file (fl_src): changes when
+///                      the file is replaced or modified. (e.g. by the mtime)
+///
+/// compressed content (hf_zframe, session codec: fl_zstd or fl_lz4):
+///   (Zblk | bytes) * M, till the raw bytes of the file are complete.
+///   Zblk             : { raw varint | clen varint }
+///   (clen bytes of the compressed block or raw bytes when clen == 0)
+///
+/// resumable session (v1 + fl_resume, not pipelined):
+///   server -> client : Plan { len varint | count varint | offset varint * N }
+///   (after all Fhdr => client sends the contents starting from the offsets)
+///   deduplicated session (+ fl_dedup): offset == size of the file => server
+///   already has the same content (by the hash) => content is not sent.
+///   content received by the previous sessions is resumed only for the same
+///   source (+ fl_src), the session without the fl_src nor the fl_crc is not
+///   resumable. (the received content can not be verified)
+///
+/// delta session (+ fl_delta, with fl_resume):
+///   server -> client : Sigs { len varint | count varint | Fsigs * count }
+///   (after the Plan, for the files of which server has the old copy, within
+///   the reply_max => contents of the rest are sent whole)
+///   Fsigs            : { idx varint | block varint | n varint | Sig * n }
+///   Sig              : { weak u32 | strong u64 } of each full block
+///   content of such file is the sequence of the Dop till its size:
+///   Dop              : { op u8 | len varint | [off varint] }
+///   (literal: len bytes follow, copy: len bytes at off of the old copy)
+///
+/// checksummed session (+ fl_crc):
+///   content of each file (if any is sent) is followed by its checksum:
+///   crc32c u32 - of the whole content of the file (range: of the range),
+///                over the raw bytes. (decompressed / reconstructed delta)
+///   server -> client : Verdict { len varint | count varint | idx varint * N }
+///   (after all contents, the same encoding as the Plan) indexes of the files
+///   in the order of the headers whose checksum did not match => discarded.
+///
+/// pipelined session (v1 + fl_pipeline):
+///   client -> server : (Fhdr | content) * N | Fhdr{ hf_end }
+///   (each header is immediately followed by its content, no count upfront)
+///   range of the file: content is written at the offset of the temporary
+///   file preallocated to the total size => parts of the single file may
+///   arrive concurrently via many connections (streams). It takes the final
+///   name when all ranges are verified, the incomplete one is removed when
+///   no range of it arrived for cfg::range_stale seconds.
+///   confirmed ranges (+ fl_publish): Verdict follows each transfer (also
+///   without the fl_crc) & has the second list after the first one:
+///   Verdict { len varint | count varint | idx varint * N |
+///             count varint | idx varint * M }
+///   indexes of the ranges whose commit published the file (the last one
+///   verified => the file took its final name).
+/// long-lived session (+ fl_batches): after the end of the transfer (and its
+///   Verdict) the next transfer follows on the same connection, from the
+///   num_files (pipelined: the Fhdr) again. The transfer without files keeps
+///   the idle connection alive. Client closes the connection between them.
+/// directory tree (+ fl_tree): Fhdr name is the relative path of the file
+///   ('/' separated, e.g. "dir/sub/file"), else only its last component counts.
+/// strings are length-prefixed (varint) & not null-terminated.
+/// varint is LEB128 (7 bits per byte, least significant group first).
+///
+/// legacy session (v0) is recognized by the absence of the magic:
+///   num_files size_t | Finfo * num_files | contents... (host-endian)
+
+#include "aliases.hpp"
+
+#include <string>
+#include <vector>
+
+
+namespace wndx::mqlqd::proto {
+
+/// "MQLQ" in the little-endian byte order on the wire.
+inline constexpr u32 magic{ 0x514C514DU };
+
+/// latest version of the protocol supported by this build.
+inline constexpr u8 version{ 1 };
+
+/// session feature flags (requested by the client in the Hello,
+/// server replies with the subset which it supports in the HelloAck).
+inline constexpr u32 fl_none{ 0 };
+inline constexpr u32 fl_pipeline{ 1U << 0U }; // Fhdr & content interleaved.
+inline constexpr u32 fl_resume{ 1U << 1U };   // server replies with the Plan.
+inline constexpr u32 fl_zstd{ 1U << 2U };     // zstd compressed blocks.
+inline constexpr u32 fl_lz4{ 1U << 3U };      // lz4 compressed blocks.
+inline constexpr u32 fl_dedup{ 1U << 4U };    // hashes in Fhdr. (w/ fl_resume)
+inline constexpr u32 fl_delta{ 1U << 5U };    // Sigs & Dop. (w/ fl_resume)
+inline constexpr u32 fl_crc{ 1U << 6U };      // crc32c & the Verdict.
+inline constexpr u32 fl_tree{ 1U << 7U };     // names are relative paths.
+inline constexpr u32 fl_batches{ 1U << 8U };  // many transfers per session.
+inline constexpr u32 fl_src{ 1U << 9U };      // sources in Fhdr. (w/ fl_resume)
+inline constexpr u32 fl_publish{ 1U << 10U }; // published ranges in Verdict.
+
+/// features supported by this build.
+/// (codecs additionally depend on the libraries, see: codec::available())
+inline constexpr u32 fl_supported{ fl_pipeline | fl_resume | fl_zstd |
+                                   fl_lz4 | fl_dedup | fl_delta | fl_crc |
+                                   fl_tree | fl_batches | fl_src |
+                                   fl_publish };
+
+/// per-file flags (Fhdr::hflags).
+inline constexpr u64 hf_none{ 0 };
+inline constexpr u64 hf_end{ 1U << 0U };   // end of the transfer (no file).
+inline constexpr u64 hf_range{ 1U << 1U }; // part of the file. (pipelined)
+inline constexpr u64 hf_zframe{ 1U << 2U }; // content in compressed blocks.
+inline constexpr u64 hf_hash{ 1U << 3U };   // hash of the content. (dedup)
+inline constexpr u64 hf_src{ 1U << 4U };    // identity of the source file.
+
+/// max length of the file name (path) in the Fhdr.
+inline constexpr size_t name_max{ 4096 };
+
+/// max length of the client identity in the Hello.
+inline constexpr size_t uid_max{ 255 };
+
+/// max size of the single encoded message (Hello or Fhdr).
+inline constexpr size_t hdr_max{ name_max + 64 };
+
+/// max size of the length-prefixed reply of the server (e.g. Plan).
+inline constexpr size_t reply_max{ 64 * 1024 * 1024 };
+
+/// max size of the block of the delta signatures.
+inline constexpr u64 block_max{ 1024 * 1024 };
+
+/// size of the encoded HelloAck (fixed).
+inline constexpr size_t hello_ack_len{ 9 };
+
+/// max size of the encoded varint (u64).
+inline constexpr size_t varint_max{ 10 };
+
+/// \brief result of the decoding.
+enum class Pres : u8
+{
+  OK,   // decoded, number of the consumed bytes is returned.
+  MORE, // incomplete, need more bytes.
+  BAD,  // malformed message.
+};
+
+struct Hello
+{
+  u32         magic{ proto::magic };
+  u8          version{ proto::version };
+  u32         flags{ fl_none };
+  std::string uid;
+};
+
+/// \brief file header (variable-length replacement of the file::Finfo).
+struct Fhdr
+{
+  u64         hflags{ 0 }; // per-file flags (reserved).
+  u64         size{ 0 };   // size of the file content in bytes.
+  u64         offset{ 0 }; // hf_range: position of the content in the file.
+  u64         total{ 0 };  // hf_range: size of the whole file.
+  u64         hash{ 0 };   // hf_hash: xxh64 of the content.
+  u64         src{ 0 };    // hf_src: identity of the source file. (resume)
+  std::string name;
+};
+
+/// \brief header of the block of the compressed content.
+struct Zblk
+{
+  u64 raw{ 0 };  // number of the raw (decompressed) bytes.
+  u64 clen{ 0 }; // number of the compressed bytes, 0 - raw bytes follow.
+};
+
+/// \brief signature of the block of the old copy of the file. (delta)
+struct Sig
+{
+  u32 weak{ 0 };   // rolling checksum.
+  u64 strong{ 0 }; // xxh64.
+};
+
+/// \brief signatures of the old copy of the file (by the index in the Plan).
+struct Fsigs
+{
+  u64              idx{ 0 };
+  u64              block{ 0 };
+  std::vector<Sig> vsig;
+};
+
+/// \brief operation of the delta content.
+enum class Dkind : u8
+{
+  LITERAL, // len bytes follow.
+  COPY,    // len bytes at the off of the old copy.
+};
+
+struct Dop
+{
+  Dkind kind{ Dkind::LITERAL };
+  u64   len{ 0 };
+  u64   off{ 0 }; // COPY only.
+};
+
+void put_u8(std::string& out, u8 v);
+void put_u32le(std::string& out, u32 v);
+void put_u64le(std::string& out, u64 v);
+void put_varint(std::string& out, u64 v);
+void put_str(std::string& out, sv_t s);
+
+/// \brief decoders: on Pres::OK - n is the number of the consumed bytes.
+[[nodiscard]] Pres get_u8(char const* p, size_t len, u8& v, size_t& n);
+[[nodiscard]] Pres get_u32le(char const* p, size_t len, u32& v, size_t& n);
+[[nodiscard]] Pres get_u64le(char const* p, size_t len, u64& v, size_t& n);
+[[nodiscard]] Pres get_varint(char const* p, size_t len, u64& v, size_t& n);
+[[nodiscard]] Pres get_str(char const* p, size_t len, size_t max,
+                           std::string& s, size_t& n);
+
+void encode(std::string& out, Hello const& h);
+void encode(std::string& out, Fhdr const& h);
+void encode(std::string& out, Zblk const& h);
+void encode(std::string& out, Dop const& h);
+/// \brief Sigs: length-prefixed, the same as the Plan.
+void encode_sigs(std::string& out, std::vector<Fsigs> const& vfsigs);
+/// \brief Plan: per file offset from which the content is expected.
+void encode_plan(std::string& out, std::vector<u64> const& voff);
+/// \brief Verdict: indexes of the files with the mismatched checksum.
+void encode_verdict(std::string& out, std::vector<u64> const& vidx);
+/// \brief Verdict (+ fl_publish): also the indexes of the published ranges.
+void encode_verdict(std::string& out, std::vector<u64> const& vidx,
+                    std::vector<u64> const& vpub);
+/// \brief HelloAck has the same fields as the Hello, except the uid.
+void encode_ack(std::string& out, Hello const& h);
+
+[[nodiscard]] Pres decode(char const* p, size_t len, Hello& h, size_t& n);
+[[nodiscard]] Pres decode(char const* p, size_t len, Fhdr& h, size_t& n);
+[[nodiscard]] Pres decode_ack(char const* p, size_t len, Hello& h, size_t& n);
+[[nodiscard]] Pres decode(char const* p, size_t len, Zblk& h, size_t& n);
+[[nodiscard]] Pres decode(char const* p, size_t len, Dop& h, size_t& n);
+/// \brief decode body of the Sigs. (without the length prefix)
+[[nodiscard]] Pres decode_sigs(char const* p, size_t len,
+                               std::vector<Fsigs>& vfsigs);
+/// \brief decode body of the Plan. (without the length prefix)
+[[nodiscard]] Pres decode_plan(char const* p, size_t len,
+                               std::vector<u64>& voff);
+/// \brief decode body of the Verdict. (without the length prefix)
+[[nodiscard]] Pres decode_verdict(char const* p, size_t len,
+                                  std::vector<u64>& vidx);
+/// \brief decode body of the Verdict with the published ranges. (fl_publish)
+[[nodiscard]] Pres decode_verdict(char const* p, size_t len,
+                                  std::vector<u64>& vidx,
+                                  std::vector<u64>& vpub);
+
+} // namespace wndx::mqlqd::proto
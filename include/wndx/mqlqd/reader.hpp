@@ -0,0 +1,93 @@
+#pragma once
+/// read-ahead of the file contents. (client --max-inflight-bytes)
+
+#include "aliases.hpp"
+
+#include "file.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+/// \brief chunk of the file content, read ahead of the send.
+struct Rchunk
+{
+  file::File const* file{ nullptr };
+  size_t            off{ 0 }; // position in the file.
+  size_t            len{ 0 };
+  char const*       data{ nullptr };
+};
+
+/// \brief threads read the queued contents from the disk into the ring of
+/// the fixed-size buffers, while the sender drains the ring to the socket
+/// => memory is bounded by the ring & disk I/O overlaps with network I/O.
+/// Contents are queued & taken in the order of the sends.
+class Reader final
+{
+public:
+  Reader()                         = delete;
+  Reader(Reader&&)                 = delete;
+  Reader(Reader const&)            = delete;
+  Reader& operator=(Reader&&)      = delete;
+  Reader& operator=(Reader const&) = delete;
+  ~Reader() noexcept;
+
+  /// \param budget  - max bytes read & not sent yet. (at least 2 chunks)
+  /// \param threads - number of the reading threads.
+  explicit Reader(size_t budget, unsigned threads);
+
+  /// \brief queue the content to be read. (files must outlive the Reader)
+  void add(file::File const& file, size_t off, size_t len);
+
+  /// \brief wait for the next chunk of the queued contents.
+  ///
+  /// \param file - expected file. (the order of the sends)
+  /// \param off  - expected position in the file.
+  /// \return  0 on success.
+  /// \return -1 on error - read error, or the chunk is not the expected one.
+  /// \return -2 on end of file before all bytes are read. (truncated)
+  [[nodiscard]] int next(file::File const& file, size_t off, Rchunk& chunk);
+
+  /// \brief the chunk taken by the next() is sent => its buffer is reused.
+  void release() noexcept;
+
+private:
+  enum class Rstate : u8
+  {
+    FREE,    // buffer can be filled.
+    READING, // claimed by the reading thread.
+    READY,   // filled, waits for the sender.
+  };
+
+  struct Rslot
+  {
+    std::vector<char> buf;
+    Rchunk            chunk;
+    Rstate            state{ Rstate::FREE };
+    int               err{ 0 };
+  };
+
+  /// \brief reading thread: fill the buffers in the order of the chunks.
+  void run();
+
+  /// \brief claim the next chunk of the queued contents. (locked)
+  void claim(Rslot& slot);
+
+  std::vector<Rslot>      m_vslots; // ring: chunk N is in the slot N % size.
+  std::deque<Rchunk>      m_jobs;   // contents not claimed yet.
+  size_t                  m_claimed{ 0 };
+  size_t                  m_taken{ 0 };
+  bool                    m_stop{ false };
+  std::mutex              m_mtx;
+  std::condition_variable m_cv_read; // buffer freed / content queued.
+  std::condition_variable m_cv_sent; // buffer filled.
+
+  std::vector<std::jthread> m_vthreads;
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,102 @@
+#pragma once
+/// parallel walker of the directory trees. (client --recursive)
+
+#include "aliases.hpp"
+
+#include "file.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+/// \brief directory to scan.
+struct Wtask
+{
+  fs::path dir;
+  fs::path rel; // relative path of the dir on the receiving side.
+};
+
+/// \brief each thread scans the dirs from its own queue & pushes the found
+/// sub-dirs into it, idle threads steal the dirs from the queues of the others.
+/// Found files are streamed to the consumer while the walk goes on.
+class Walker final
+{
+public:
+  Walker()                         = delete;
+  Walker(Walker&&)                 = delete;
+  Walker(Walker const&)            = delete;
+  Walker& operator=(Walker&&)      = delete;
+  Walker& operator=(Walker const&) = delete;
+  ~Walker() noexcept;
+
+  /// \param threads - number of the walker threads. (0 - by the CPUs)
+  explicit Walker(unsigned threads) noexcept;
+
+  /// \brief start the walk (returns right away).
+  /// roots which are not dirs are found files themselves, files of the dir
+  /// are named by the path relative to the parent of the dir. (e.g. "dir/a")
+  /// symlinks are never followed, other non-regular files are skipped.
+  void walk(std::vector<fs::path> const& vroots);
+
+  /// \brief wait for the next found files & append them.
+  ///
+  /// \return false when the walk is finished & all found files are taken.
+  [[nodiscard]] bool next(std::deque<file::File>& vfiles);
+
+  /// \brief number of the paths which could not be walked. (logged)
+  [[nodiscard]] size_t errors() const noexcept { return m_errors.load(); }
+
+protected:
+  /// \brief walker thread: scan the dirs till there are no dirs left.
+  void run(size_t id);
+
+  /// \brief take the dir from the own queue (newest) or steal (oldest).
+  [[nodiscard]] bool take(size_t id, Wtask& task);
+
+  /// \brief read the entries of the dir: sub-dirs are queued, files found.
+  void scan(size_t id, Wtask const& task, std::vector<char>& buf,
+            std::vector<file::File>& vfound);
+
+  /// \brief hand over the found files to the consumer.
+  void found(std::vector<file::File>& vfound);
+
+  /// \brief wake the idle threads: the dir is queued, or the walk is over.
+  void wake(bool all) noexcept;
+
+private:
+  struct Wqueue
+  {
+    std::mutex        mtx;
+    std::deque<Wtask> tasks;
+  };
+
+  unsigned const                       m_threads{ 0 };
+  std::vector<std::unique_ptr<Wqueue>> m_vqueues;
+
+  /// dirs queued or being scanned => the walk is finished at 0.
+  std::atomic<size_t> m_pending{ 0 };
+  /// dirs queued only & the threads waiting for them. (see: wake())
+  std::atomic<size_t>   m_queued{ 0 };
+  std::atomic<unsigned> m_idle{ 0 };
+  std::atomic<size_t> m_errors{ 0 };
+  std::atomic<bool>   m_stop{ false }; // consumer is gone.
+
+  /// found files not taken by the consumer yet.
+  std::mutex              m_mtx;
+  std::condition_variable m_cv;
+  std::condition_variable m_cv_idle; // idle threads. (by the same m_mtx)
+  std::vector<file::File> m_vfound;
+  size_t                  m_nfound{ 0 };
+  unsigned                m_running{ 0 };
+
+  std::vector<std::jthread> m_vthreads;
+};
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,40 @@
+#pragma once
+/// XXH64 - fast non-cryptographic hash of the file content. (dedup)
+/// compatible with the reference implementation: https://github.com/Cyan4973/xxHash
+
+#include "aliases.hpp"
+
+#include <array>
+
+
+namespace wndx::mqlqd {
+
+/// \brief streaming XXH64: content may be fed in the pieces of any size.
+class Xxh64 final
+{
+public:
+  Xxh64(Xxh64&&)                 = delete;
+  Xxh64(Xxh64 const&)            = delete;
+  Xxh64& operator=(Xxh64&&)      = delete;
+  Xxh64& operator=(Xxh64 const&) = delete;
+  ~Xxh64() noexcept              = default;
+
+  explicit Xxh64(u64 seed = 0) noexcept;
+
+  void update(char const* data, size_t len) noexcept;
+
+  /// \return hash of all bytes fed so far. (state is not modified)
+  [[nodiscard]] u64 digest() const noexcept;
+
+private:
+  std::array<u64, 4>   m_acc{};
+  std::array<char, 32> m_buf{}; // incomplete stripe.
+  size_t               m_buf_len{ 0 };
+  u64                  m_total{ 0 };
+  u64                  m_seed{ 0 };
+};
+
+/// \brief one-shot XXH64 of the buffer.
+[[nodiscard]] u64 xxh64(char const* data, size_t len, u64 seed = 0) noexcept;
+
+} // namespace wndx::mqlqd
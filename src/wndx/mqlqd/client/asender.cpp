@@ -0,0 +1,280 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/asender.hpp"
+
+#include "wndx/mqlqd/file.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <utility>
+
+extern "C" {
+
+#include <sys/stat.h> // stat(2)
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// \brief failure of the connection => worth to reconnect.
+[[nodiscard]] bool retryable(rc const code) noexcept
+{
+  return code == rc::UNIX_SOCK_CONN_ERRO || code == rc::UNIX_SOCK_SEND_ERRO ||
+         code == rc::UNIX_SOCK_RECV_ERRO;
+}
+
+/// \brief size of the regular file at the path. (the content is read in
+/// chunks by the Fclient while it is sent, never held whole in memory)
+///
+/// \return 0 on success, -1 on error (errno is logged).
+[[nodiscard]] int stat_file(fs::path const& fpath, size_t& size)
+{
+  struct stat st{};
+  if (stat(fpath.c_str(), &st) == -1) {
+    log_g.errnum(errno, fmt::format("[FAIL] Asender stat() : {}", fpath));
+    return -1;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    WNDX_LOG(LL::ERRO, "[FAIL] Asender - not a regular file : {}\n", fpath);
+    return -1;
+  }
+  size = static_cast<size_t>(st.st_size);
+  return 0;
+}
+
+/// \brief completion fulfilling the promise of the future.
+[[nodiscard]] Adone promised(std::future<rc>& future)
+{
+  auto promise{ std::make_shared<std::promise<rc>>() };
+  future = promise->get_future();
+  return [promise](rc const code) { promise->set_value(code); };
+}
+
+} // namespace
+
+Asender::Asender(addr_t addr, port_t const port, u32 const flags,
+                 codec::Ctype const ctype, int const level)
+    : m_addr{ std::move(addr) }
+    , m_port{ port }
+    , m_flags{ (flags & (proto::fl_crc | proto::fl_tree)) |
+               proto::fl_pipeline | proto::fl_batches }
+    , m_ctype{ ctype }
+    , m_level{ level }
+    , m_thread{ [this] { run(); } }
+{
+}
+
+Asender::~Asender() noexcept
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_stop = true;
+  }
+  m_cv_queue.notify_all();
+  m_thread.join();
+}
+
+void Asender::send(fs::path fpath, Adone done)
+{
+  std::error_code ec;
+  size_t const    size{ fs::file_size(fpath, ec) }; // 0 - failed by the batch.
+  push({ .path    = std::move(fpath),
+         .content = {},
+         .owned   = {},
+         .size    = ec ? 0 : size,
+         .mem     = false,
+         .done    = std::move(done) });
+}
+
+[[nodiscard]] std::future<rc> Asender::send(fs::path fpath)
+{
+  std::future<rc> future;
+  send(std::move(fpath), promised(future));
+  return future;
+}
+
+void Asender::send(fs::path name, std::span<char const> const content,
+                   Adone done)
+{
+  push({ .path    = std::move(name),
+         .content = content,
+         .owned   = {},
+         .size    = content.size(),
+         .mem     = true,
+         .done    = std::move(done) });
+}
+
+[[nodiscard]] std::future<rc> Asender::send(fs::path                    name,
+                                            std::span<char const> const content)
+{
+  std::future<rc> future;
+  send(std::move(name), content, promised(future));
+  return future;
+}
+
+void Asender::send(fs::path name, std::vector<char>&& content, Adone done)
+{
+  size_t const size{ content.size() };
+  push({ .path    = std::move(name),
+         .content = {},
+         .owned   = std::move(content),
+         .size    = size,
+         .mem     = true,
+         .done    = std::move(done) });
+}
+
+[[nodiscard]] std::future<rc> Asender::send(fs::path            name,
+                                            std::vector<char>&& content)
+{
+  std::future<rc> future;
+  send(std::move(name), std::move(content), promised(future));
+  return future;
+}
+
+void Asender::flush()
+{
+  std::unique_lock lock{ m_mtx };
+  m_cv_idle.wait(lock, [this] { return m_queue.empty() && m_busy == 0; });
+}
+
+void Asender::push(Aitem&& item)
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_queue.push_back(std::move(item));
+  }
+  m_cv_queue.notify_one();
+}
+
+void Asender::run()
+{
+  std::unique_lock lock{ m_mtx };
+  while (true) {
+    bool const queued{ m_cv_queue.wait_for(
+        lock, std::chrono::seconds(cfg::watch_ping),
+        [this] { return m_stop || !m_queue.empty(); }) };
+    if (!queued) { // idle => keep the connection alive.
+      lock.unlock();
+      if (m_fclient && m_fclient->keepalive() != rc::SUCCESS) {
+        m_fclient.reset(); // reconnected by the next batch.
+      }
+      lock.lock();
+      continue;
+    }
+    if (m_queue.empty()) { // stopped & everything is sent.
+      break;
+    }
+    // the batch: all queued ones (up to batch_iov_max files and about
+    // asender_batch_bytes, at least one), queued meanwhile it is sent => the
+    // next one.
+    std::vector<Aitem> vitems;
+    size_t             bytes{ 0 };
+    while (!m_queue.empty() && vitems.size() < cfg::batch_iov_max &&
+           (vitems.empty() || bytes + m_queue.front().size <=
+                                  cfg::asender_batch_bytes))
+    {
+      bytes += m_queue.front().size;
+      vitems.push_back(std::move(m_queue.front()));
+      m_queue.pop_front();
+    }
+    m_busy = vitems.size();
+    lock.unlock();
+    send_batch(vitems);
+    lock.lock();
+    m_busy = 0;
+    m_cv_idle.notify_all();
+  }
+}
+
+void Asender::send_batch(std::vector<Aitem>& vitems)
+{
+  std::vector<rc>         vrc(vitems.size(), rc::FAILURE);
+  std::vector<file::File> vfiles;
+  std::vector<size_t>     vidx; // item of the file.
+  vfiles.reserve(vitems.size());
+  vidx.reserve(vitems.size());
+  for (size_t i = 0; i < vitems.size(); ++i) {
+    Aitem& item{ vitems[i] };
+    if (item.mem) {
+      std::span<char const> const content{
+        item.owned.empty() ? item.content : std::span{ item.owned }
+      };
+      vfiles.emplace_back(item.path, content.size(), item.path)
+          .view(content.data());
+    } else {
+      size_t size{ 0 };
+      if (stat_file(item.path, size) != 0) {
+        continue; // e.g. removed meanwhile => only this one fails.
+      }
+      vfiles.emplace_back(item.path, size); // read in chunks while sent.
+    }
+    vidx.push_back(i);
+  }
+
+  if (!vfiles.empty()) {
+    std::vector<u64> vbad;
+    rc const         res{ transfer(vfiles, vbad) };
+    for (size_t const i : vidx) {
+      vrc[i] = res == rc::FAILURE && !vbad.empty() ? rc::SUCCESS : res;
+    }
+    for (u64 const idx : vbad) { // only the discarded ones have failed.
+      vrc[vidx[idx]] = rc::FAILURE;
+    }
+  }
+  for (size_t i = 0; i < vitems.size(); ++i) {
+    if (vitems[i].done) {
+      vitems[i].done(vrc[i]);
+    }
+  }
+}
+
+[[nodiscard]] rc Asender::transfer(std::vector<file::File> const& vfiles,
+                                   std::vector<u64>&              vbad)
+{
+  // connection idle since the last batch may turn out to be broken only now
+  // (e.g. the server was restarted) => reconnected once.
+  bool const reused{ m_fclient != nullptr };
+  for (unsigned attempt = 0;; ++attempt) {
+    rc res{ m_fclient ? rc::SUCCESS : connect() };
+    if (res == rc::SUCCESS) {
+      res = m_fclient->send_files(vfiles);
+      if (res == rc::FAILURE) {
+        vbad = m_fclient->bad();
+      }
+    }
+    if (retryable(res)) {
+      m_fclient.reset();
+    }
+    if (!retryable(res) || !reused || attempt > 0) {
+      return res;
+    }
+    WNDX_LOG(LL::WARN, "{} : Asender reconnects\n", res);
+  }
+}
+
+[[nodiscard]] rc Asender::connect()
+{
+  // queued files are read in chunks at send time (never held whole), the
+  // contents in memory are referenced by the batches.
+  m_fclient = std::make_unique<Fclient>(m_addr, m_port, Tmode::CHUNKED);
+  m_fclient->set_compression(m_ctype, m_level);
+  rc const res{ m_fclient->init(m_flags) };
+  if (res != rc::SUCCESS) {
+    m_fclient.reset();
+    return res;
+  }
+  u32 const required{ proto::fl_pipeline | proto::fl_batches |
+                      (m_flags & proto::fl_tree) };
+  if ((m_fclient->flags() & required) != required) {
+    WNDX_LOG(LL::ERRO, "[FAIL] server does not support the Asender\n");
+    m_fclient.reset();
+    return rc::FAILURE;
+  }
+  return rc::SUCCESS;
+}
+
+} // namespace wndx::mqlqd
@@ -4,16 +4,34 @@
 
 #include "wndx/mqlqd/fclient.hpp"
 
+#include "wndx/mqlqd/codec.hpp"
 #include "wndx/mqlqd/config.hpp"
 #include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/proto.hpp"
+#include "wndx/mqlqd/walker.hpp"
 
 #include <cxxopts.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <deque>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
+extern "C" {
+
+#include <poll.h>   // poll(2)
+#include <unistd.h> // read(2), access(2), STDIN_FILENO
+
+} // extern "C"
+
 
 // clang-format off
 /// catch all possible exceptions (like Pokemon's)
@@ -26,6 +44,406 @@
 
 namespace wndx::mqlqd {
 
+namespace {
+
+/// \brief options of the sessions: requested compression of the file contents
+/// & the memory budget of the read-ahead. (0 - contents are not read ahead)
+struct Sopts
+{
+  codec::Ctype ctype{ codec::Ctype::NONE };
+  int          level{ cfg::zstd_level };
+  size_t       inflight{ 0 };
+};
+
+/// \brief the features without which the transfer is wrong are accepted.
+[[nodiscard]] bool required(Fclient const& fclient, u32 const flags) noexcept
+{
+  if ((flags & proto::fl_tree) != 0 && (fclient.flags() & proto::fl_tree) == 0)
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] server does not support the dir trees\n");
+    return false;
+  }
+  return true;
+}
+
+/// \brief keep only the files by the indexes. (e.g. to be sent again)
+void keep_files(std::vector<file::File>& vfiles, std::vector<u64> const& vidx)
+{
+  std::vector<file::File> vkeep;
+  vkeep.reserve(vidx.size());
+  for (u64 const idx : vidx) {
+    vkeep.push_back(std::move(vfiles.at(idx)));
+  }
+  vfiles = std::move(vkeep);
+}
+
+/// \brief split the large files into (chunk aligned) ranges, one per stream.
+[[nodiscard]] std::vector<std::vector<Frange>>
+split_ranges(std::vector<file::File> const& vlarge, unsigned const streams)
+{
+  std::vector<std::vector<Frange>> vvranges(streams);
+  for (auto const& file : vlarge) {
+    size_t part{ (file.size() + streams - 1) / streams };
+    part = (part + cfg::chunk_size - 1) / cfg::chunk_size * cfg::chunk_size;
+    size_t off{ 0 };
+    for (unsigned i = 0; off < file.size(); ++i) {
+      size_t const len{ std::min(part, file.size() - off) };
+      vvranges[i].push_back({ &file, off, len });
+      off += len;
+    }
+  }
+  return vvranges;
+}
+
+/// \brief send files via many connections concurrently (one per thread):
+/// small files are sent by the first stream, large files are split into
+/// ranges => each stream sends own range of every large file. Files & ranges
+/// discarded by the server (checksum) are sent again by the same connection,
+/// up to retries times. (the file takes its name when all ranges are verified)
+/// The large file is sent only when the server confirms that one of its
+/// ranges published it. (proto::fl_publish)
+///
+/// \return 0 on success, else fail code of the first failed stream.
+[[nodiscard]] rc send_streams(addr_t const& addr, port_t const port,
+                              Tmode const                    tmode,
+                              Sopts const&                   sopts,
+                              u32 const                      flags,
+                              std::vector<file::File> const& vfiles,
+                              unsigned const                 streams,
+                              unsigned const                 retries)
+{
+  std::vector<file::File> vsmall;
+  std::vector<file::File> vlarge;
+  for (auto const& file : vfiles) { // content is not in memory => cheap.
+    (file.size() < cfg::stream_file_min ? vsmall : vlarge)
+        .emplace_back(file.path(), file.size(), file.name());
+  }
+  std::vector<std::vector<Frange>> const vvranges{ split_ranges(vlarge,
+                                                                streams) };
+  // long-lived session => discarded ones are resent by the same connection.
+  u32 const fl_retry{ retries > 0 ? proto::fl_batches : proto::fl_none };
+  u32 const fl_ranges{ vlarge.empty() ? proto::fl_none : proto::fl_publish };
+  std::vector<rc> vrc(streams, rc::INIT);
+  // large files published by the ranges of each stream.
+  std::vector<std::vector<file::File const*>> vvpub(streams);
+  auto const      run_stream{ [&](unsigned const i) {
+    Fclient fclient{ addr, port, tmode };
+    fclient.set_compression(sopts.ctype, sopts.level);
+    fclient.set_readahead(sopts.inflight / streams); // shared budget.
+    vrc[i] = fclient.init(flags | fl_retry | fl_ranges);
+    if (vrc[i] != rc::SUCCESS) {
+      return;
+    }
+    if ((fclient.flags() & fl_ranges) != fl_ranges) {
+      WNDX_LOG(LL::ERRO, "[FAIL] server does not confirm the ranges\n");
+      vrc[i] = rc::FAILURE;
+      return;
+    }
+    if ((fclient.flags() & proto::fl_pipeline) == 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] server does not support the ranges\n");
+      vrc[i] = rc::FAILURE;
+      return;
+    }
+    if (!required(fclient, flags)) {
+      vrc[i] = rc::FAILURE;
+      return;
+    }
+    std::vector<file::File> vsend;
+    if (i == 0) {
+      for (auto const& file : vsmall) {
+        vsend.emplace_back(file.path(), file.size(), file.name());
+      }
+    }
+    std::vector<Frange> vranges{ vvranges[i] };
+    for (unsigned attempt = 0;; ++attempt) {
+      vrc[i] = fclient.send_files(vsend, vranges);
+      for (u64 const idx : fclient.published()) {
+        if (idx >= vsend.size()) {
+          vvpub[i].push_back(vranges.at(idx - vsend.size()).file);
+        }
+      }
+      std::vector<u64> const vbad{ fclient.bad() };
+      if (vrc[i] == rc::SUCCESS || vbad.empty() || attempt == retries ||
+          (fclient.flags() & proto::fl_batches) == 0)
+      {
+        return;
+      }
+      // verdict indexes: the files first, then the ranges.
+      std::vector<u64>    vbad_files;
+      std::vector<Frange> vbad_ranges;
+      for (u64 const idx : vbad) {
+        if (idx < vsend.size()) {
+          vbad_files.push_back(idx);
+        } else {
+          vbad_ranges.push_back(vranges.at(idx - vsend.size()));
+        }
+      }
+      keep_files(vsend, vbad_files);
+      vranges = std::move(vbad_ranges);
+      WNDX_LOG(LL::WARN, "{} : stream {} retry {}/{} of {} files, {} ranges\n",
+               vrc[i], i, attempt + 1, retries, vsend.size(), vranges.size());
+    }
+  } };
+  {
+    std::vector<std::jthread> vthreads;
+    vthreads.reserve(streams - 1);
+    for (unsigned i = 1; i < streams; ++i) {
+      vthreads.emplace_back(run_stream, i);
+    }
+    run_stream(0); // main thread is the first stream.
+  }
+  for (auto const src : vrc) {
+    if (src != rc::SUCCESS) {
+      return src;
+    }
+  }
+  for (auto const& file : vlarge) {
+    bool const pub{ std::any_of(vvpub.begin(), vvpub.end(),
+                                [&file](auto const& vpub) {
+                                  return std::find(vpub.begin(), vpub.end(),
+                                                   &file) != vpub.end();
+                                }) };
+    if (!pub) {
+      WNDX_LOG(LL::ERRO, "[FAIL] file is not published by the server : {}\n",
+               file);
+      return rc::FAILURE;
+    }
+  }
+  return rc::SUCCESS;
+}
+
+/// \brief transfer of the files by the initialized client.
+///
+/// \param  vbad - indexes of the files discarded by the server. (checksum)
+/// \return 0 on success, else return fail code of the underlying functions.
+[[nodiscard]] rc send_transfer(Fclient&                       fclient,
+                               std::vector<file::File> const& vfiles,
+                               std::vector<u64>&              vbad)
+{
+  /// attempt to send info of the upcoming transmission of the files.
+  /// (pipelined: headers are sent along with the files)
+  if ((fclient.flags() & proto::fl_pipeline) == 0) {
+    rc const rc{ fclient.send_files_info(vfiles) };
+    if (rc != rc::SUCCESS) {
+      return rc;
+    }
+  }
+
+  /// server is ready to accept provided files => start sending files.
+  rc const rc{ fclient.send_files(vfiles) };
+  vbad = fclient.bad();
+  return rc;
+}
+
+/// \brief single transfer session: connect, negotiate & send all files.
+///
+/// \param  vbad - indexes of the files discarded by the server. (checksum)
+/// \return 0 on success, else return fail code of the underlying functions.
+[[nodiscard]] rc send_session(addr_t const& addr, port_t const port,
+                              Tmode const tmode, Sopts const& sopts,
+                              u32 const                      flags,
+                              std::vector<file::File> const& vfiles,
+                              std::vector<u64>&              vbad)
+{
+  Fclient fclient{ addr, port, tmode };
+  fclient.set_compression(sopts.ctype, sopts.level);
+  fclient.set_readahead(sopts.inflight);
+  /// initialize file client.
+  rc rc{ fclient.init(flags) };
+  if (rc != rc::SUCCESS) {
+    return rc;
+  }
+  if (!required(fclient, flags)) {
+    return rc::FAILURE;
+  }
+  return send_transfer(fclient, vfiles, vbad);
+}
+
+/// \brief pipelined session fed by the walker: files are sent as they are
+/// found, i.e. before the walk of the dir trees is finished.
+///
+/// \return 0 on success, else return fail code of the underlying functions.
+[[nodiscard]] rc send_walk(addr_t const& addr, port_t const port,
+                           Tmode const tmode, Sopts const& sopts,
+                           u32 const flags, Walker& walker)
+{
+  Fclient fclient{ addr, port, tmode };
+  fclient.set_compression(sopts.ctype, sopts.level);
+  fclient.set_readahead(sopts.inflight);
+  rc const rc{ fclient.init(flags) };
+  if (rc != rc::SUCCESS) {
+    return rc;
+  }
+  if ((fclient.flags() & proto::fl_pipeline) == 0 || !required(fclient, flags))
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] server does not support the walk\n");
+    return rc::FAILURE;
+  }
+  return fclient.send_files(walker);
+}
+
+/// \brief failure of the connection => worth to retry.
+[[nodiscard]] bool retryable(rc const code) noexcept
+{
+  return code == rc::UNIX_SOCK_CONN_ERRO || code == rc::UNIX_SOCK_SEND_ERRO ||
+         code == rc::UNIX_SOCK_RECV_ERRO;
+}
+
+/// \brief read the paths (one per line) available on the stdin.
+///
+/// \param  line       - incomplete line, continued by the next read.
+/// \param  timeout_ms - wait for the input. (-1 indefinitely)
+/// \return  1 on success - lines are read.
+/// \return  0 on timeout - nothing is read.
+/// \return -1 on error   - and errno msg is logged to indicate the error.
+/// \return -2 on end of the input.
+[[nodiscard]] int read_paths(std::string& line, std::vector<fs::path>& vpaths,
+                             int const timeout_ms)
+{
+  struct pollfd pfd{ .fd = STDIN_FILENO, .events = POLLIN, .revents = 0 };
+  int const     nready{ poll(&pfd, 1, timeout_ms) };
+  if (nready == -1 && errno != EINTR) {
+    log_g.errnum(errno, "[FAIL] read_paths() poll()");
+    return -1;
+  }
+  if (nready <= 0) {
+    return 0;
+  }
+  std::array<char, 4096> buf{};
+  ssize_t const          nbytes{ read(STDIN_FILENO, buf.data(), buf.size()) };
+  if (nbytes == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    log_g.errnum(errno, "[FAIL] read_paths() read()");
+    return -1;
+  }
+  if (nbytes == 0) { // the last line may lack the newline.
+    if (!line.empty()) {
+      vpaths.emplace_back(std::move(line));
+      line.clear();
+    }
+    return -2;
+  }
+  for (char const c : std::span{ buf.data(), static_cast<size_t>(nbytes) }) {
+    if (c != '\n') {
+      line += c;
+    } else if (!line.empty()) {
+      vpaths.emplace_back(std::move(line));
+      line.clear();
+    }
+  }
+  return 1;
+}
+
+/// \brief files of the paths, the missing & unreadable ones are skipped.
+/// (contents are held by the client one by one, when they are sent)
+[[nodiscard]] std::vector<file::File>
+open_paths(std::vector<fs::path> const& vpaths)
+{
+  std::vector<file::File> vfiles;
+  vfiles.reserve(vpaths.size());
+  for (auto const& fp : vpaths) {
+    std::error_code ec{};
+    auto const      size{ fs::file_size(fp, ec) };
+    if (ec) {
+      WNDX_LOG(LL::WARN, "--watch: skipped {} : {}\n", fp, ec.message());
+      continue;
+    }
+    if (::access(fp.c_str(), R_OK) == -1) {
+      WNDX_LOG(LL::WARN, "--watch: skipped (not readable) {}\n", fp);
+      continue;
+    }
+    vfiles.emplace_back(fp, size);
+  }
+  return vfiles;
+}
+
+/// \brief long-lived session: files of the paths read from the stdin are
+/// sent as they come, in batches (paths arriving close together), by the
+/// single connection. Idle connection is kept alive, broken one is
+/// reconnected when the next batch is sent. (till the end of the input)
+///
+/// \param  vfiles - files of the cmd args, sent first.
+/// \return 0 on success, else fail code of the first failed batch.
+[[nodiscard]] rc send_watch(addr_t const& addr, port_t const port,
+                            Tmode const tmode, Sopts const& sopts,
+                            u32 const flags, std::vector<file::File> vfiles,
+                            unsigned const retries)
+{
+  std::unique_ptr<Fclient> fclient;
+  auto const               connect{ [&]() {
+    fclient = std::make_unique<Fclient>(addr, port, tmode);
+    fclient->set_compression(sopts.ctype, sopts.level);
+    fclient->set_readahead(sopts.inflight);
+    rc const rc{ fclient->init(flags) };
+    if (rc != rc::SUCCESS) {
+      return rc;
+    }
+    if ((fclient->flags() & proto::fl_batches) == 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] server does not support the --watch\n");
+      return rc::FAILURE;
+    }
+    return required(*fclient, flags) ? rc::SUCCESS : rc::FAILURE;
+  } };
+
+  rc               first{ rc::SUCCESS };
+  std::string      line;
+  std::vector<u64> vbad;
+  int in{ 1 };
+  while (in != -2 && in != -1) {
+    std::vector<fs::path> vpaths;
+    if (vfiles.empty()) {
+      // wait for the first path, meanwhile keep the idle connection alive.
+      in = read_paths(line, vpaths, cfg::watch_ping * 1000);
+      if (in == 0) {
+        if (fclient && fclient->keepalive() != rc::SUCCESS) {
+          fclient.reset(); // reconnected by the next batch.
+        }
+        continue;
+      }
+      // the rest of the batch: paths arriving close together.
+      while (in == 1 && vpaths.size() < cfg::batch_iov_max) {
+        in = read_paths(line, vpaths, cfg::watch_linger_ms);
+      }
+      vfiles = open_paths(vpaths);
+    }
+    for (unsigned attempt = 0; !vfiles.empty(); ++attempt) {
+      rc rc{ fclient ? rc::SUCCESS : connect() };
+      if (rc == rc::SUCCESS) {
+        vbad.clear();
+        rc = send_transfer(*fclient, vfiles, vbad);
+      }
+      if (rc == rc::SUCCESS) {
+        break;
+      }
+      if (retryable(rc)) {
+        fclient.reset();
+      }
+      if (attempt == retries || (!retryable(rc) && vbad.empty())) {
+        WNDX_LOG(LL::ERRO, "{} : {} files are not sent\n", rc, vfiles.size());
+        first = first == rc::SUCCESS ? rc : first;
+        break;
+      }
+      if (!vbad.empty()) {
+        keep_files(vfiles, vbad);
+      }
+      unsigned const backoff{ std::min(1U << std::min(attempt, 5U),
+                                       cfg::retry_backoff_max) };
+      WNDX_LOG(LL::WARN, "{} : retry {}/{} in {} s\n", rc, attempt + 1,
+               retries, backoff);
+      std::this_thread::sleep_for(std::chrono::seconds(backoff));
+    }
+    vfiles.clear();
+  }
+  if (in == -1 && first == rc::SUCCESS) {
+    first = rc::FAILURE;
+  }
+  return first;
+}
+
+} // namespace
+
 /// \brief parse command line options.
 ///
 /// catches every possible exception & signifies about that:
@@ -55,6 +473,37 @@ namespace wndx::mqlqd {
        cxxopts::value<port_t>())
 
       ("c,cat",  "Print file content (cat like utility mode).")
+      ("z,zcopy", "Zero-copy transfer via sendfile(2). "
+                  "(files are not read into memory)")
+      ("R,recursive", "Transfer the dirs with all their files & sub-dirs. "
+                      "(files are sent while the dirs are walked: -P)")
+      ("P,pipeline", "Pipelined transfer: header of each file is followed "
+                     "by its content, files are read while sending.")
+      ("max-inflight-bytes", "Read the contents ahead of the sends by the "
+                             "threads, up to N bytes in memory. (implies -P)",
+       cxxopts::value<size_t>(), "N")
+      ("s,streams", "Number of parallel connections, large files are split "
+                    "into ranges sent concurrently. (default: 1)",
+       cxxopts::value<unsigned>(), "N")
+      ("r,retry", "Reconnect & resume the interrupted transfer up to N "
+                  "times, resend the files & ranges failing the checksum. "
+                  "(default: 0)",
+       cxxopts::value<unsigned>(), "N")
+      ("W,watch", "Keep the connection open & send the files whose paths "
+                  "are read from stdin (one per line) as they come, till "
+                  "EOF. (file path arguments are sent first)")
+      ("D,dedup", "Skip the files which the server already has. "
+                  "(by the hash of the content)")
+      ("d,delta", "Send only the differences of the files modified since the "
+                  "last transfer. (rsync algorithm)")
+      ("no-checksum", "Do not verify the contents of the files by the "
+                      "checksum. (crc32c)")
+      ("C,compress", "Compress the contents of the files: zstd, lz4 or none. "
+                     "(incompressible contents are sent raw)",
+       cxxopts::value<cmd_opt_t>(), "CODEC")
+      ("L,level", "Compression level of zstd. "
+                  "(default: " + fmt::to_string(mqlqd::cfg::zstd_level) + ')',
+       cxxopts::value<int>(), "N")
       ("f,file", "File path of the file to transmit.",
        cxxopts::value<std::vector<cmd_opt_t>>())
 
@@ -80,7 +529,8 @@ namespace wndx::mqlqd {
       return rc::SUCCESS;
     }
 
-    if (!cmd_opts.count("file") && !cmd_opts.count("files_trail")) {
+    bool const watch{ cmd_opts.count("watch") != 0 };
+    if (!cmd_opts.count("file") && !cmd_opts.count("files_trail") && !watch) {
       WNDX_LOG(LL::WARN, "Lookup the usage via --help.\n{}, exit.\n",
                rc::WARN_CMD_FILE_REQ);
       return rc::WARN_CMD_FILE_REQ;
@@ -96,47 +546,118 @@ namespace wndx::mqlqd {
     /// total number of file paths passed via the cmd args (opts + trailing)
     std::size_t const n_files_passed{ cmd_opts.count("file") +
                                       cmd_opts.count("files_trail") };
-    /// vector of files info - subset of the File classes,
-    /// helper info for the transmission
-    std::vector<file::Finfo> vfinfo;
-    vfinfo.reserve(n_files_passed);
+    /// file paths (or dirs to walk) via -f --file cmd options & trailing args.
+    std::vector<fs::path> vpaths;
+    vpaths.reserve(n_files_passed);
+    for (auto const* opt : { "file", "files_trail" }) {
+      if (cmd_opts.count(opt)) {
+        for (fs::path const fp : cmd_opts[opt].as<std::vector<cmd_opt_t>>()) {
+          vpaths.push_back(fp);
+        }
+      }
+    }
+
+    /// dir trees are walked concurrently: file names are relative to them.
+    bool const recursive{ cmd_opts.count("recursive") != 0 };
+    Walker     walker{ 0 }; // threads by the CPUs.
+
     /// vector of class instances
     std::vector<file::File> vfiles;
-    vfiles.reserve(n_files_passed);
-
-    if (cmd_opts.count("file")) { // add files via -f --file cmd options
-      for (fs::path const fp : cmd_opts["file"].as<std::vector<cmd_opt_t>>()) {
+    if (recursive) {
+      walker.walk(vpaths);
+    } else {
+      vfiles.reserve(n_files_passed);
+      for (auto const& fp : vpaths) {
         vfiles.emplace_back(fp, fs::file_size(fp));
       }
     }
-    if (cmd_opts.count("files_trail")) { // add files via trailing cmd args
-      for (fs::path const fp :
-           cmd_opts["files_trail"].as<std::vector<cmd_opt_t>>())
-      {
-        vfiles.emplace_back(fp, fs::file_size(fp));
-      }
+
+    /// in the zero-copy mode file content goes from the page cache to the socket
+    /// => there is no need to read files into memory beforehand.
+    bool const zcopy{ cmd_opts.count("zcopy") && !cmd_opts.count("cat") };
+
+    /// in the pipelined mode files are read from the disk while sending
+    /// => first bytes are on the wire without waiting for the whole batch.
+    /// parallel streams send ranges => pipelined.
+    unsigned const streams{ cmd_opts.count("streams")
+                                ? cmd_opts["streams"].as<unsigned>()
+                                : 1U };
+    if (streams < 1 || streams > mqlqd::cfg::streams_max) {
+      WNDX_LOG(LL::ERRO, "{}: --streams must be in range [1, {}]\n",
+               rc::ERRO_CMD_OPT, mqlqd::cfg::streams_max);
+      return rc::ERRO_CMD_OPT;
+    }
+    /// read-ahead: disk reads overlap with the sends, memory stays bounded.
+    /// (each stream reads ahead at least 2 chunks)
+    size_t const inflight{ cmd_opts.count("max-inflight-bytes")
+                               ? cmd_opts["max-inflight-bytes"].as<size_t>()
+                               : 0 };
+    if (inflight > 0 && (inflight < 2 * mqlqd::cfg::chunk_size * streams ||
+                         zcopy))
+    {
+      WNDX_LOG(LL::ERRO,
+               "{}: --max-inflight-bytes must be at least {} per stream & "
+               "excludes --zcopy\n",
+               rc::ERRO_CMD_OPT, 2 * mqlqd::cfg::chunk_size);
+      return rc::ERRO_CMD_OPT;
     }
+    bool const pipeline{ (cmd_opts.count("pipeline") || streams > 1 ||
+                          inflight > 0) &&
+                         !cmd_opts.count("cat") };
 
-    /// loop over each file path passed via the cmd args (opts + trailing)
-    for (file::File& file : vfiles) {
-      /// Read contents of the file(s) into the block(s) of memory.
-      /// We are doing this here to not have potential bottleneck later -> on the
-      /// transmission step. (especially in terms of reading speed from the users
-      /// block devices e.g. Slow HDD etc.).
-      rc = file.alloc_and_read();
-      if (rc != rc::SUCCESS) {
-        return rc;
+    unsigned const retries{ cmd_opts.count("retry")
+                                ? cmd_opts["retry"].as<unsigned>()
+                                : 0U };
+
+    /// found files are sent right away by the single pipelined connection,
+    /// else the whole walk is awaited. (e.g. retried transfer sends it again)
+    bool const walk_stream{ recursive && pipeline && streams == 1 &&
+                            retries == 0 };
+    if (recursive && !walk_stream) {
+      std::deque<file::File> vfound;
+      while (walker.next(vfound)) {
       }
-      if (cmd_opts.count("cat")) {
-        file.print();
-      } else {
-        vfinfo.emplace_back(file.to_finfo());
+      vfiles.reserve(vfound.size());
+      for (auto& file : vfound) {
+        vfiles.push_back(std::move(file));
       }
     }
 
-    /// if we are in the cat mode -> simply finish =>
+    /// long-lived session sends the batches by the single connection.
+    if (watch && (recursive || streams > 1 || cmd_opts.count("cat"))) {
+      WNDX_LOG(LL::ERRO,
+               "{}: --watch excludes --recursive, --streams & --cat\n",
+               rc::ERRO_CMD_OPT);
+      return rc::ERRO_CMD_OPT;
+    }
+
+    /// the server replies which files it has before the contents are sent
+    /// => not in the pipelined transfer.
+    /// (the same for the signatures of the old copies of the files)
+    bool const dedup{ cmd_opts.count("dedup") != 0 };
+    bool const delta{ cmd_opts.count("delta") != 0 };
+    if ((dedup || delta) && pipeline) {
+      WNDX_LOG(LL::ERRO,
+               "{}: --dedup & --delta exclude --pipeline, --streams & "
+               "--max-inflight-bytes\n",
+               rc::ERRO_CMD_OPT);
+      return rc::ERRO_CMD_OPT;
+    }
+
+    /// if we are in the cat mode -> print the files & simply finish =>
     /// as user do not need to initialize file client & do transmission.
+    /// (otherwise contents are mapped into memory by the file client one by
+    /// one, when they are sent - not all at once: vm.max_map_count)
     if (cmd_opts.count("cat")) {
+      /// loop over each file path passed via the cmd args (opts + trailing)
+      for (file::File& file : vfiles) {
+        /// Read contents of the file(s) into the block(s) of memory.
+        rc = file.alloc_and_read();
+        if (rc != rc::SUCCESS) {
+          return rc;
+        }
+        file.print();
+      }
       return rc::SUCCESS;
     }
 
@@ -148,23 +669,78 @@ namespace wndx::mqlqd {
     port_t const port{ cmd_opts.count("port") ? cmd_opts["port"].as<port_t>()
                                               : mqlqd::cfg::port };
 
-    Fclient fclient{ addr, port };
-    /// initialize file client.
-    rc = fclient.init();
-    if (rc != rc::SUCCESS) {
-      return rc;
+    Tmode const tmode{ zcopy      ? Tmode::SENDFILE
+                       : pipeline ? Tmode::CHUNKED
+                                  : Tmode::BUFFERED };
+
+    /// compression is negotiated => server without the codec gets raw content.
+    Sopts sopts{ .inflight = inflight };
+    if (cmd_opts.count("compress") &&
+        codec::parse(cmd_opts["compress"].as<cmd_opt_t>(), sopts.ctype) != 0)
+    {
+      WNDX_LOG(LL::ERRO, "{}: --compress must be one of: zstd, lz4, none\n",
+               rc::ERRO_CMD_OPT);
+      return rc::ERRO_CMD_OPT;
+    }
+    if (cmd_opts.count("level")) {
+      sopts.level = cmd_opts["level"].as<int>();
+    }
+    if (sopts.ctype != codec::Ctype::NONE &&
+        (codec::available() & codec::to_flag(sopts.ctype)) == 0)
+    {
+      WNDX_LOG(LL::WARN, "--compress: codec is not built in => sent raw\n");
     }
 
-    /// attempt to send info of the upcoming transmission of the files.
-    rc = fclient.send_files_info(vfinfo);
-    if (rc != rc::SUCCESS) {
-      return rc;
+    /// contents are verified by the server, corrupted files are discarded.
+    /// file names of the walk are the paths relative to the walked dirs.
+    u32 const fl_common{ (cmd_opts.count("no-checksum") ? proto::fl_none
+                                                        : proto::fl_crc) |
+                         (recursive ? proto::fl_tree : proto::fl_none) };
+
+    if (walk_stream) {
+      return send_walk(addr, port, tmode, sopts,
+                       proto::fl_pipeline | fl_common, walker);
     }
 
-    /// server is ready to accept provided files => start sending files.
-    rc = fclient.send_files(vfiles);
-    if (rc != rc::SUCCESS) {
-      return rc;
+    if (streams > 1) {
+      return send_streams(addr, port, tmode, sopts,
+                          proto::fl_pipeline | fl_common, vfiles, streams,
+                          retries);
+    }
+
+    /// interrupted transfer is retried on the new connection, server replies
+    /// with the offsets of the already received contents => only the rest
+    /// is sent. (pipelined transfer is restarted from the beginning)
+    u32 flags{ (pipeline ? proto::fl_pipeline : proto::fl_resume) |
+               fl_common };
+    if (dedup) {
+      flags |= proto::fl_dedup;
+    }
+    if (delta) {
+      flags |= proto::fl_delta;
+    }
+    if (watch) {
+      return send_watch(addr, port, tmode, sopts, flags | proto::fl_batches,
+                        std::move(vfiles), retries);
+    }
+
+    /// checksum mismatch => only the discarded files are sent again.
+    std::vector<u64> vbad;
+    for (unsigned attempt = 0;; ++attempt) {
+      rc = send_session(addr, port, tmode, sopts, flags, vfiles, vbad);
+      if (rc == rc::SUCCESS || attempt == retries ||
+          (!retryable(rc) && vbad.empty()))
+      {
+        return rc;
+      }
+      if (!vbad.empty()) {
+        keep_files(vfiles, vbad);
+      }
+      unsigned const backoff{ std::min(1U << std::min(attempt, 5U),
+                                       mqlqd::cfg::retry_backoff_max) };
+      WNDX_LOG(LL::WARN, "{} : retry {}/{} in {} s\n", rc, attempt + 1,
+               retries, backoff);
+      std::this_thread::sleep_for(std::chrono::seconds(backoff));
     }
 
   } catch (cxxopts::exceptions::exception const& err) {
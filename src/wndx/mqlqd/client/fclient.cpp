@@ -3,29 +3,97 @@
 
 #include "wndx/mqlqd/fclient.hpp"
 
+#include "wndx/mqlqd/codec.hpp"
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/crc32c.hpp"
+#include "wndx/mqlqd/delta.hpp"
 #include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/io.hpp"
+#include "wndx/mqlqd/proto.hpp"
+#include "wndx/mqlqd/xxh64.hpp"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <deque>
 #include <vector>
 
 extern "C" {
 
 #include <arpa/inet.h>   // inet_pton(), inet_ntoa()
+#include <fcntl.h>       // open(2)
 #include <netdb.h>
 #include <netinet/in.h>  // Internet domain sockets | sockaddr(3type)
 #include <netinet/tcp.h> // TCP protocol | tcp(7)
 #include <sys/socket.h>
+#include <sys/stat.h>    // stat(2)
 #include <sys/types.h>   // ssize_t
-#include <unistd.h>      // | close(2).
+#include <sys/uio.h>     // struct iovec
+#include <unistd.h>      // | close(2), pread(2).
+
+#ifdef __linux__
+#include <sys/sendfile.h> // sendfile(2) - Linux specific
+#endif // __linux__
 
 } // extern "C"
 
 namespace wndx::mqlqd {
 
-Fclient::Fclient(addr_t const& addr, port_t const& port) noexcept
+namespace {
+
+[[nodiscard]] proto::Fhdr to_fhdr(file::File const& file,
+                                  u64 const         hflags = proto::hf_none)
+{
+  proto::Fhdr hdr{};
+  hdr.hflags = hflags;
+  hdr.size   = file.size();
+  hdr.name   = file.name().string();
+  return hdr;
+}
+
+/// \brief identity of the source file: another file of the same name (e.g.
+/// of the other client), or the same one modified since, has the other one.
+/// (the partial file of the server is resumed only for the same source)
+///
+/// \return false if the file can not be identified. (e.g. content in memory)
+[[nodiscard]] bool src_id(file::File const& file, u64& id) noexcept
+{
+  struct stat st{};
+  if (file.path().empty() || ::stat(file.path().c_str(), &st) == -1) {
+    return false;
+  }
+  std::array<u64, 4> const vid{ static_cast<u64>(st.st_dev),
+                                static_cast<u64>(st.st_ino),
+                                static_cast<u64>(st.st_mtim.tv_sec),
+                                static_cast<u64>(st.st_mtim.tv_nsec) };
+  // NOLINTNEXTLINE(*-reinterpret-cast)
+  id = xxh64(reinterpret_cast<char const*>(vid.data()), sizeof(vid));
+  return true;
+}
+
+/// \brief log the files discarded by the server. (by the index of the header)
+template <typename Files>
+void log_bad(std::vector<u64> const& vbad, Files const& vfiles,
+             std::vector<Frange> const& vranges)
+{
+  for (u64 const idx : vbad) {
+    file::File const& file{ idx < vfiles.size()
+                                ? vfiles[idx]
+                                : *vranges[idx - vfiles.size()].file };
+    WNDX_LOG(LL::ERRO, "[FAIL] checksum mismatch => discarded : {}\n", file);
+  }
+}
+
+} // namespace
+
+Fclient::Fclient(addr_t const& addr, port_t const& port,
+                 Tmode const tmode) noexcept
     : m_addr{ addr }
     , m_port{ port }
+    , m_tmode{ tmode }
 {
   WNDX_LOG(LL::DBUG, "INSIDE ctor Fclient()\n");
 }
@@ -33,18 +101,8 @@ Fclient::Fclient(addr_t const& addr, port_t const& port) noexcept
 Fclient::~Fclient() noexcept
 {
   WNDX_LOG(LL::DBUG, "INSIDE dtor ~Fclient()\n");
-  // TODO: close_fd() | close(2) wrapper
   // close file descriptor. ref: close(2).
-  if (m_fd > 0) {
-    m_rc = close(m_fd);
-    switch (m_rc) {
-    case -1: log_g.errnum(errno, "[FAIL] m_fd close()"); break;
-    case 0 : WNDX_LOG(LL::DBUG, "[ OK ] m_fd close()\n"); break;
-    default:
-      WNDX_LOG(LL::CRIT, "UNEXPECTED return code: m_fd close() -> {}\n", m_rc);
-    }
-    m_fd = -1;
-  }
+  io::close_fd(m_fd, "m_fd");
   WNDX_LOG(LL::DBUG, "END OF dtor ~Fclient()\n");
 }
 
@@ -56,79 +114,798 @@ Fclient::~Fclient() noexcept
     log_g.errnum(errno, "[FAIL] convert host_addr_ipv4()");
     return {};
   }
-  str.pop_back(); // remove null-terminator
+  str.resize(std::strlen(str.c_str())); // remove null-terminator(s)
   return str;
 }
 
-[[nodiscard]] int
-Fclient::send_num_files_total(size_t const num_files_total) const
+[[nodiscard]] rc
+Fclient::send_files_info(std::vector<file::File> const& vfiles)
 {
-  ssize_t nbytes = send(m_fd, &num_files_total, sizeof(num_files_total), 0);
-  if (nbytes != sizeof(num_files_total)) {
-    switch (nbytes) { // NOLINT(hicpp-multiway-paths-covered)
-    case -1:
-      log_g.errnum(errno, "[FAIL] to send() num_files_total, error occurred");
+  // num_files_total => so that server knows how many files to expect,
+  // followed by all file headers => coalesced into the single send().
+  std::string buf;
+  proto::put_varint(buf, vfiles.size());
+  m_vzframe.assign(vfiles.size(), 0);
+  bool const dedup{ (m_flags & proto::fl_dedup) != 0 };
+  for (size_t i = 0; i < vfiles.size(); ++i) {
+    m_vzframe[i] = zframe(vfiles[i], 0) ? 1 : 0;
+    proto::Fhdr hdr{ to_fhdr(vfiles[i], m_vzframe[i] != 0 ? proto::hf_zframe
+                                                          : proto::hf_none) };
+    // dedup: server replies which contents it already has. (by the hash)
+    if (dedup && hash_file(vfiles[i], hdr.hash) == 0) {
+      hdr.hflags |= proto::hf_hash;
+    }
+    if ((m_flags & proto::fl_src) != 0 && src_id(vfiles[i], hdr.src)) {
+      hdr.hflags |= proto::hf_src;
+    }
+    proto::encode(buf, hdr);
+  }
+  m_rc = io::send_loop(m_fd, buf.data(), buf.size());
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_files_info() in send_loop() -> {}\n",
+             m_rc);
+    return rc::UNIX_SOCK_SEND_ERRO;
+  }
+  WNDX_LOG(LL::DBUG, "[ OK ] send_num_files_total() : {}\n", vfiles.size());
+  for (auto const& file : vfiles) {
+    WNDX_LOG(LL::INFO, "[ OK ] send_file_hdr() : {}\n", file);
+  }
+  WNDX_LOG(LL::INFO,
+           "[ OK ] sent info of the upcoming transfer of the files. ({} B)\n",
+           buf.size());
+  if ((m_flags & proto::fl_resume) == 0) {
+    return rc::SUCCESS;
+  }
+  m_rc = recv_plan(vfiles);
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_files_info() in recv_plan() -> {}\n",
+             m_rc);
+    return rc::UNIX_SOCK_RECV_ERRO;
+  }
+  m_rc = (m_flags & proto::fl_delta) != 0 ? recv_sigs(vfiles) : 0;
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_files_info() in recv_sigs() -> {}\n",
+             m_rc);
+    return rc::UNIX_SOCK_RECV_ERRO;
+  }
+  return rc::SUCCESS;
+}
+
+[[nodiscard]] int Fclient::recv_plan(std::vector<file::File> const& vfiles)
+{
+  std::string body;
+  m_rc = recv_reply(body);
+  if (m_rc != 0) {
+    return m_rc;
+  }
+  if (proto::decode_plan(body.data(), body.size(), m_vplan) != proto::Pres::OK ||
+      m_vplan.size() != vfiles.size())
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] recv_plan() - malformed Plan\n");
+    return -1;
+  }
+  u64    received{ 0 };
+  size_t have{ 0 }; // files which are not sent at all.
+  for (size_t i = 0; i < vfiles.size(); ++i) {
+    if (m_vplan[i] > vfiles[i].size()) {
+      WNDX_LOG(LL::ERRO, "[FAIL] recv_plan() - offset past the end : {}\n",
+               vfiles[i]);
       return -1;
-    default:
-      WNDX_LOG(LL::ERRO,
-               "[FAIL] sent num_files_total out of all bytes: {}/{}\n", nbytes,
-               sizeof(num_files_total));
     }
-    return -2;
+    if (m_vplan[i] == vfiles[i].size() && vfiles[i].size() > 0) {
+      ++have;
+      WNDX_LOG(LL::INFO, "[ OK ] recv_plan() : server has it : {}\n",
+               vfiles[i]);
+    }
+    received += m_vplan[i];
   }
-  WNDX_LOG(LL::DBUG, "[ OK ] send_num_files_total() : {}\n", num_files_total);
+  WNDX_LOG(LL::NTFY,
+           "[ OK ] recv_plan() : {} B already received ({}/{} files)\n",
+           received, have, vfiles.size());
   return 0;
 }
 
-[[nodiscard]] rc
-Fclient::send_files_info(std::vector<file::Finfo> const& vfinfo)
+[[nodiscard]] int Fclient::recv_sigs(std::vector<file::File> const& vfiles)
+{
+  std::string body;
+  m_rc = recv_reply(body);
+  if (m_rc != 0) {
+    return m_rc;
+  }
+  if (proto::decode_sigs(body.data(), body.size(), m_vfsigs) !=
+      proto::Pres::OK)
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] recv_sigs() - malformed Sigs\n");
+    return -1;
+  }
+  m_vdelta.assign(vfiles.size(), delta::Sigset::none);
+  for (size_t i = 0; i < m_vfsigs.size(); ++i) {
+    u64 const idx{ m_vfsigs[i].idx };
+    // content of the file is the delta only when nothing is received yet.
+    if (idx >= vfiles.size() || m_vdelta[idx] != delta::Sigset::none ||
+        m_vplan[idx] != 0)
+    {
+      WNDX_LOG(LL::ERRO, "[FAIL] recv_sigs() - unexpected Sigs\n");
+      return -1;
+    }
+    m_vdelta[idx] = i;
+  }
+  WNDX_LOG(LL::INFO, "[ OK ] recv_sigs() : {} files as the delta\n",
+           m_vfsigs.size());
+  return 0;
+}
+
+[[nodiscard]] int Fclient::hash_file(file::File const& file, u64& hash)
+{
+  // in memory (Tmode::BUFFERED), else read. (not mapped yet - see: hold())
+  if (file.data() != nullptr) {
+    hash = xxh64(file.data(), file.size());
+    return 0;
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    log_g.errnum(errno, "[FAIL] hash_file() open()");
+    return -1;
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  static_cast<void>(posix_fadvise(fd_in, 0, 0, POSIX_FADV_SEQUENTIAL));
+#endif // POSIX_FADV_SEQUENTIAL
+  if (m_chunk.empty()) {
+    m_chunk.resize(cfg::chunk_size);
+  }
+  Xxh64  xxh;
+  size_t off{ 0 };
+  m_rc = 0;
+  while (off < file.size() && m_rc == 0) {
+    size_t const len{ std::min(file.size() - off, m_chunk.size()) };
+    m_rc = io::pread_loop(fd_in, m_chunk.data(), len, static_cast<off_t>(off));
+    xxh.update(m_chunk.data(), len);
+    off += len;
+  }
+  io::close_fd(fd_in, "hash_file() fd_in");
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] hash_file() -> {} : {}\n", m_rc, file);
+    return m_rc;
+  }
+  hash = xxh.digest();
+  WNDX_LOG(LL::DBUG, "[ OK ] hash_file() : {:016x} : {}\n", hash, file);
+  return 0;
+}
+
+[[nodiscard]] int Fclient::recv_reply(std::string& body)
+{
+  // length prefix (varint) is read byte by byte, the body at once.
+  std::array<char, proto::varint_max> pfx{};
+  u64                                 len{ 0 };
+  size_t                              n{ 0 };
+  for (size_t i = 0;; ++i) {
+    if (i == pfx.size() || io::recv_loop(m_fd, &pfx.at(i), 1) != 0) {
+      return -1;
+    }
+    proto::Pres const res{ proto::get_varint(pfx.data(), i + 1, len, n) };
+    if (res == proto::Pres::OK) {
+      break;
+    }
+    if (res == proto::Pres::BAD) {
+      return -1;
+    }
+  }
+  if (len > proto::reply_max) {
+    WNDX_LOG(LL::ERRO, "[FAIL] recv_reply() - too long : {}\n", len);
+    return -1;
+  }
+  body.assign(static_cast<size_t>(len), '\0');
+  return io::recv_loop(m_fd, body.data(), body.size());
+}
+
+[[nodiscard]] rc Fclient::send_files(std::vector<file::File> const& vfiles,
+                                     std::vector<Frange> const&     vranges)
+{
+  bool const pipelined{ (m_flags & proto::fl_pipeline) != 0 };
+  if (!vranges.empty() && (!pipelined || m_tmode == Tmode::BUFFERED)) {
+    WNDX_LOG(LL::ERRO, "[FAIL] ranges require the pipelined session\n");
+    return rc::FAILURE;
+  }
+  if (!m_vplan.empty() && m_vplan.size() != vfiles.size()) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_files() - files do not match the plan\n");
+    return rc::FAILURE;
+  }
+  for (size_t i = 0; i < vfiles.size(); ++i) {
+    read_ahead(vfiles[i], i);
+  }
+  for (auto const& range : vranges) {
+    if (m_reader) {
+      m_reader->add(*range.file, range.off, range.len);
+    }
+  }
+  for (size_t i = 0; i < vfiles.size(); ++i) {
+    m_rc = send_one(vfiles[i], i,
+                    i + 1 < vfiles.size() ? &vfiles[i + 1] : nullptr);
+    if (m_rc != 0) {
+      return rc::UNIX_SOCK_SEND_ERRO;
+    }
+  }
+  for (auto const& range : vranges) {
+    m_rc = send_range(range);
+    if (m_rc != 0) {
+      return rc::UNIX_SOCK_SEND_ERRO;
+    }
+  }
+  rc const res{ send_end(vfiles.size(), vranges.size()) };
+  log_bad(m_vbad, vfiles, vranges);
+  return res;
+}
+
+[[nodiscard]] rc Fclient::send_files(Walker& walker)
+{
+  if ((m_flags & proto::fl_pipeline) == 0 || m_tmode == Tmode::BUFFERED) {
+    WNDX_LOG(LL::ERRO, "[FAIL] walk requires the pipelined session\n");
+    return rc::FAILURE;
+  }
+  std::deque<file::File>& vfiles{ m_vwalked };
+  size_t                  i{ 0 };
+  do {
+    for (size_t k = i; k < vfiles.size(); ++k) {
+      read_ahead(vfiles[k], k);
+    }
+    for (; i < vfiles.size(); ++i) {
+      m_rc = send_one(vfiles[i], i,
+                      i + 1 < vfiles.size() ? &vfiles[i + 1] : nullptr);
+      if (m_rc != 0) {
+        return rc::UNIX_SOCK_SEND_ERRO;
+      }
+    }
+    // small files found so far are on the wire while the walk goes on.
+    m_rc = send_batch();
+    if (m_rc != 0) {
+      return rc::UNIX_SOCK_SEND_ERRO;
+    }
+  } while (walker.next(vfiles));
+  rc const res{ send_end(vfiles.size(), 0) };
+  log_bad(m_vbad, vfiles, {});
+  return res;
+}
+
+[[nodiscard]] int Fclient::send_one(file::File const& source, size_t const i,
+                                    file::File const* next)
+{
+  // Tmode::BUFFERED: content is mapped only now, till it is sent.
+  file::File const* const held{ hold(source) };
+  if (held == nullptr) {
+    return -1;
+  }
+  file::File const& file{ *held };
+  bool const pipelined{ (m_flags & proto::fl_pipeline) != 0 };
+  // resumable: only the rest of the content is sent.
+  size_t const off{ m_vplan.empty() ? 0 : m_vplan[i] };
+  // delta: the server has the old copy of the file.
+  bool const delta{ i < m_vdelta.size() && m_vdelta[i] != delta::Sigset::none };
+  // compressed content (decided by the header of the file).
+  bool const z{ pipelined ? zframe(file, off)
+                          : i < m_vzframe.size() && m_vzframe[i] != 0 };
+  // checksum of the whole content follows, if any of it is sent.
+  bool const sum{ crc() && off < file.size() };
+  m_crc = 0;
+  m_rc  = pipelined ? batch_hdr(to_fhdr(file, z ? proto::hf_zframe
+                                                : proto::hf_none))
+                    : 0;
+  if (m_rc == 0 && sum && off > 0) { // resumed => received part too.
+    m_rc = crc_file(file, 0, off);
+  }
+  if (m_rc != 0) {
+    return m_rc;
+  }
+  if (delta) {
+    m_rc = send_batch();
+    if (m_rc == 0) {
+      m_rc = send_file_delta(file, m_vfsigs[m_vdelta[i]]);
+    }
+  } else if (z) {
+    m_rc = send_batch();
+    if (m_rc == 0) {
+      m_rc = send_file_z(file, off);
+    }
+  }
+  // contents of the small files (or in memory) are coalesced into the batch.
+  else if (file.data() != nullptr || file.size() - off <= cfg::batch_file_max)
+  {
+    m_rc = batch_file(file, off);
+  } else {
+    m_rc = send_batch();
+    // next file is read from the disk while this one is on the wire.
+    if (pipelined && next != nullptr && !m_reader) {
+      prefetch(*next);
+    }
+    if (m_rc == 0) {
+      m_rc = send_file(file, off);
+    }
+  }
+  if (m_rc == 0 && sum) {
+    m_rc = batch_crc();
+  }
+  if (m_viov.empty()) { // not referenced by the pending batch.
+    m_vheld.clear();
+  }
+  return m_rc;
+}
+
+[[nodiscard]] file::File const* Fclient::hold(file::File const& file)
+{
+  if (m_tmode != Tmode::BUFFERED || file.size() == 0 ||
+      file.data() != nullptr)
+  {
+    return &file;
+  }
+  file::File& held{ m_vheld.emplace_back(file) };
+  // files which can not be mapped (e.g. pipes) are read.
+  if (held.map() != rc::SUCCESS && held.alloc_and_read() != rc::SUCCESS) {
+    WNDX_LOG(LL::ERRO, "[FAIL] hold() - not read : {}\n", file);
+    m_vheld.pop_back();
+    return nullptr;
+  }
+  return &held;
+}
+
+[[nodiscard]] rc Fclient::send_end(size_t const nfiles, size_t const nranges)
 {
-  // send num_files_total => so that server knows how many files to expect.
-  m_rc = send_num_files_total(vfinfo.size());
+  proto::Fhdr end{};
+  end.hflags = proto::hf_end;
+  m_rc       = (m_flags & proto::fl_pipeline) != 0 ? batch_hdr(end) : 0;
+  if (m_rc == 0) {
+    m_rc = send_batch();
+  }
+  m_vheld.clear(); // contents are sent => unmapped.
   if (m_rc != 0) {
     return rc::UNIX_SOCK_SEND_ERRO;
   }
-  for (auto const& finfo : vfinfo) {
-    m_rc = send_file_info(finfo);
+  WNDX_LOG(LL::NTFY, "[ OK ] all files are sent: {}/{}\n", nfiles, nfiles);
+  if (!crc() && (m_flags & proto::fl_publish) == 0) {
+    return rc::SUCCESS;
+  }
+  m_rc = recv_verdict(nfiles + nranges);
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_files() in recv_verdict() -> {}\n",
+             m_rc);
+    return rc::UNIX_SOCK_RECV_ERRO;
+  }
+  return m_vbad.empty() ? rc::SUCCESS : rc::FAILURE;
+}
+
+[[nodiscard]] rc Fclient::keepalive()
+{
+  // transfer without files. (pipelined: only the end of the transfer)
+  if ((m_flags & proto::fl_pipeline) == 0) {
+    std::string buf;
+    proto::put_varint(buf, 0);
+    m_rc = io::send_loop(m_fd, buf.data(), buf.size());
     if (m_rc != 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] keepalive() in send_loop() -> {}\n", m_rc);
       return rc::UNIX_SOCK_SEND_ERRO;
     }
   }
-  WNDX_LOG(LL::INFO,
-           "[ OK ] sent info of the upcoming transfer of the files.\n");
-  return rc::SUCCESS;
+  return send_end(0, 0);
 }
 
-[[nodiscard]] int Fclient::send_file_info(file::Finfo const& finfo)
+[[nodiscard]] int Fclient::recv_verdict(size_t const count)
 {
-  WNDX_LOG(LL::DBUG, "INSIDE send_file_info() : {}\n", finfo);
-  m_rc = send_loop<file::Finfo>(m_fd, &finfo, sizeof(finfo));
+  std::string body;
+  m_rc = recv_reply(body);
   if (m_rc != 0) {
-    WNDX_LOG(LL::ERRO, "[FAIL] send_file_info() in send_loop() -> {} : {}\n",
-             m_rc, finfo);
     return m_rc;
   }
-  WNDX_LOG(LL::INFO, "[ OK ] send_file_info() : {}\n", finfo);
+  auto const beyond{ [count](u64 const idx) { return idx >= count; } };
+  m_vpub.clear();
+  proto::Pres const res{
+    (m_flags & proto::fl_publish) != 0
+        ? proto::decode_verdict(body.data(), body.size(), m_vbad, m_vpub)
+        : proto::decode_verdict(body.data(), body.size(), m_vbad)
+  };
+  if (res != proto::Pres::OK || std::any_of(m_vbad.begin(), m_vbad.end(),
+                                            beyond) ||
+      std::any_of(m_vpub.begin(), m_vpub.end(), beyond))
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] recv_verdict() - malformed Verdict\n");
+    return -1;
+  }
+  WNDX_LOG(LL::INFO, "[ OK ] recv_verdict() : {} files discarded (crc32c{})\n",
+           m_vbad.size(), crc32c_hw() ? ", hw" : "");
   return 0;
 }
 
-[[nodiscard]] rc Fclient::send_files(std::vector<file::File> const& vfiles)
+[[nodiscard]] int Fclient::batch_hdr(proto::Fhdr const& hdr)
 {
-  for (auto const& file : vfiles) {
-    m_rc = send_file(file);
+  // header is never separated from the content by the full batch.
+  if (m_viov.size() + 2 > cfg::batch_iov_max) {
+    m_rc = send_batch();
     if (m_rc != 0) {
-      return rc::UNIX_SOCK_SEND_ERRO;
+      return m_rc;
     }
   }
-  WNDX_LOG(LL::NTFY, "[ OK ] all files are sent: {}/{}\n", vfiles.size(),
-           vfiles.size());
-  return rc::SUCCESS;
+  size_t const off{ m_hdrs.size() };
+  proto::encode(m_hdrs, hdr);
+  // base is assigned by the send_batch(), as m_hdrs may reallocate till then.
+  m_viov.push_back({ nullptr, m_hdrs.size() - off });
+  return 0;
+}
+
+[[nodiscard]] int Fclient::batch_crc()
+{
+  if (m_viov.size() + 1 > cfg::batch_iov_max) {
+    m_rc = send_batch();
+    if (m_rc != 0) {
+      return m_rc;
+    }
+  }
+  size_t const off{ m_hdrs.size() };
+  proto::put_u32le(m_hdrs, m_crc);
+  m_viov.push_back({ nullptr, m_hdrs.size() - off }); // see: batch_hdr().
+  return 0;
+}
+
+[[nodiscard]] int Fclient::crc_file(file::File const& file, size_t off,
+                                    size_t const len)
+{
+  if (file.data() != nullptr) {
+    m_crc = crc32c(m_crc, file.data() + off, len);
+    return 0;
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    log_g.errnum(errno, "[FAIL] crc_file() open()");
+    return -1;
+  }
+  // m_chunk may hold the pending batch => read into the m_zbuf.
+  m_zbuf.resize(std::max(m_zbuf.size(), cfg::chunk_size));
+  m_rc = 0;
+  for (size_t const end{ off + len }; off < end && m_rc == 0;) {
+    size_t const n{ std::min(end - off, cfg::chunk_size) };
+    m_rc   = io::pread_loop(fd_in, m_zbuf.data(), n, static_cast<off_t>(off));
+    m_crc  = crc32c(m_crc, m_zbuf.data(), n);
+    off   += n;
+  }
+  io::close_fd(fd_in, "crc_file() fd_in");
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] crc_file() -> {} : {}\n", m_rc, file);
+  }
+  return m_rc;
 }
 
-[[nodiscard]] int Fclient::send_file(file::File const& file)
+[[nodiscard]] bool Fclient::zframe(file::File const& file, size_t const off)
+{
+  size_t const len{ std::min(file.size() - off, cfg::comp_sample) };
+  // small files travel raw in the batches.
+  if (!m_codec || file.size() - off <= cfg::batch_file_max) {
+    return false;
+  }
+  if (file.data() != nullptr) {
+    return m_codec->worth(file.data() + off, len);
+  }
+  // m_chunk may hold the pending batch => sample is read into m_zbuf.
+  m_zbuf.resize(std::max(m_zbuf.size(), len));
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    return false; // not fatal, error is reported when the file is sent.
+  }
+  m_rc = io::pread_loop(fd_in, m_zbuf.data(), len, static_cast<off_t>(off));
+  io::close_fd(fd_in, "zframe() fd_in");
+  bool const worth{ m_rc == 0 && m_codec->worth(m_zbuf.data(), len) };
+  WNDX_LOG(LL::DBUG, "zframe() : {} : {}\n", worth, file);
+  return worth;
+}
+
+[[nodiscard]] int Fclient::send_file_z(file::File const& file, size_t off)
+{
+  WNDX_LOG(LL::INFO, "INSIDE send_file_z() : {}\n", file);
+  bool const ahead{ m_reader && file.data() == nullptr };
+  int        fd_in{ -1 };
+  if (file.data() == nullptr && !ahead) {
+    // NOLINTNEXTLINE(*-vararg)
+    fd_in = open(file.path().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_in == -1) {
+      log_g.errnum(errno, "[FAIL] send_file_z() open()");
+      return -1;
+    }
+    if (m_chunk.empty()) {
+      m_chunk.resize(cfg::chunk_size);
+    }
+  }
+  m_zbuf.resize(m_codec->bound(cfg::chunk_size));
+  size_t      sent{ 0 }; // bytes on the wire.
+  size_t      left{ file.size() - off };
+  std::string hdr;
+  m_rc = 0;
+  while (left > 0 && m_rc == 0) {
+    size_t const raw{ std::min(left, cfg::chunk_size) };
+    char const*  src{ file.data() + off };
+    if (ahead) {
+      Rchunk chunk;
+      m_rc = m_reader->next(file, off, chunk);
+      src  = chunk.data;
+    } else if (fd_in != -1) {
+      m_rc = io::pread_loop(fd_in, m_chunk.data(), raw, static_cast<off_t>(off));
+      src  = m_chunk.data();
+    }
+    if (m_rc != 0) {
+      break;
+    }
+    if (crc()) { // of the raw bytes, while they are in the cache.
+      m_crc = crc32c(m_crc, src, raw);
+    }
+    // incompressible block => raw bytes. (clen == 0)
+    size_t const clen{ m_codec->compress(src, raw, m_zbuf.data(),
+                                         m_zbuf.size()) };
+    hdr.clear();
+    proto::encode(hdr, proto::Zblk{ .raw = raw, .clen = clen });
+    // NOLINTBEGIN(*-const-cast)
+    std::array<struct iovec, 2> iov{ {
+        { hdr.data(), hdr.size() },
+        { clen != 0 ? m_zbuf.data() : const_cast<char*>(src),
+          clen != 0 ? clen : raw },
+    } };
+    // NOLINTEND(*-const-cast)
+    sent += hdr.size() + iov[1].iov_len;
+    m_rc  = send_iov_loop(iov.data(), iov.size());
+    if (ahead) {
+      m_reader->release();
+    }
+    off  += raw;
+    left -= raw;
+  }
+  io::close_fd(fd_in, "send_file_z() fd_in");
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_file_z() -> {} : {}\n", m_rc, file);
+    return m_rc;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] send_file_z() : {} B on the wire : {}\n", sent,
+           file);
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_file_delta(file::File const&   file,
+                                           proto::Fsigs const& fsigs)
+{
+  WNDX_LOG(LL::INFO, "INSIDE send_file_delta() : {}\n", file);
+  // whole content is scanned => mapped, if it is not in memory already.
+  char const* data{ file.data() };
+  file::File  mapped{ file.path(), file.size() };
+  if (data == nullptr) {
+    if (mapped.map() != rc::SUCCESS) {
+      return -1;
+    }
+    data = mapped.data();
+  }
+  if (crc()) { // of the new content, the server checks the reconstructed.
+    m_crc = crc32c(m_crc, data, file.size());
+  }
+  delta::Sigset const sigset{ fsigs };
+  delta::Scanner      scanner{ data, file.size(), sigset };
+  proto::Dop          op{};
+  std::string         hdr; // copies are coalesced with the next literal.
+  size_t              literal{ 0 };
+  m_rc = 0;
+  while (m_rc == 0 && scanner.next(op)) {
+    bool const lit{ op.kind == proto::Dkind::LITERAL };
+    u64 const  pos{ op.off };
+    if (lit) {
+      op.off = 0; // position in the new content is not on the wire.
+    }
+    proto::encode(hdr, op);
+    if (!lit && hdr.size() < cfg::batch_file_max) {
+      continue;
+    }
+    size_t const len{ lit ? static_cast<size_t>(op.len) : 0 };
+    // NOLINTBEGIN(*-const-cast, *-pointer-arithmetic)
+    std::array<struct iovec, 2> iov{ {
+        { hdr.data(), hdr.size() },
+        { const_cast<char*>(data) + pos, len },
+    } };
+    // NOLINTEND(*-const-cast, *-pointer-arithmetic)
+    literal += iov[1].iov_len;
+    m_rc     = send_iov_loop(iov.data(), iov.size());
+    hdr.clear();
+  }
+  if (m_rc == 0 && !hdr.empty()) {
+    m_rc = io::send_loop(m_fd, hdr.data(), hdr.size());
+  }
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_file_delta() -> {} : {}\n", m_rc, file);
+    return m_rc;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] send_file_delta() : {} B of literals : {}\n",
+           literal, file);
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_range(Frange const& range)
+{
+  file::File const& file{ *range.file };
+  m_crc = 0; // checksum of the range only.
+  m_rc  = batch_hdr({ .hflags = proto::hf_range,
+                     .size   = range.len,
+                     .offset = range.off,
+                     .total  = file.size(),
+                     .name   = file.name().string() });
+  if (m_rc == 0) {
+    m_rc = send_batch();
+  }
+  if (m_rc == 0) {
+    m_rc = send_file_zc(file, static_cast<off_t>(range.off), range.len);
+  }
+  if (m_rc == 0 && crc() && range.len > 0) {
+    m_rc = batch_crc();
+  }
+  return m_rc;
+}
+
+void Fclient::read_ahead(file::File const& file, size_t const idx)
+{
+  if (!m_reader || file.data() != nullptr) { // nothing to read.
+    return;
+  }
+  size_t const off{ m_vplan.empty() ? 0 : m_vplan[idx] };
+  bool const delta{ idx < m_vdelta.size() &&
+                    m_vdelta[idx] != delta::Sigset::none };
+  // the same as in the send_one(): small files are read into the batch.
+  if (!delta && file.size() - off > cfg::batch_file_max) {
+    m_reader->add(file, off, file.size() - off);
+  }
+}
+
+void Fclient::prefetch(file::File const& file) noexcept
+{
+#ifdef POSIX_FADV_WILLNEED
+  if (file.data() != nullptr || file.size() == 0) {
+    return; // already in memory.
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    return; // not fatal, error is reported when the file is sent.
+  }
+  // asynchronous: initiates the readahead & returns right away.
+  auto const len{ static_cast<off_t>(std::min(file.size(), cfg::prefetch_max)) };
+  int const err{ posix_fadvise(fd_in, 0, len, POSIX_FADV_WILLNEED) };
+  if (err != 0) {
+    log_g.errnum(err, "[FAIL] prefetch() posix_fadvise()");
+  }
+  io::close_fd(fd_in, "prefetch() fd_in");
+#else
+  static_cast<void>(file);
+#endif // POSIX_FADV_WILLNEED
+}
+
+[[nodiscard]] int Fclient::batch_file(file::File const& file, size_t const off)
+{
+  WNDX_LOG(LL::INFO, "INSIDE batch_file() : {}\n", file);
+  size_t const len{ file.size() - off };
+  bool const mem{ file.data() != nullptr };
+  if (m_viov.size() >= cfg::batch_iov_max ||
+      (!mem && m_batch_len + len > cfg::chunk_size))
+  {
+    m_rc = send_batch();
+    if (m_rc != 0) {
+      return m_rc;
+    }
+  }
+  m_vbatch.push_back(&file);
+  if (len == 0) {
+    return 0; // nothing to send, but logged with the batch.
+  }
+  if (mem) { // already in memory => reference it.
+    // NOLINTNEXTLINE(*-const-cast) - sendmsg() does not modify the content.
+    m_viov.push_back({ const_cast<char*>(file.data()) + off, len });
+    if (crc()) {
+      m_crc = crc32c(m_crc, file.data() + off, len);
+    }
+    return 0;
+  }
+  // not in memory => read small file content into the batch buffer.
+  if (m_chunk.empty()) {
+    m_chunk.resize(cfg::chunk_size);
+  }
+  char* const dst{ m_chunk.data() + m_batch_len };
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    log_g.errnum(errno, "[FAIL] batch_file() open()");
+    return -1;
+  }
+  m_rc = io::pread_loop(fd_in, dst, len, static_cast<off_t>(off));
+  io::close_fd(fd_in, "batch_file() fd_in");
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] batch_file() in pread_loop() -> {} : {}\n",
+             m_rc, file);
+    return m_rc;
+  }
+  m_viov.push_back({ dst, len });
+  m_batch_len += len;
+  if (crc()) {
+    m_crc = crc32c(m_crc, dst, len);
+  }
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_batch()
+{
+  if (m_vbatch.empty() && m_viov.empty()) {
+    return 0;
+  }
+  WNDX_LOG(LL::DBUG, "INSIDE send_batch() : {} files in {} iovecs\n",
+           m_vbatch.size(), m_viov.size());
+  // headers are placed into the m_hdrs in the same order as in the batch.
+  char* hdr{ m_hdrs.data() };
+  for (auto& iov : m_viov) {
+    if (iov.iov_base == nullptr) {
+      iov.iov_base  = hdr;
+      hdr          += iov.iov_len;
+    }
+  }
+  m_rc = send_iov_loop(m_viov.data(), m_viov.size());
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_batch() in send_iov_loop() -> {}\n",
+             m_rc);
+    return m_rc;
+  }
+  for (auto const* file : m_vbatch) {
+    WNDX_LOG(LL::STAT, "[ OK ] send_file() : {}\n", *file);
+  }
+  m_viov.clear();
+  m_vbatch.clear();
+  m_hdrs.clear();
+  m_batch_len = 0;
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_iov_loop(struct iovec* iov, size_t iovcnt)
+{
+  struct msghdr msg{};
+  ssize_t       nbytes{ -1 }; // nbytes sent || -1 - error val. ref: send(2).
+  // loop till all bytes are sent or till the error.
+  while (iovcnt > 0) {
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = std::min(iovcnt, cfg::batch_iov_max);
+    // EPIPE instead of the SIGPIPE. (the client may be embedded: Asender)
+    nbytes         = sendmsg(m_fd, &msg, MSG_NOSIGNAL);
+    switch (nbytes) {
+    case -1:
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] sendmsg() error occurred");
+      return -1;
+    case 0:
+      WNDX_LOG(LL::CRIT, "[FAIL] sendmsg() -> 0 - nothing to send!\n");
+      return -2;
+    default: WNDX_LOG(LL::DBUG, "nbytes send_iov_loop() :  {}\n", nbytes);
+    }
+    // skip fully sent iovecs & advance the partially sent one.
+    auto n{ static_cast<size_t>(nbytes) };
+    while (iovcnt > 0 && n >= iov->iov_len) {
+      n -= iov->iov_len;
+      ++iov; // NOLINT(*-pointer-arithmetic)
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_file(file::File const& file, size_t const off)
 {
   WNDX_LOG(LL::INFO, "INSIDE send_file() : {}\n", file);
-  m_rc = send_loop(m_fd, file.memory(), file.size());
+  if (file.data() == nullptr) {
+    return send_file_zc(file, static_cast<off_t>(off), file.size() - off);
+  }
+  if (crc()) {
+    m_crc = crc32c(m_crc, file.data() + off, file.size() - off);
+  }
+  m_rc = io::send_loop(m_fd, file.data() + off, file.size() - off);
   if (m_rc != 0) {
     WNDX_LOG(LL::ERRO, "[FAIL] send_file() in send_loop() -> {} : {}\n", m_rc,
              file);
@@ -138,25 +915,177 @@ Fclient::send_files_info(std::vector<file::Finfo> const& vfinfo)
   return 0;
 }
 
-template <typename T>
-[[nodiscard]] int Fclient::send_loop(int fd, void const* buf, size_t len)
+[[nodiscard]] int Fclient::send_file_zc(file::File const& file,
+                                        off_t const offset, size_t const len)
 {
-  T const* bufptr{ static_cast<T const*>(buf) };
-  size_t   toread{ len };
-  ssize_t  nbytes{ -1 }; // nbytes sent || -1 - error val. ref: send(2).
-  // loop till all bytes are sent or till the error.
-  while ((nbytes = send(fd, bufptr, toread, 0)) > 0) {
+  if (m_reader) {
+    return send_file_ahead(file, static_cast<size_t>(offset), len);
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open(file.path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd_in == -1) {
+    log_g.errnum(errno, "[FAIL] send_file_zc() open()");
+    return -1;
+  }
+  off_t pos{ offset };
+  if (m_tmode == Tmode::CHUNKED) {
+#ifdef POSIX_FADV_SEQUENTIAL
+    // larger readahead window => disk reads overlap with the sends.
+    static_cast<void>(posix_fadvise(fd_in, offset, static_cast<off_t>(len),
+                                    POSIX_FADV_SEQUENTIAL));
+#endif // POSIX_FADV_SEQUENTIAL
+    m_rc = send_file_chunked(fd_in, pos, len);
+  } else {
+    m_rc = sendfile_loop(fd_in, pos, len);
+    if (m_rc == -3) {
+      WNDX_LOG(LL::INFO, "sendfile() is not supported, fallback to chunks\n");
+      m_rc = send_file_chunked(fd_in, pos, len);
+    } else if (m_rc == 0 && crc()) {
+      // content never reaches the user space => read again from the page
+      // cache, where it is after the sendfile().
+      m_rc = crc_file(file, static_cast<size_t>(offset), len);
+    }
+  }
+  io::close_fd(fd_in, "send_file_zc() fd_in");
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_file_zc() -> {} : {}\n", m_rc, file);
+    return m_rc;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] send_file_zc() : [{}, +{}) {}\n", offset, len,
+           file);
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_file_ahead(file::File const& file, size_t off,
+                                           size_t const len)
+{
+  m_rc = 0;
+  for (size_t const end{ off + len }; off < end && m_rc == 0;) {
+    Rchunk chunk;
+    m_rc = m_reader->next(file, off, chunk);
+    if (m_rc != 0) {
+      break;
+    }
+    if (crc()) {
+      m_crc = crc32c(m_crc, chunk.data, chunk.len);
+    }
+    m_rc  = io::send_loop(m_fd, chunk.data, chunk.len);
+    off  += chunk.len;
+    m_reader->release();
+  }
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] send_file_ahead() -> {} : {}\n", m_rc, file);
+    return m_rc;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] send_file_ahead() : [{}, +{}) {}\n", off - len,
+           len, file);
+  return 0;
+}
+
+[[nodiscard]] int Fclient::send_file_chunked(int fd_in, off_t offset,
+                                             size_t len)
+{
+  if (m_chunk.empty()) {
+    m_chunk.resize(cfg::chunk_size);
+  }
+  size_t left{ len };
+  while (left > 0) {
+    size_t const  toread{ std::min(left, m_chunk.size()) };
+    ssize_t const nbytes{ pread(fd_in, m_chunk.data(), toread, offset) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] pread() error occurred");
+      return -1;
+    }
+    if (nbytes == 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] pread() -> 0 - file was truncated!\n");
+      return -2;
+    }
+    if (crc()) {
+      m_crc = crc32c(m_crc, m_chunk.data(), static_cast<size_t>(nbytes));
+    }
+    m_rc = io::send_loop(m_fd, m_chunk.data(), static_cast<size_t>(nbytes));
+    if (m_rc != 0) {
+      return m_rc;
+    }
+    offset += nbytes;
+    left   -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+[[nodiscard]] int Fclient::sendfile_loop(int fd_in, off_t& offset, size_t len)
+{
+#ifdef __linux__
+  size_t  left{ len };
+  ssize_t nbytes{ -1 }; // nbytes sent || -1 - error val. ref: sendfile(2).
+  while (left > 0) {
+    nbytes = sendfile(m_fd, fd_in, &offset, left);
     switch (nbytes) {
-    case -1: log_g.errnum(errno, "[FAIL] send() error occurred"); return -1;
+    case -1:
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      // not supported for this kind of fd => signify about the fallback.
+      if ((errno == EINVAL || errno == ENOSYS) && left == len) {
+        return -3;
+      }
+      log_g.errnum(errno, "[FAIL] sendfile() error occurred");
+      return -1;
     case 0:
-      WNDX_LOG(LL::CRIT, "[FAIL] send() -> 0 - nothing to send!\n");
+      WNDX_LOG(LL::ERRO, "[FAIL] sendfile() -> 0 - file was truncated!\n");
       return -2;
-    default: WNDX_LOG(LL::DBUG, "nbytes send_loop() :  {}\n", nbytes);
+    default: WNDX_LOG(LL::DBUG, "nbytes sendfile_loop() : {}\n", nbytes);
     }
-    bufptr += nbytes;                      // next position to send into
-    toread -= static_cast<size_t>(nbytes); // send less next time
+    left -= static_cast<size_t>(nbytes); // offset is updated by sendfile()
   }
-  WNDX_LOG(LL::DBUG, "[ OK ] send_loop() finished\n");
+  WNDX_LOG(LL::DBUG, "[ OK ] sendfile_loop() finished\n");
+  return 0;
+#else  // not supported platforms
+  static_cast<void>(fd_in);
+  static_cast<void>(offset);
+  static_cast<void>(len);
+  return -3;
+#endif // __linux__
+}
+
+[[nodiscard]] int Fclient::negotiate(u32 const flags)
+{
+  proto::Hello hello{};
+  // resumed content must come from the same source. (see: src_id())
+  hello.flags = (flags & proto::fl_resume) != 0 ? flags | proto::fl_src
+                                                : flags;
+  hello.uid   = cfg::def_uid;
+  std::string buf;
+  proto::encode(buf, hello);
+  m_rc = io::send_loop(m_fd, buf.data(), buf.size());
+  if (m_rc != 0) {
+    return -1;
+  }
+  buf.assign(proto::hello_ack_len, '\0');
+  m_rc = io::recv_loop(m_fd, buf.data(), buf.size());
+  if (m_rc != 0) {
+    return -1;
+  }
+  proto::Hello ack{};
+  size_t       n{ 0 };
+  if (proto::decode_ack(buf.data(), buf.size(), ack, n) != proto::Pres::OK ||
+      ack.version == 0 || ack.version > proto::version ||
+      (ack.flags & ~hello.flags) != 0)
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] negotiate() - invalid HelloAck\n");
+    return -1;
+  }
+  m_version = ack.version;
+  m_flags   = ack.flags;
+  codec::Ctype const ctype{ codec::from_flags(m_flags) };
+  if (ctype != codec::Ctype::NONE) {
+    m_codec = std::make_unique<codec::Codec>(ctype, m_level);
+  }
+  WNDX_LOG(LL::INFO, "[ OK ] negotiate() : v{} flags {:#x}\n", m_version,
+           m_flags);
   return 0;
 }
 
@@ -191,7 +1120,7 @@ template <typename T>
 }
 
 
-[[nodiscard]] rc Fclient::init()
+[[nodiscard]] rc Fclient::init(u32 const flags)
 {
   static constexpr auto fn{ "Fclient::init()" };
   m_rc = create_socket();
@@ -212,6 +1141,18 @@ template <typename T>
     return rc::UNIX_SOCK_CONN_ERRO;
   }
 
+  // long-lived session may be idle for long => detect the dead server.
+  if ((flags & proto::fl_batches) != 0) {
+    static_cast<void>(io::set_keepalive(m_fd));
+  }
+
+  // compression is requested only if the codec is built in.
+  m_rc = negotiate(flags | (codec::to_flag(m_ctype) & codec::available()));
+  if (m_rc != 0) {
+    WNDX_LOG(LL::ERRO, "{} : negotiate()\n", fn);
+    return rc::UNIX_SOCK_RECV_ERRO;
+  }
+
   WNDX_LOG(LL::STAT, "{} - client initialized\n", fn);
   return rc::SUCCESS;
 }
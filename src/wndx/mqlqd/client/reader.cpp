@@ -0,0 +1,154 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/reader.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+extern "C" {
+
+#include <fcntl.h> // open(2), posix_fadvise(2)
+
+} // extern "C"
+
+namespace wndx::mqlqd {
+
+Reader::Reader(size_t const budget, unsigned const threads)
+    : m_vslots(std::max<size_t>(budget / cfg::chunk_size, 2))
+{
+  for (auto& slot : m_vslots) {
+    slot.buf.resize(cfg::chunk_size);
+  }
+  unsigned const n{ static_cast<unsigned>(
+      std::clamp<size_t>(threads, 1, m_vslots.size())) };
+  m_vthreads.reserve(n);
+  for (unsigned i = 0; i < n; ++i) {
+    m_vthreads.emplace_back([this] { run(); });
+  }
+  WNDX_LOG(LL::INFO, "[ OK ] Reader : {} buffers of {} B, {} threads\n",
+           m_vslots.size(), cfg::chunk_size, n);
+}
+
+Reader::~Reader() noexcept
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_stop = true;
+  }
+  m_cv_read.notify_all();
+  m_vthreads.clear(); // join.
+}
+
+void Reader::add(file::File const& file, size_t const off, size_t const len)
+{
+  if (len == 0) {
+    return;
+  }
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_jobs.push_back({ .file = &file, .off = off, .len = len });
+  }
+  m_cv_read.notify_all();
+}
+
+[[nodiscard]] int Reader::next(file::File const& file, size_t const off,
+                               Rchunk& chunk)
+{
+  std::unique_lock lock{ m_mtx };
+  Rslot&           slot{ m_vslots[m_taken % m_vslots.size()] };
+  m_cv_sent.wait(lock, [this, &slot] {
+    return slot.state == Rstate::READY ||
+           (m_taken == m_claimed && m_jobs.empty());
+  });
+  if (slot.state != Rstate::READY) {
+    WNDX_LOG(LL::ERRO, "[FAIL] Reader::next() - not queued : [{}] {}\n", off,
+             file);
+    return -1;
+  }
+  if (slot.chunk.file != &file || slot.chunk.off != off) {
+    WNDX_LOG(LL::ERRO, "[FAIL] Reader::next() - out of order : [{}] {}\n",
+             off, file);
+    return -1;
+  }
+  chunk = slot.chunk;
+  return slot.err;
+}
+
+void Reader::release() noexcept
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_vslots[m_taken++ % m_vslots.size()].state = Rstate::FREE;
+  }
+  m_cv_read.notify_all();
+}
+
+void Reader::run()
+{
+  int               fd{ -1 };
+  file::File const* opened{ nullptr }; // file of the fd.
+  std::unique_lock  lock{ m_mtx };
+  while (true) {
+    m_cv_read.wait(lock, [this] {
+      return m_stop ||
+             (!m_jobs.empty() &&
+              m_vslots[m_claimed % m_vslots.size()].state == Rstate::FREE);
+    });
+    if (m_stop) {
+      break;
+    }
+    Rslot& slot{ m_vslots[m_claimed++ % m_vslots.size()] };
+    claim(slot);
+    lock.unlock(); // the slot is owned till it is READY.
+
+    Rchunk const& chunk{ slot.chunk };
+    if (opened != chunk.file) {
+      io::close_fd(fd, "Reader fd");
+      opened = chunk.file;
+      // NOLINTNEXTLINE(*-vararg)
+      fd = open(chunk.file->path().c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd == -1) {
+        log_g.errnum(errno, "[FAIL] Reader open()");
+        opened = nullptr;
+      }
+#ifdef POSIX_FADV_SEQUENTIAL
+      else {
+        static_cast<void>(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL));
+      }
+#endif // POSIX_FADV_SEQUENTIAL
+    }
+    int const err{ fd == -1 ? -1
+                            : io::pread_loop(fd, slot.buf.data(), chunk.len,
+                                             static_cast<off_t>(chunk.off)) };
+
+    lock.lock();
+    slot.err   = err;
+    slot.state = Rstate::READY;
+    m_cv_sent.notify_one();
+  }
+  lock.unlock();
+  io::close_fd(fd, "Reader fd");
+}
+
+void Reader::claim(Rslot& slot)
+{
+  Rchunk&      job{ m_jobs.front() };
+  size_t const len{ std::min(job.len, slot.buf.size()) };
+  slot.chunk = { .file = job.file,
+                 .off  = job.off,
+                 .len  = len,
+                 .data = slot.buf.data() };
+  slot.state = Rstate::READING;
+  slot.err   = 0;
+  job.off   += len;
+  job.len   -= len;
+  if (job.len == 0) {
+    m_jobs.pop_front();
+  }
+}
+
+} // namespace wndx::mqlqd
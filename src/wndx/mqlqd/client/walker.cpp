@@ -0,0 +1,276 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/walker.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+extern "C" {
+
+#include <dirent.h>   // struct dirent64, DT_*
+#include <fcntl.h>    // open(2), fstatat(2)
+#include <sys/stat.h> // stat(2)
+#include <unistd.h>   // close(2)
+
+#ifdef __linux__
+#include <sys/syscall.h> // SYS_getdents64 - Linux specific
+#endif // __linux__
+
+} // extern "C"
+
+namespace wndx::mqlqd {
+
+Walker::Walker(unsigned const threads) noexcept
+    : m_threads{ std::clamp(threads != 0 ? threads
+                                         : std::thread::hardware_concurrency(),
+                            1U, cfg::walk_threads_max) }
+{
+  m_vqueues.reserve(m_threads);
+  for (unsigned i = 0; i < m_threads; ++i) {
+    m_vqueues.push_back(std::make_unique<Wqueue>());
+  }
+}
+
+Walker::~Walker() noexcept
+{
+  m_stop = true;
+  wake(true);
+  m_vthreads.clear(); // join.
+}
+
+void Walker::walk(std::vector<fs::path> const& vroots)
+{
+  std::vector<file::File> vfound;
+  size_t                  idx{ 0 };
+  for (auto const& root : vroots) {
+    struct stat st{};
+    if (::stat(root.c_str(), &st) == -1) {
+      log_g.errnum(errno, fmt::format("[FAIL] walk() stat() : {}", root));
+      ++m_errors;
+      continue;
+    }
+    // name of the root is its last component. (even "dir/", ".")
+    std::error_code ec;
+    fs::path        abs{ fs::absolute(root, ec).lexically_normal() };
+    if (!abs.has_filename()) {
+      abs = abs.parent_path();
+    }
+    if (S_ISDIR(st.st_mode)) {
+      ++m_pending;
+      ++m_queued; // before it is visible => never below 0 by the take().
+      m_vqueues[idx++ % m_threads]->tasks.push_back({ root, abs.filename() });
+    } else if (S_ISREG(st.st_mode)) {
+      vfound.emplace_back(root, static_cast<size_t>(st.st_size),
+                          abs.filename());
+    } else {
+      WNDX_LOG(LL::WARN, "walk() : not a regular file, skipped : {}\n", root);
+    }
+  }
+  found(vfound);
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_running = m_threads;
+  }
+  m_vthreads.reserve(m_threads);
+  for (size_t id = 0; id < m_threads; ++id) {
+    m_vthreads.emplace_back([this, id] { run(id); });
+  }
+}
+
+[[nodiscard]] bool Walker::next(std::deque<file::File>& vfiles)
+{
+  std::unique_lock lock{ m_mtx };
+  m_cv.wait(lock, [this] { return !m_vfound.empty() || m_running == 0; });
+  if (m_vfound.empty()) {
+    return false;
+  }
+  for (auto& file : m_vfound) {
+    vfiles.push_back(std::move(file));
+  }
+  m_vfound.clear();
+  return true;
+}
+
+void Walker::run(size_t const id)
+{
+  std::vector<char>       buf(cfg::walk_buf_size);
+  std::vector<file::File> vfound;
+  Wtask                   task;
+  while (!m_stop) {
+    if (take(id, task)) {
+      scan(id, task, buf, vfound);
+      found(vfound);
+      if (--m_pending == 0) { // after its sub-dirs are queued.
+        wake(true);
+      }
+      continue;
+    }
+    if (m_pending == 0) {
+      break;
+    }
+    // the others are about to queue the sub-dirs, or to finish the walk.
+    std::unique_lock lock{ m_mtx };
+    ++m_idle;
+    m_cv_idle.wait(lock, [this] {
+      return m_stop || m_queued != 0 || m_pending == 0;
+    });
+    --m_idle;
+  }
+  std::lock_guard const lock{ m_mtx };
+  if (--m_running == 0) {
+    WNDX_LOG(LL::NTFY, "[ OK ] walk finished : {} files, {} errors\n",
+             m_nfound, m_errors.load());
+  }
+  m_cv.notify_all();
+}
+
+[[nodiscard]] bool Walker::take(size_t const id, Wtask& task)
+{
+  {
+    Wqueue&               own{ *m_vqueues[id] };
+    std::lock_guard const lock{ own.mtx };
+    if (!own.tasks.empty()) { // depth first => the dir is still in the cache.
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+  for (size_t k = 1; k < m_threads; ++k) {
+    Wqueue&               other{ *m_vqueues[(id + k) % m_threads] };
+    std::lock_guard const lock{ other.mtx };
+    if (!other.tasks.empty()) { // the largest subtrees are the oldest.
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+      --m_queued;
+      return true;
+    }
+  }
+  return false;
+}
+
+void Walker::scan(size_t const id, Wtask const& task, std::vector<char>& buf,
+                  std::vector<file::File>& vfound)
+{
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  int fd{ open(task.dir.c_str(),
+               O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC) };
+  if (fd == -1) {
+    log_g.errnum(errno, fmt::format("[FAIL] walk open() : {}", task.dir));
+    ++m_errors;
+    return;
+  }
+  auto const entry{ [&](char const* name, unsigned char type) {
+    sv_t const sname{ name };
+    if (sname == "." || sname == "..") {
+      return;
+    }
+    struct stat st{};
+    if (type == DT_REG || type == DT_UNKNOWN) { // size (& type) by the stat.
+      if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+        log_g.errnum(errno, fmt::format("[FAIL] walk fstatat() : {}",
+                                        task.dir / sname));
+        ++m_errors;
+        return;
+      }
+      type = S_ISREG(st.st_mode)   ? DT_REG
+             : S_ISDIR(st.st_mode) ? DT_DIR
+                                   : DT_UNKNOWN;
+    }
+    if (type == DT_DIR) {
+      ++m_pending;
+      ++m_queued;
+      {
+        Wqueue&               own{ *m_vqueues[id] };
+        std::lock_guard const lock{ own.mtx };
+        own.tasks.push_back({ task.dir / sname, task.rel / sname });
+      }
+      wake(false);
+    } else if (type == DT_REG) {
+      vfound.emplace_back(task.dir / sname, static_cast<size_t>(st.st_size),
+                          task.rel / sname);
+    } else {
+      WNDX_LOG(LL::DBUG, "walk() : not a regular file, skipped : {}\n",
+               task.dir / sname);
+    }
+  } };
+#ifdef __linux__
+  // raw dir entries => no per-entry allocations of the readdir(3).
+  for (;;) {
+    long const n{ syscall(SYS_getdents64, fd, buf.data(), buf.size()) };
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1) {
+      log_g.errnum(errno, fmt::format("[FAIL] walk getdents64() : {}",
+                                      task.dir));
+      ++m_errors;
+      break;
+    }
+    if (n == 0) {
+      break;
+    }
+    for (long off = 0; off < n;) {
+      // NOLINTNEXTLINE(*-reinterpret-cast, *-pointer-arithmetic)
+      auto const* d{ reinterpret_cast<struct dirent64 const*>(buf.data() + off) };
+      off += d->d_reclen;
+      // NOLINTNEXTLINE(*-array-to-pointer-decay, hicpp-no-array-decay)
+      entry(d->d_name, d->d_type);
+    }
+  }
+  io::close_fd(fd, "walk fd");
+#else  // portable: readdir(3)
+  static_cast<void>(buf);
+  DIR* dir{ fdopendir(fd) }; // owns the fd.
+  if (dir == nullptr) {
+    log_g.errnum(errno, "[FAIL] walk fdopendir()");
+    io::close_fd(fd, "walk fd");
+    ++m_errors;
+    return;
+  }
+  while (struct dirent const* d{ readdir(dir) }) {
+    // NOLINTNEXTLINE(*-array-to-pointer-decay, hicpp-no-array-decay)
+    entry(d->d_name, d->d_type);
+  }
+  closedir(dir);
+#endif // __linux__
+}
+
+void Walker::found(std::vector<file::File>& vfound)
+{
+  if (vfound.empty()) {
+    return;
+  }
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_nfound += vfound.size();
+    for (auto& file : vfound) {
+      m_vfound.push_back(std::move(file));
+    }
+  }
+  vfound.clear();
+  m_cv.notify_one();
+}
+
+void Walker::wake(bool const all) noexcept
+{
+  // the idle thread counts itself before it checks the m_queued/m_pending
+  // => either it sees the change or it is seen here. (no lost wake-ups)
+  if (m_idle == 0) {
+    return;
+  }
+  {
+    std::lock_guard const lock{ m_mtx };
+  }
+  if (all) {
+    m_cv_idle.notify_all();
+  } else {
+    m_cv_idle.notify_one();
+  }
+}
+
+} // namespace wndx::mqlqd
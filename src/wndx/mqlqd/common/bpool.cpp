@@ -0,0 +1,137 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/bpool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <utility>
+
+extern "C" {
+
+#include <sys/mman.h> // mmap(2), madvise(2)
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// \brief map anonymous memory, backed by the huge pages if it is large.
+[[nodiscard]] char* map_block(size_t const size, size_t const huge) noexcept
+{
+  void*      addr{ MAP_FAILED };
+  bool const large{ size >= huge && size % huge == 0 };
+#ifdef MAP_HUGETLB
+  if (large) { // reserved huge pages only => fails quickly without them.
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+#endif // MAP_HUGETLB
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      log_g.errnum(errno, "[FAIL] Bpool mmap()");
+      return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (large) {
+      static_cast<void>(madvise(addr, size, MADV_HUGEPAGE));
+    }
+#endif // MADV_HUGEPAGE
+  }
+  return static_cast<char*>(addr);
+}
+
+void unmap_block(char* data, size_t const size) noexcept
+{
+  if (munmap(data, size) == -1) {
+    log_g.errnum(errno, "[FAIL] Bpool munmap()");
+  }
+}
+
+} // namespace
+
+Buf::~Buf() noexcept
+{
+  if (m_pool != nullptr) {
+    m_pool->give(m_data, m_size);
+  }
+}
+
+Buf::Buf(Buf&& other) noexcept
+    : m_pool{ std::exchange(other.m_pool, nullptr) }
+    , m_data{ std::exchange(other.m_data, nullptr) }
+    , m_size{ std::exchange(other.m_size, 0) }
+{
+}
+
+Buf& Buf::operator=(Buf&& other) noexcept
+{
+  if (this != &other) {
+    if (m_pool != nullptr) {
+      m_pool->give(m_data, m_size);
+    }
+    m_pool = std::exchange(other.m_pool, nullptr);
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+  }
+  return *this;
+}
+
+Bpool::Bpool(size_t const keep_max) noexcept
+    : m_keep_max{ keep_max }
+{
+}
+
+Bpool::~Bpool() noexcept
+{
+  for (size_t k = 0; k < m_vfree.size(); ++k) {
+    for (char* data : m_vfree[k]) {
+      unmap_block(data, size_t{ 1 } << k);
+    }
+  }
+  WNDX_LOG(LL::DBUG, "~Bpool() : {} hits, {} misses\n", m_hits, m_misses);
+}
+
+[[nodiscard]] size_t Bpool::class_size(size_t const size) noexcept
+{
+  return std::bit_ceil(std::max(size, page_size));
+}
+
+[[nodiscard]] Buf Bpool::take(size_t const size)
+{
+  size_t const csize{ class_size(size) };
+  auto&        vfree{ m_vfree[std::countr_zero(csize)] };
+  if (!vfree.empty()) {
+    char* const data{ vfree.back() };
+    vfree.pop_back();
+    m_kept -= csize;
+    ++m_hits;
+    return Buf{ this, data, csize };
+  }
+  char* const data{ map_block(csize, huge_page_size) };
+  if (data == nullptr) {
+    return Buf{};
+  }
+  ++m_misses;
+  return Buf{ this, data, csize };
+}
+
+void Bpool::give(char* data, size_t const size) noexcept
+{
+  if (m_kept + size > m_keep_max) {
+    unmap_block(data, size);
+    return;
+  }
+  try {
+    m_vfree[std::countr_zero(size)].push_back(data);
+    m_kept += size;
+  } catch (...) { // bad_alloc
+    unmap_block(data, size);
+  }
+}
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,202 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/codec.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/proto.hpp"
+
+#include <fmt/format.h>
+
+#include <climits>
+
+// clang-format off
+#ifndef MQLQD_HAS_ZSTD
+#define MQLQD_HAS_ZSTD 0 // NOLINT(*-macro-usage)
+#endif//MQLQD_HAS_ZSTD
+
+#ifndef MQLQD_HAS_LZ4
+#define MQLQD_HAS_LZ4 0 // NOLINT(*-macro-usage)
+#endif//MQLQD_HAS_LZ4
+// clang-format on
+
+extern "C" {
+
+#if MQLQD_HAS_ZSTD
+#include <zstd.h>
+#endif // MQLQD_HAS_ZSTD
+
+#if MQLQD_HAS_LZ4
+#include <lz4.h>
+#endif // MQLQD_HAS_LZ4
+
+} // extern "C"
+
+
+namespace wndx::mqlqd::codec {
+
+[[nodiscard]] u32 available() noexcept
+{
+  u32 flags{ proto::fl_none };
+#if MQLQD_HAS_ZSTD
+  flags |= proto::fl_zstd;
+#endif // MQLQD_HAS_ZSTD
+#if MQLQD_HAS_LZ4
+  flags |= proto::fl_lz4;
+#endif // MQLQD_HAS_LZ4
+  return flags;
+}
+
+[[nodiscard]] u32 to_flag(Ctype const ctype) noexcept
+{
+  switch (ctype) {
+  case Ctype::ZSTD: return proto::fl_zstd;
+  case Ctype::LZ4 : return proto::fl_lz4;
+  case Ctype::NONE: break;
+  }
+  return proto::fl_none;
+}
+
+[[nodiscard]] Ctype from_flags(u32 const flags) noexcept
+{
+  if ((flags & proto::fl_zstd) != 0) {
+    return Ctype::ZSTD;
+  }
+  if ((flags & proto::fl_lz4) != 0) {
+    return Ctype::LZ4;
+  }
+  return Ctype::NONE;
+}
+
+[[nodiscard]] int parse(sv_t const name, Ctype& ctype) noexcept
+{
+  if (name == "zstd") {
+    ctype = Ctype::ZSTD;
+  } else if (name == "lz4") {
+    ctype = Ctype::LZ4;
+  } else if (name == "none") {
+    ctype = Ctype::NONE;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+Codec::Codec(Ctype const ctype, int const level) noexcept
+    : m_ctype{ ctype }
+    , m_level{ level }
+{
+}
+
+Codec::~Codec() noexcept
+{
+#if MQLQD_HAS_ZSTD
+  ZSTD_freeCCtx(m_cctx);
+  ZSTD_freeDCtx(m_dctx);
+#endif // MQLQD_HAS_ZSTD
+}
+
+[[nodiscard]] size_t Codec::bound(size_t const len) const noexcept
+{
+  switch (m_ctype) {
+#if MQLQD_HAS_ZSTD
+  case Ctype::ZSTD: return ZSTD_compressBound(len);
+#endif // MQLQD_HAS_ZSTD
+#if MQLQD_HAS_LZ4
+  case Ctype::LZ4:
+    return static_cast<size_t>(LZ4_compressBound(static_cast<int>(len)));
+#endif // MQLQD_HAS_LZ4
+  default: return len;
+  }
+}
+
+[[nodiscard]] size_t Codec::compress(char const* src, size_t const len,
+                                     char* dst, size_t const cap)
+{
+  size_t clen{ 0 };
+  switch (m_ctype) {
+#if MQLQD_HAS_ZSTD
+  case Ctype::ZSTD:
+    if (m_cctx == nullptr && (m_cctx = ZSTD_createCCtx()) == nullptr) {
+      return 0;
+    }
+    clen = ZSTD_compressCCtx(m_cctx, dst, cap, src, len, m_level);
+    if (ZSTD_isError(clen) != 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] ZSTD_compressCCtx() : {}\n",
+               ZSTD_getErrorName(clen));
+      return 0;
+    }
+    break;
+#endif // MQLQD_HAS_ZSTD
+#if MQLQD_HAS_LZ4
+  case Ctype::LZ4: {
+    if (len > LZ4_MAX_INPUT_SIZE || cap > INT_MAX) {
+      return 0;
+    }
+    if (m_lz4_state.empty()) {
+      m_lz4_state.resize(static_cast<size_t>(LZ4_sizeofState()));
+    }
+    int const n{ LZ4_compress_fast_extState(m_lz4_state.data(), src, dst,
+                                            static_cast<int>(len),
+                                            static_cast<int>(cap), 1) };
+    clen = n > 0 ? static_cast<size_t>(n) : 0;
+    break;
+  }
+#endif // MQLQD_HAS_LZ4
+  default:
+    static_cast<void>(src);
+    static_cast<void>(dst);
+    static_cast<void>(cap);
+    return 0;
+  }
+  return clen < len ? clen : 0;
+}
+
+[[nodiscard]] int Codec::decompress(char const* src, size_t const clen,
+                                    char* dst, size_t const raw)
+{
+  switch (m_ctype) {
+#if MQLQD_HAS_ZSTD
+  case Ctype::ZSTD: {
+    if (m_dctx == nullptr && (m_dctx = ZSTD_createDCtx()) == nullptr) {
+      return -1;
+    }
+    size_t const n{ ZSTD_decompressDCtx(m_dctx, dst, raw, src, clen) };
+    if (ZSTD_isError(n) != 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] ZSTD_decompressDCtx() : {}\n",
+               ZSTD_getErrorName(n));
+      return -1;
+    }
+    return n == raw ? 0 : -1;
+  }
+#endif // MQLQD_HAS_ZSTD
+#if MQLQD_HAS_LZ4
+  case Ctype::LZ4: {
+    if (clen > INT_MAX || raw > INT_MAX) {
+      return -1;
+    }
+    int const n{ LZ4_decompress_safe(src, dst, static_cast<int>(clen),
+                                     static_cast<int>(raw)) };
+    return n >= 0 && static_cast<size_t>(n) == raw ? 0 : -1;
+  }
+#endif // MQLQD_HAS_LZ4
+  default:
+    static_cast<void>(src);
+    static_cast<void>(clen);
+    static_cast<void>(dst);
+    static_cast<void>(raw);
+    WNDX_LOG(LL::ERRO, "[FAIL] decompress() - codec is not available\n");
+    return -1;
+  }
+}
+
+[[nodiscard]] bool Codec::worth(char const* sample, size_t const len)
+{
+  if (m_ctype == Ctype::NONE || len == 0) {
+    return false;
+  }
+  m_scratch.resize(bound(len));
+  size_t const clen{ compress(sample, len, m_scratch.data(), m_scratch.size()) };
+  return clen != 0 && clen * 100 <= len * cfg::comp_ratio_max;
+}
+
+} // namespace wndx::mqlqd::codec
@@ -0,0 +1,211 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/crc32c.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MQLQD_CRC32C_X86 1
+#include <nmmintrin.h> // _mm_crc32_u64() - enabled per function. (target)
+#endif // __x86_64__
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+constexpr u32 poly{ 0x82F63B78U }; // 0x1EDC6F41 reflected.
+
+/// \brief little-endian load. (checksum must not depend on the host)
+template <typename T>
+[[nodiscard]] T load_le(char const* p) noexcept
+{
+  T v{ 0 };
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    // NOLINTNEXTLINE(*-pointer-arithmetic)
+    v |= static_cast<T>(static_cast<T>(static_cast<u8>(p[i])) << (8U * i));
+  }
+  return v;
+}
+
+/// slicing-by-8: [k][b] - crc of the byte b followed by the k zero bytes.
+using Table = std::array<std::array<u32, 256>, 8>; // NOLINT(*-magic-numbers)
+
+// NOLINTBEGIN(*-magic-numbers, *-constant-array-index)
+[[nodiscard]] constexpr Table make_table() noexcept
+{
+  Table t{};
+  for (u32 b = 0; b < 256; ++b) {
+    u32 crc{ b };
+    for (int i = 0; i < 8; ++i) {
+      crc = (crc >> 1U) ^ ((crc & 1U) != 0 ? poly : 0U);
+    }
+    t[0][b] = crc;
+  }
+  for (size_t k = 1; k < t.size(); ++k) {
+    for (size_t b = 0; b < 256; ++b) {
+      t[k][b] = (t[k - 1][b] >> 8U) ^ t[0][t[k - 1][b] & 0xFFU];
+    }
+  }
+  return t;
+}
+
+constexpr Table table{ make_table() };
+
+[[nodiscard]] u32 crc_sw(u32 crc, char const* p, size_t len) noexcept
+{
+  u32 c{ ~crc };
+  for (; len >= 8; p += 8, len -= 8) { // NOLINT(*-pointer-arithmetic)
+    u64 const v{ load_le<u64>(p) ^ c };
+    c = table[7][v & 0xFFU] ^ table[6][(v >> 8U) & 0xFFU] ^
+        table[5][(v >> 16U) & 0xFFU] ^ table[4][(v >> 24U) & 0xFFU] ^
+        table[3][(v >> 32U) & 0xFFU] ^ table[2][(v >> 40U) & 0xFFU] ^
+        table[1][(v >> 48U) & 0xFFU] ^ table[0][v >> 56U];
+  }
+  for (; len > 0; ++p, --len) { // NOLINT(*-pointer-arithmetic)
+    c = (c >> 8U) ^ table[0][(c ^ static_cast<u8>(*p)) & 0xFFU];
+  }
+  return ~c;
+}
+// NOLINTEND(*-magic-numbers, *-constant-array-index)
+
+#ifdef MQLQD_CRC32C_X86
+
+/// three independent crc32 streams hide the latency of the instruction,
+/// lanes are combined by shifting the crc over the zeros of the lane length.
+constexpr size_t lane_long{ 8192 };
+constexpr size_t lane_short{ 256 };
+
+/// \brief operator "append len zero bytes to the crc" (GF(2) 32x32 matrix),
+/// split into the per-byte tables. (len - power of two)
+using Shift = std::array<std::array<u32, 256>, 4>; // NOLINT(*-magic-numbers)
+using Mat   = std::array<u32, 32>;                  // NOLINT(*-magic-numbers)
+
+// NOLINTBEGIN(*-magic-numbers, *-constant-array-index)
+[[nodiscard]] constexpr u32 mat_times(Mat const& mat, u32 vec) noexcept
+{
+  u32 sum{ 0 };
+  for (size_t i = 0; vec != 0; vec >>= 1U, ++i) {
+    sum ^= (vec & 1U) != 0 ? mat[i] : 0U;
+  }
+  return sum;
+}
+
+[[nodiscard]] constexpr Mat mat_square(Mat const& mat) noexcept
+{
+  Mat sq{};
+  for (size_t i = 0; i < sq.size(); ++i) {
+    sq[i] = mat_times(mat, mat[i]);
+  }
+  return sq;
+}
+
+[[nodiscard]] constexpr Shift make_shift(size_t len) noexcept
+{
+  Mat op{}; // one zero bit.
+  op[0] = poly;
+  for (size_t i = 1; i < op.size(); ++i) {
+    op[i] = 1U << (i - 1);
+  }
+  // one zero byte, then doubled till the len.
+  op = mat_square(mat_square(mat_square(op)));
+  for (; len > 1; len >>= 1U) {
+    op = mat_square(op);
+  }
+  Shift s{};
+  for (u32 b = 0; b < 256; ++b) {
+    for (size_t k = 0; k < s.size(); ++k) {
+      s[k][b] = mat_times(op, b << (8U * k));
+    }
+  }
+  return s;
+}
+
+constexpr Shift shift_long{ make_shift(lane_long) };
+constexpr Shift shift_short{ make_shift(lane_short) };
+
+[[nodiscard]] u64 shift(Shift const& s, u64 const crc) noexcept
+{
+  return s[0][crc & 0xFFU] ^ s[1][(crc >> 8U) & 0xFFU] ^
+         s[2][(crc >> 16U) & 0xFFU] ^ s[3][(crc >> 24U) & 0xFFU];
+}
+// NOLINTEND(*-magic-numbers, *-constant-array-index)
+
+[[nodiscard]] u64 load(char const* p) noexcept
+{
+  u64 v{ 0 };
+  std::memcpy(&v, p, sizeof(v)); // x86 is little-endian.
+  return v;
+}
+
+// NOLINTBEGIN(*-pointer-arithmetic)
+__attribute__((target("sse4.2"))) [[nodiscard]] u64
+lanes(u64 c0, char const*& p, size_t& len, size_t const lane,
+      Shift const& s) noexcept
+{
+  while (len >= lane * 3) {
+    u64 c1{ 0 };
+    u64 c2{ 0 };
+    for (char const* end{ p + lane }; p < end; p += sizeof(u64)) {
+      c0 = _mm_crc32_u64(c0, load(p));
+      c1 = _mm_crc32_u64(c1, load(p + lane));
+      c2 = _mm_crc32_u64(c2, load(p + lane * 2));
+    }
+    c0   = shift(s, c0) ^ c1;
+    c0   = shift(s, c0) ^ c2;
+    p   += lane * 2;
+    len -= lane * 3;
+  }
+  return c0;
+}
+
+__attribute__((target("sse4.2"))) [[nodiscard]] u32
+crc_hw(u32 crc, char const* p, size_t len) noexcept
+{
+  u64 c{ ~crc };
+  for (; len > 0 && (reinterpret_cast<uintptr_t>(p) & 7U) != 0; ++p, --len) {
+    c = _mm_crc32_u8(static_cast<u32>(c), static_cast<u8>(*p));
+  }
+  c = lanes(c, p, len, lane_long, shift_long);
+  c = lanes(c, p, len, lane_short, shift_short);
+  for (; len >= sizeof(u64); p += sizeof(u64), len -= sizeof(u64)) {
+    c = _mm_crc32_u64(c, load(p));
+  }
+  for (; len > 0; ++p, --len) {
+    c = _mm_crc32_u8(static_cast<u32>(c), static_cast<u8>(*p));
+  }
+  return ~static_cast<u32>(c);
+}
+// NOLINTEND(*-pointer-arithmetic)
+
+#endif // MQLQD_CRC32C_X86
+
+using Impl = u32 (*)(u32, char const*, size_t) noexcept;
+
+/// \brief implementation supported by the CPU. (selected once)
+[[nodiscard]] Impl impl() noexcept
+{
+#ifdef MQLQD_CRC32C_X86
+  static Impl const fn{ __builtin_cpu_supports("sse4.2") ? crc_hw : crc_sw };
+  return fn;
+#else
+  return crc_sw;
+#endif // MQLQD_CRC32C_X86
+}
+
+} // namespace
+
+[[nodiscard]] u32 crc32c(u32 const crc, char const* data,
+                         size_t const len) noexcept
+{
+  return impl()(crc, data, len);
+}
+
+[[nodiscard]] bool crc32c_hw() noexcept
+{
+  return impl() != crc_sw;
+}
+
+} // namespace wndx::mqlqd
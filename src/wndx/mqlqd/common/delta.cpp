@@ -0,0 +1,200 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/delta.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/io.hpp"
+#include "wndx/mqlqd/proto.hpp"
+#include "wndx/mqlqd/xxh64.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+extern "C" {
+
+#include <sys/types.h> // off_t
+
+} // extern "C"
+
+
+namespace wndx::mqlqd::delta {
+
+[[nodiscard]] u64 block_size(u64 const size) noexcept
+{
+  static constexpr u64 align{ 1024 };
+  auto const root{ static_cast<u64>(std::sqrt(static_cast<double>(size))) };
+  return std::clamp<u64>((root + align - 1) / align * align,
+                         cfg::delta_block_min, proto::block_max);
+}
+
+void Rsum::init(char const* data, size_t const len) noexcept
+{
+  m_a   = 0;
+  m_b   = 0;
+  m_len = static_cast<u32>(len);
+  for (size_t i = 0; i < len; ++i) {
+    m_a += static_cast<u8>(data[i]); // NOLINT(*-pointer-arithmetic)
+    m_b += m_a;
+  }
+}
+
+void Rsum::roll(char const out, char const in) noexcept
+{
+  m_a += static_cast<u8>(in);
+  m_a -= static_cast<u8>(out);
+  m_b -= m_len * static_cast<u8>(out);
+  m_b += m_a;
+}
+
+[[nodiscard]] int signatures(int const fd, u64 const size, proto::Fsigs& fsigs)
+{
+  fsigs.block = block_size(size);
+  fsigs.vsig.clear();
+  fsigs.vsig.reserve(static_cast<size_t>(size / fsigs.block));
+  std::vector<char> buf(static_cast<size_t>(fsigs.block));
+  Rsum              rsum;
+  // only the full blocks: the tail is sent as the literal.
+  for (u64 off = 0; off + fsigs.block <= size; off += fsigs.block) {
+    if (io::pread_loop(fd, buf.data(), buf.size(), static_cast<off_t>(off)) !=
+        0)
+    {
+      return -1;
+    }
+    rsum.init(buf.data(), buf.size());
+    fsigs.vsig.push_back({ rsum.value(), xxh64(buf.data(), buf.size()) });
+  }
+  return 0;
+}
+
+Sigset::Sigset(proto::Fsigs const& fsigs)
+    : m_block{ static_cast<size_t>(fsigs.block) }
+    , m_vsig{ fsigs.vsig }
+    , m_tag(size_t{ 1 } << tag_bits)
+{
+  m_by_weak.reserve(m_vsig.size());
+  for (size_t i = 0; i < m_vsig.size(); ++i) {
+    m_tag[tag(m_vsig[i].weak)] = true;
+    m_by_weak.emplace(m_vsig[i].weak, i);
+  }
+}
+
+[[nodiscard]] size_t Sigset::find(u32 const weak, char const* data,
+                                  size_t const hint) const
+{
+  if (!candidate(weak)) {
+    return none;
+  }
+  auto const [first, last]{ m_by_weak.equal_range(weak) };
+  if (first == last) {
+    return none;
+  }
+  // strong hash only for the candidates. (the whole block is hashed)
+  u64 const strong{ xxh64(data, m_block) };
+  if (hint < m_vsig.size() && m_vsig[hint].weak == weak &&
+      m_vsig[hint].strong == strong)
+  {
+    return hint;
+  }
+  for (auto it = first; it != last; ++it) {
+    if (m_vsig[it->second].strong == strong) {
+      return it->second;
+    }
+  }
+  return none;
+}
+
+Scanner::Scanner(char const* data, size_t const len,
+                 Sigset const& sigset) noexcept
+    : m_data{ data }
+    , m_len{ len }
+    , m_sigset{ sigset }
+{
+  m_copy.kind = proto::Dkind::COPY;
+}
+
+[[nodiscard]] bool Scanner::next(proto::Dop& op)
+{
+  while (m_queue.empty() && !m_done) {
+    step();
+  }
+  if (m_queue.empty()) {
+    return false;
+  }
+  op = m_queue.front();
+  m_queue.pop_front();
+  return true;
+}
+
+void Scanner::push_copy()
+{
+  if (m_copy.len > 0) {
+    m_queue.push_back(m_copy);
+    m_copy.len = 0;
+  }
+}
+
+void Scanner::push_literal(size_t const end)
+{
+  if (m_lit < end) {
+    push_copy(); // keep the order of the content.
+    m_queue.push_back({ .kind = proto::Dkind::LITERAL,
+                        .len  = end - m_lit,
+                        .off  = m_lit });
+    m_lit = end;
+  }
+}
+
+// NOLINTBEGIN(*-pointer-arithmetic)
+void Scanner::step()
+{
+  size_t const block{ m_sigset.block() };
+  while (m_pos + block <= m_len) {
+    if (!m_valid) {
+      m_rsum.init(m_data + m_pos, block);
+      m_valid = true;
+    }
+    u32 const    weak{ m_rsum.value() };
+    size_t const idx{ m_sigset.candidate(weak)
+                          ? m_sigset.find(weak, m_data + m_pos, m_hint)
+                          : Sigset::none };
+    if (idx != Sigset::none) {
+      push_literal(m_pos);
+      u64 const off{ static_cast<u64>(idx) * block };
+      if (m_copy.len > 0 && m_copy.off + m_copy.len != off) {
+        push_copy();
+      }
+      if (m_copy.len == 0) {
+        m_copy.off = off;
+      }
+      m_copy.len += block;
+      m_pos      += block;
+      m_lit       = m_pos;
+      m_hint      = idx + 1;
+      m_valid     = false;
+      if (!m_queue.empty()) {
+        return;
+      }
+      continue;
+    }
+    if (m_pos + block < m_len) {
+      m_rsum.roll(m_data[m_pos], m_data[m_pos + block]);
+    } else {
+      m_valid = false;
+    }
+    ++m_pos;
+    if (m_pos - m_lit >= cfg::chunk_size) {
+      push_literal(m_pos);
+      return;
+    }
+  }
+  // the tail shorter than the block => literal.
+  while (m_lit < m_len) {
+    push_literal(std::min(m_len, m_lit + cfg::chunk_size));
+  }
+  push_copy();
+  m_done = true;
+}
+// NOLINTEND(*-pointer-arithmetic)
+
+} // namespace wndx::mqlqd::delta
@@ -1,6 +1,20 @@
 
 #include "wndx/mqlqd/file.hpp"
 
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+extern "C" {
+
+#include <fcntl.h>    // open(2)
+#include <sys/mman.h> // mmap(2), madvise(2)
+#include <sys/stat.h> // fstat(2)
+
+} // extern "C"
+
 
 namespace wndx::mqlqd::file {
 
@@ -8,15 +22,25 @@ static constexpr std::string_view ctor{ "ctor - File instance" };
 
 File::File(fs::path fpath, size_t sz) noexcept
     : wndx::sane::file::File(std::move(fpath), sz)
+    , m_name{ path().filename() }
 {
   WNDX_LOG(LL::DBUG, "{} from file & size:\n\t{}\n", ctor, *this);
 }
 
+File::File(fs::path fpath, size_t sz, fs::path name) noexcept
+    : wndx::sane::file::File(std::move(fpath), sz)
+    , m_name{ std::move(name) }
+{
+  WNDX_LOG(LL::DBUG, "{} from file, size & name:\n\t{} : {}\n", ctor, *this,
+           m_name);
+}
+
 // NOLINTNEXTLINE(performance-unnecessary-value-param)
 File::File(Finfo const& finfo, fs::path dpath) noexcept
     // NOLINTNEXTLINE(*-array-to-pointer-decay, hicpp-no-array-decay)
     : wndx::sane::file::File({ dpath / std::string(finfo.m_fname) },
                              finfo.m_block_size)
+    , m_name{ path().filename() }
 {
   WNDX_LOG(LL::DBUG, "{} from Finfo & dir path:\n\t{}\n", ctor, *this);
 }
@@ -35,6 +59,56 @@ File::File(Finfo const& finfo, fs::path dpath) noexcept
   return finfo;
 }
 
+File::Mmap::~Mmap() noexcept
+{
+  if (munmap(addr, len) == -1) {
+    log_g.errnum(errno, "[FAIL] ~Mmap() munmap()");
+  }
+}
+
+[[nodiscard]] rc File::map() noexcept
+{
+  if (m_map || size() == 0) {
+    return rc::SUCCESS;
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd{ open(path().c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd == -1) {
+    log_g.errnum(errno, "[FAIL] map() open()");
+    return rc::FAILURE;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+      static_cast<size_t>(st.st_size) < size())
+  {
+    WNDX_LOG(LL::WARN, "[FAIL] map() - not a regular file of {} B : {}\n",
+             size(), path());
+    io::close_fd(fd, "map() fd");
+    return rc::FAILURE;
+  }
+  int flags{ MAP_PRIVATE };
+#ifdef MAP_POPULATE
+  if (size() <= cfg::mmap_populate_max) {
+    flags |= MAP_POPULATE; // page tables filled now, no faults on the send.
+  }
+#endif // MAP_POPULATE
+  void* addr{ mmap(nullptr, size(), PROT_READ, flags, fd, 0) };
+  io::close_fd(fd, "map() fd"); // mapping holds the reference to the file.
+  if (addr == MAP_FAILED) {
+    log_g.errnum(errno, "[FAIL] map() mmap()");
+    return rc::FAILURE;
+  }
+  // content is accessed once from the beginning to the end.
+  static_cast<void>(madvise(addr, size(), MADV_SEQUENTIAL));
+  if (size() > cfg::mmap_populate_max) {
+    static_cast<void>(madvise(addr, std::min(size(), cfg::prefetch_max),
+                              MADV_WILLNEED));
+  }
+  m_map = std::make_shared<Mmap const>(static_cast<char_type*>(addr), size());
+  WNDX_LOG(LL::DBUG, "[ OK ] map() : {}\n", *this);
+  return rc::SUCCESS;
+}
+
 } // namespace wndx::mqlqd::file
 
 
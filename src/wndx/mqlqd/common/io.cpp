@@ -0,0 +1,250 @@
+#include "wndx/mqlqd/io.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+extern "C" {
+
+#include <fcntl.h>       // fcntl(2)
+#include <netinet/in.h>  // IPPROTO_TCP
+#include <netinet/tcp.h> // TCP_KEEPIDLE etc. | tcp(7)
+#include <sys/resource.h> // getrlimit(2), setrlimit(2)
+#include <sys/socket.h>  // setsockopt(2), send(2), recv(2)
+#include <unistd.h>      // close(2), write(2), pread(2), pwrite(2)
+                         // copy_file_range(2) - Linux specific
+
+} // extern "C"
+
+
+namespace wndx::mqlqd::io {
+
+int close_fd(int& fd, sv_t const name) noexcept
+{
+  if (fd < 0) {
+    return 0;
+  }
+  int const rc{ close(fd) };
+  switch (rc) {
+  case -1: log_g.errnum(errno, fmt::format("[FAIL] {} close()", name)); break;
+  case 0 : WNDX_LOG(LL::DBUG, "[ OK ] {} close()\n", name); break;
+  default:
+    WNDX_LOG(LL::CRIT, "UNEXPECTED return code: {} close() -> {}\n", name, rc);
+  }
+  fd = -1;
+  return rc;
+}
+
+[[nodiscard]] int write_loop(int fd, void const* buf, size_t len) noexcept
+{
+  auto const* bufptr{ static_cast<char const*>(buf) };
+  size_t      towrite{ len };
+  while (towrite > 0) {
+    ssize_t const nbytes{ write(fd, bufptr, towrite) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] write() error occurred");
+      return -1;
+    }
+    bufptr  += nbytes;
+    towrite -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+[[nodiscard]] int send_loop(int fd, void const* buf, size_t len,
+                            int const flags) noexcept
+{
+  auto const* bufptr{ static_cast<char const*>(buf) };
+  size_t      tosend{ len };
+  // loop till all bytes are sent or till the error.
+  while (tosend > 0) {
+    ssize_t const nbytes{ send(fd, bufptr, tosend, flags | MSG_NOSIGNAL) };
+    switch (nbytes) {
+    case -1:
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] send() error occurred");
+      return -1;
+    case 0:
+      WNDX_LOG(LL::CRIT, "[FAIL] send() -> 0 - nothing to send!\n");
+      return -2;
+    default: WNDX_LOG(LL::DBUG, "nbytes send_loop() :  {}\n", nbytes);
+    }
+    bufptr += nbytes;
+    tosend -= static_cast<size_t>(nbytes);
+  }
+  WNDX_LOG(LL::DBUG, "[ OK ] send_loop() finished\n");
+  return 0;
+}
+
+[[nodiscard]] int recv_loop(int fd, void* buf, size_t len) noexcept
+{
+  auto*  bufptr{ static_cast<char*>(buf) };
+  size_t torecv{ len };
+  while (torecv > 0) {
+    ssize_t const nbytes{ recv(fd, bufptr, torecv, 0) };
+    switch (nbytes) {
+    case -1:
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] recv() error occurred");
+      return -1;
+    case 0:
+      WNDX_LOG(LL::ERRO, "[FAIL] recv() -> 0 - orderly shutdown!\n");
+      return -2;
+    default: WNDX_LOG(LL::DBUG, "nbytes recv_loop() :  {}\n", nbytes);
+    }
+    bufptr += nbytes;
+    torecv -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+[[nodiscard]] int pwrite_loop(int fd, void const* buf, size_t len,
+                              off_t off) noexcept
+{
+  auto const* bufptr{ static_cast<char const*>(buf) };
+  size_t      towrite{ len };
+  while (towrite > 0) {
+    ssize_t const nbytes{ pwrite(fd, bufptr, towrite, off) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] pwrite() error occurred");
+      return -1;
+    }
+    bufptr  += nbytes;
+    off     += nbytes;
+    towrite -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+[[nodiscard]] int pread_loop(int fd, void* buf, size_t len, off_t off) noexcept
+{
+  auto*  bufptr{ static_cast<char*>(buf) };
+  size_t toread{ len };
+  while (toread > 0) {
+    ssize_t const nbytes{ pread(fd, bufptr, toread, off) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      log_g.errnum(errno, "[FAIL] pread() error occurred");
+      return -1;
+    }
+    if (nbytes == 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] pread() -> 0 - file was truncated!\n");
+      return -2;
+    }
+    bufptr += nbytes;
+    off    += nbytes;
+    toread -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+[[nodiscard]] int copy_loop(int fd_in, off_t off_in, int fd_out, off_t off_out,
+                            size_t len) noexcept
+{
+#if defined(__linux__)
+  while (len > 0) {
+    // offsets are advanced by the kernel.
+    ssize_t const nbytes{ copy_file_range(fd_in, &off_in, fd_out, &off_out, len,
+                                          0) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // not supported by the kernel / filesystem => copy via the buffer.
+      if (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+          errno == EOPNOTSUPP)
+      {
+        break;
+      }
+      log_g.errnum(errno, "[FAIL] copy_file_range() error occurred");
+      return -1;
+    }
+    if (nbytes == 0) {
+      WNDX_LOG(LL::ERRO,
+               "[FAIL] copy_file_range() -> 0 - file was truncated!\n");
+      return -2;
+    }
+    len -= static_cast<size_t>(nbytes);
+  }
+#endif // __linux__
+  std::array<char, 64 * 1024> buf{}; // NOLINT(*-magic-numbers)
+  while (len > 0) {
+    size_t const n{ std::min(len, buf.size()) };
+    int const    rc{ pread_loop(fd_in, buf.data(), n, off_in) };
+    if (rc != 0) {
+      return rc;
+    }
+    if (pwrite_loop(fd_out, buf.data(), n, off_out) != 0) {
+      return -1;
+    }
+    off_in  += static_cast<off_t>(n);
+    off_out += static_cast<off_t>(n);
+    len     -= n;
+  }
+  return 0;
+}
+
+[[nodiscard]] int set_nonblock(int fd) noexcept
+{
+  int const flags{ fcntl(fd, F_GETFL) }; // NOLINT(*-vararg)
+  if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) { // NOLINT
+    log_g.errnum(errno, "[FAIL] set_nonblock() fcntl()");
+    return -1;
+  }
+  return 0;
+}
+
+[[nodiscard]] int set_keepalive(int fd) noexcept
+{
+  int const on{ 1 };
+  if (setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) == -1) {
+    log_g.errnum(errno, "[FAIL] set_keepalive() SO_KEEPALIVE");
+    return -1;
+  }
+#ifdef TCP_KEEPIDLE
+  int const idle{ static_cast<int>(cfg::keepalive_idle) };
+  int const intvl{ static_cast<int>(cfg::keepalive_intvl) };
+  int const cnt{ static_cast<int>(cfg::keepalive_cnt) };
+  if (setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) == -1 ||
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl)) == -1 ||
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt)) == -1)
+  {
+    log_g.errnum(errno, "[FAIL] set_keepalive() TCP_KEEP*");
+    return -1;
+  }
+#endif // TCP_KEEPIDLE
+  return 0;
+}
+
+[[nodiscard]] long raise_nofile() noexcept
+{
+  struct rlimit rl{};
+  if (getrlimit(RLIMIT_NOFILE, &rl) == -1) {
+    log_g.errnum(errno, "[FAIL] raise_nofile() getrlimit()");
+    return -1;
+  }
+  if (rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur = rl.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &rl) == -1) {
+      log_g.errnum(errno, "[FAIL] raise_nofile() setrlimit()");
+      return -1;
+    }
+  }
+  return static_cast<long>(rl.rlim_cur);
+}
+
+} // namespace wndx::mqlqd::io
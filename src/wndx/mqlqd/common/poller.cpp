@@ -0,0 +1,211 @@
+#include "wndx/mqlqd/poller.hpp"
+
+#include "wndx/mqlqd/io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+extern "C" {
+
+#ifdef __linux__
+#include <sys/epoll.h> // epoll(7)
+#else
+#include <poll.h>      // poll(2)
+#endif // __linux__
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+#ifdef __linux__
+
+namespace {
+
+/// max number of the events returned by the single epoll_wait() call.
+constexpr int max_events{ 256 };
+
+[[nodiscard]] u32 to_epoll(u32 const events) noexcept
+{
+  u32 ev{ 0 };
+  if (events & pev_in) {
+    ev |= EPOLLIN;
+  }
+  if (events & pev_out) {
+    ev |= EPOLLOUT;
+  }
+  return ev; // EPOLLERR & EPOLLHUP are always reported. ref: epoll_ctl(2)
+}
+
+[[nodiscard]] u32 from_epoll(u32 const ev) noexcept
+{
+  u32 events{ 0 };
+  if (ev & EPOLLIN) {
+    events |= pev_in;
+  }
+  if (ev & EPOLLOUT) {
+    events |= pev_out;
+  }
+  if (ev & EPOLLERR) {
+    events |= pev_err;
+  }
+  if (ev & EPOLLHUP) {
+    events |= pev_hup;
+  }
+  return events;
+}
+
+} // namespace
+
+Poller::~Poller() noexcept { io::close_fd(m_epfd, "m_epfd"); }
+
+[[nodiscard]] int Poller::init()
+{
+  m_epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epfd == -1) {
+    log_g.errnum(errno, "[FAIL] epoll_create1()");
+    return -1;
+  }
+  WNDX_LOG(LL::DBUG, "[ OK ] epoll_create1()\n");
+  return 0;
+}
+
+[[nodiscard]] int Poller::add(int fd, u32 events)
+{
+  struct epoll_event ev{};
+  ev.events  = to_epoll(events);
+  ev.data.fd = fd;
+  if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+    log_g.errnum(errno, "[FAIL] epoll_ctl() EPOLL_CTL_ADD");
+    return -1;
+  }
+  return 0;
+}
+
+[[nodiscard]] int Poller::mod(int fd, u32 events)
+{
+  struct epoll_event ev{};
+  ev.events  = to_epoll(events);
+  ev.data.fd = fd;
+  if (epoll_ctl(m_epfd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+    log_g.errnum(errno, "[FAIL] epoll_ctl() EPOLL_CTL_MOD");
+    return -1;
+  }
+  return 0;
+}
+
+int Poller::del(int fd)
+{
+  if (epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr) == -1) {
+    log_g.errnum(errno, "[FAIL] epoll_ctl() EPOLL_CTL_DEL");
+    return -1;
+  }
+  return 0;
+}
+
+[[nodiscard]] int Poller::wait(std::vector<Pevent>& vpev, int timeout_ms)
+{
+  vpev.clear();
+  std::array<struct epoll_event, max_events> evs{};
+  int const n{ epoll_wait(m_epfd, evs.data(), max_events, timeout_ms) };
+  if (n == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    log_g.errnum(errno, "[FAIL] epoll_wait()");
+    return -1;
+  }
+  for (int i = 0; i < n; ++i) {
+    auto const& ev{ evs.at(static_cast<size_t>(i)) };
+    vpev.push_back({ ev.data.fd, from_epoll(ev.events) });
+  }
+  return n;
+}
+
+#else  // poll(2) fallback for the other POSIX platforms
+
+namespace {
+
+[[nodiscard]] short to_poll(u32 const events) noexcept
+{
+  short ev{ 0 };
+  if (events & pev_in) {
+    ev |= POLLIN;
+  }
+  if (events & pev_out) {
+    ev |= POLLOUT;
+  }
+  return ev;
+}
+
+[[nodiscard]] u32 from_poll(short const ev) noexcept
+{
+  u32 events{ 0 };
+  if (ev & POLLIN) {
+    events |= pev_in;
+  }
+  if (ev & POLLOUT) {
+    events |= pev_out;
+  }
+  if (ev & (POLLERR | POLLNVAL)) {
+    events |= pev_err;
+  }
+  if (ev & POLLHUP) {
+    events |= pev_hup;
+  }
+  return events;
+}
+
+} // namespace
+
+Poller::~Poller() noexcept = default;
+
+[[nodiscard]] int Poller::init() { return 0; }
+
+[[nodiscard]] int Poller::add(int fd, u32 events)
+{
+  m_vpfd.push_back({ fd, to_poll(events), 0 });
+  return 0;
+}
+
+[[nodiscard]] int Poller::mod(int fd, u32 events)
+{
+  auto it{ std::find_if(m_vpfd.begin(), m_vpfd.end(),
+                        [fd](auto const& pfd) { return pfd.fd == fd; }) };
+  if (it == m_vpfd.end()) {
+    WNDX_LOG(LL::ERRO, "[FAIL] Poller::mod() fd is not watched: {}\n", fd);
+    return -1;
+  }
+  it->events = to_poll(events);
+  return 0;
+}
+
+int Poller::del(int fd)
+{
+  std::erase_if(m_vpfd, [fd](auto const& pfd) { return pfd.fd == fd; });
+  return 0;
+}
+
+[[nodiscard]] int Poller::wait(std::vector<Pevent>& vpev, int timeout_ms)
+{
+  vpev.clear();
+  int const n{ poll(m_vpfd.data(), m_vpfd.size(), timeout_ms) };
+  if (n == -1) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    log_g.errnum(errno, "[FAIL] poll()");
+    return -1;
+  }
+  for (auto const& pfd : m_vpfd) {
+    if (pfd.revents != 0) {
+      vpev.push_back({ pfd.fd, from_poll(pfd.revents) });
+    }
+  }
+  return n;
+}
+
+#endif // __linux__
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,417 @@
+#include "wndx/mqlqd/proto.hpp"
+
+
+namespace wndx::mqlqd::proto {
+
+namespace {
+
+template <typename T>
+[[nodiscard]] Pres get_le(char const* p, size_t len, T& v, size_t& n)
+{
+  if (len < sizeof(T)) {
+    return Pres::MORE;
+  }
+  v = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    // NOLINTNEXTLINE(*-pointer-arithmetic)
+    v |= static_cast<T>(static_cast<T>(static_cast<u8>(p[i])) << (8U * i));
+  }
+  n = sizeof(T);
+  return Pres::OK;
+}
+
+template <typename T>
+void put_le(std::string& out, T v)
+{
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out.push_back(static_cast<char>(static_cast<u8>(v >> (8U * i))));
+  }
+}
+
+} // namespace
+
+void put_u8(std::string& out, u8 v) { out.push_back(static_cast<char>(v)); }
+void put_u32le(std::string& out, u32 v) { put_le(out, v); }
+void put_u64le(std::string& out, u64 v) { put_le(out, v); }
+
+void put_varint(std::string& out, u64 v)
+{
+  while (v >= 0x80U) {
+    out.push_back(static_cast<char>((v & 0x7FU) | 0x80U));
+    v >>= 7U;
+  }
+  out.push_back(static_cast<char>(v));
+}
+
+void put_str(std::string& out, sv_t s)
+{
+  put_varint(out, s.size());
+  out.append(s);
+}
+
+[[nodiscard]] Pres get_u8(char const* p, size_t len, u8& v, size_t& n)
+{
+  return get_le(p, len, v, n);
+}
+
+[[nodiscard]] Pres get_u32le(char const* p, size_t len, u32& v, size_t& n)
+{
+  return get_le(p, len, v, n);
+}
+
+[[nodiscard]] Pres get_u64le(char const* p, size_t len, u64& v, size_t& n)
+{
+  return get_le(p, len, v, n);
+}
+
+[[nodiscard]] Pres get_varint(char const* p, size_t len, u64& v, size_t& n)
+{
+  v = 0;
+  for (size_t i = 0; i < varint_max; ++i) {
+    if (i == len) {
+      return Pres::MORE;
+    }
+    auto const b{ static_cast<u8>(p[i]) }; // NOLINT(*-pointer-arithmetic)
+    if (i == varint_max - 1 && b > 1U) {
+      return Pres::BAD; // overflow of the u64.
+    }
+    v |= static_cast<u64>(b & 0x7FU) << (7U * i);
+    if ((b & 0x80U) == 0) {
+      n = i + 1;
+      return Pres::OK;
+    }
+  }
+  return Pres::BAD;
+}
+
+[[nodiscard]] Pres get_str(char const* p, size_t len, size_t max,
+                           std::string& s, size_t& n)
+{
+  u64    slen{ 0 };
+  size_t vn{ 0 };
+  Pres   res{ get_varint(p, len, slen, vn) };
+  if (res != Pres::OK) {
+    return res;
+  }
+  if (slen > max) {
+    return Pres::BAD;
+  }
+  if (len - vn < slen) {
+    return Pres::MORE;
+  }
+  s.assign(p + vn, static_cast<size_t>(slen)); // NOLINT(*-pointer-arithmetic)
+  n = vn + static_cast<size_t>(slen);
+  return Pres::OK;
+}
+
+namespace {
+
+/// \brief cursor over the received bytes, decoding stops on the first not OK.
+class Cursor final
+{
+public:
+  Cursor(char const* p, size_t len) noexcept
+      : m_p{ p }
+      , m_len{ len }
+  {
+  }
+
+  Cursor& u8v(u8& v) { return step(get_u8, v); }
+  Cursor& u32v(u32& v) { return step(get_u32le, v); }
+  Cursor& u64v(u64& v) { return step(get_u64le, v); }
+  Cursor& varint(u64& v) { return step(get_varint, v); }
+
+  Cursor& str(std::string& s, size_t max)
+  {
+    if (m_res == Pres::OK) {
+      size_t k{ 0 };
+      m_res  = get_str(m_p + m_off, m_len - m_off, max, s, k); // NOLINT
+      m_off += k;
+    }
+    return *this;
+  }
+
+  [[nodiscard]] bool ok() const noexcept { return m_res == Pres::OK; }
+
+  /// \return result of the decoding & n - number of the consumed bytes.
+  [[nodiscard]] Pres res(size_t& n) const noexcept
+  {
+    n = m_res == Pres::OK ? m_off : 0;
+    return m_res;
+  }
+
+private:
+  template <typename Fn, typename T>
+  Cursor& step(Fn fn, T& v)
+  {
+    if (m_res == Pres::OK) {
+      size_t k{ 0 };
+      m_res  = fn(m_p + m_off, m_len - m_off, v, k); // NOLINT
+      m_off += k;
+    }
+    return *this;
+  }
+
+  char const* m_p;
+  size_t      m_len;
+  size_t      m_off{ 0 };
+  Pres        m_res{ Pres::OK };
+};
+
+} // namespace
+
+void encode(std::string& out, Hello const& h)
+{
+  encode_ack(out, h);
+  put_str(out, h.uid);
+}
+
+void encode_ack(std::string& out, Hello const& h)
+{
+  put_u32le(out, h.magic);
+  put_u8(out, h.version);
+  put_u32le(out, h.flags);
+}
+
+void encode(std::string& out, Fhdr const& h)
+{
+  put_varint(out, h.hflags);
+  put_varint(out, h.size);
+  if ((h.hflags & hf_range) != 0) {
+    put_varint(out, h.offset);
+    put_varint(out, h.total);
+  }
+  if ((h.hflags & hf_hash) != 0) {
+    put_u64le(out, h.hash);
+  }
+  if ((h.hflags & hf_src) != 0) {
+    put_u64le(out, h.src);
+  }
+  put_str(out, h.name);
+}
+
+void encode(std::string& out, Zblk const& h)
+{
+  put_varint(out, h.raw);
+  put_varint(out, h.clen);
+}
+
+[[nodiscard]] Pres decode(char const* p, size_t len, Zblk& h, size_t& n)
+{
+  return Cursor(p, len).varint(h.raw).varint(h.clen).res(n);
+}
+
+void encode(std::string& out, Dop const& h)
+{
+  put_u8(out, static_cast<u8>(h.kind));
+  put_varint(out, h.len);
+  if (h.kind == Dkind::COPY) {
+    put_varint(out, h.off);
+  }
+}
+
+[[nodiscard]] Pres decode(char const* p, size_t len, Dop& h, size_t& n)
+{
+  u8     kind{ 0 };
+  Cursor cur(p, len);
+  cur.u8v(kind).varint(h.len);
+  if (cur.ok() && kind > static_cast<u8>(Dkind::COPY)) {
+    return Pres::BAD;
+  }
+  h.kind = static_cast<Dkind>(kind);
+  if (cur.ok() && h.kind == Dkind::COPY) {
+    cur.varint(h.off);
+  }
+  return cur.res(n);
+}
+
+void encode_sigs(std::string& out, std::vector<Fsigs> const& vfsigs)
+{
+  std::string body;
+  put_varint(body, vfsigs.size());
+  for (auto const& fsigs : vfsigs) {
+    put_varint(body, fsigs.idx);
+    put_varint(body, fsigs.block);
+    put_varint(body, fsigs.vsig.size());
+    for (auto const& sig : fsigs.vsig) {
+      put_u32le(body, sig.weak);
+      put_u64le(body, sig.strong);
+    }
+  }
+  put_str(out, body);
+}
+
+[[nodiscard]] Pres decode_sigs(char const* p, size_t len,
+                               std::vector<Fsigs>& vfsigs)
+{
+  static constexpr size_t sig_len{ sizeof(u32) + sizeof(u64) };
+  Cursor                  cur(p, len);
+  u64                     count{ 0 };
+  if (!cur.varint(count).ok() || count > len) {
+    return Pres::BAD;
+  }
+  vfsigs.clear();
+  vfsigs.reserve(static_cast<size_t>(count));
+  for (u64 i = 0; i < count; ++i) {
+    Fsigs  fsigs{};
+    u64    num{ 0 };
+    size_t n{ 0 };
+    // each signature takes sig_len bytes => count is bounded by the body.
+    if (cur.varint(fsigs.idx).varint(fsigs.block).varint(num).res(n) !=
+            Pres::OK ||
+        fsigs.block == 0 || fsigs.block > block_max ||
+        num > (len - n) / sig_len)
+    {
+      return Pres::BAD; // body is complete => incomplete is malformed.
+    }
+    fsigs.vsig.resize(static_cast<size_t>(num));
+    for (auto& sig : fsigs.vsig) {
+      cur.u32v(sig.weak).u64v(sig.strong);
+    }
+    if (!cur.ok()) {
+      return Pres::BAD;
+    }
+    vfsigs.push_back(std::move(fsigs));
+  }
+  size_t n{ 0 };
+  return cur.res(n) == Pres::OK && n == len ? Pres::OK : Pres::BAD;
+}
+
+namespace {
+
+/// \brief count varint | value varint * count.
+void put_list(std::string& out, std::vector<u64> const& v)
+{
+  put_varint(out, v.size());
+  for (u64 const x : v) {
+    put_varint(out, x);
+  }
+}
+
+/// \brief decode the list at the off of the complete body & advance the off.
+[[nodiscard]] Pres get_list(char const* p, size_t const len, size_t& off,
+                            std::vector<u64>& v)
+{
+  u64    count{ 0 };
+  size_t n{ 0 };
+  // NOLINTNEXTLINE(*-pointer-arithmetic)
+  if (get_varint(p + off, len - off, count, n) != Pres::OK ||
+      count > len - off)
+  {
+    return Pres::BAD; // each value takes at least one byte.
+  }
+  v.clear();
+  v.reserve(static_cast<size_t>(count));
+  off += n;
+  for (u64 i = 0; i < count; ++i) {
+    u64 x{ 0 };
+    // NOLINTNEXTLINE(*-pointer-arithmetic)
+    if (get_varint(p + off, len - off, x, n) != Pres::OK) {
+      return Pres::BAD; // body is complete => incomplete varint is malformed.
+    }
+    off += n;
+    v.push_back(x);
+  }
+  return Pres::OK;
+}
+
+} // namespace
+
+void encode_plan(std::string& out, std::vector<u64> const& voff)
+{
+  std::string body;
+  put_list(body, voff);
+  put_str(out, body); // length-prefixed => recv by the two reads.
+}
+
+[[nodiscard]] Pres decode_plan(char const* p, size_t len,
+                               std::vector<u64>& voff)
+{
+  size_t off{ 0 };
+  if (get_list(p, len, off, voff) != Pres::OK) {
+    return Pres::BAD;
+  }
+  return off == len ? Pres::OK : Pres::BAD;
+}
+
+void encode_verdict(std::string& out, std::vector<u64> const& vidx)
+{
+  encode_plan(out, vidx);
+}
+
+void encode_verdict(std::string& out, std::vector<u64> const& vidx,
+                    std::vector<u64> const& vpub)
+{
+  std::string body;
+  put_list(body, vidx);
+  put_list(body, vpub);
+  put_str(out, body);
+}
+
+[[nodiscard]] Pres decode_verdict(char const* p, size_t len,
+                                  std::vector<u64>& vidx)
+{
+  return decode_plan(p, len, vidx);
+}
+
+[[nodiscard]] Pres decode_verdict(char const* p, size_t len,
+                                  std::vector<u64>& vidx,
+                                  std::vector<u64>& vpub)
+{
+  size_t off{ 0 };
+  if (get_list(p, len, off, vidx) != Pres::OK ||
+      get_list(p, len, off, vpub) != Pres::OK)
+  {
+    return Pres::BAD;
+  }
+  return off == len ? Pres::OK : Pres::BAD;
+}
+
+[[nodiscard]] Pres decode_ack(char const* p, size_t len, Hello& h, size_t& n)
+{
+  Pres const res{ Cursor(p, len).u32v(h.magic).u8v(h.version).u32v(h.flags).res(
+      n) };
+  if (res == Pres::OK && h.magic != magic) {
+    return Pres::BAD;
+  }
+  return res;
+}
+
+[[nodiscard]] Pres decode(char const* p, size_t len, Hello& h, size_t& n)
+{
+  Pres const res{ Cursor(p, len)
+                      .u32v(h.magic)
+                      .u8v(h.version)
+                      .u32v(h.flags)
+                      .str(h.uid, uid_max)
+                      .res(n) };
+  if (res == Pres::OK && h.magic != magic) {
+    return Pres::BAD;
+  }
+  return res;
+}
+
+[[nodiscard]] Pres decode(char const* p, size_t len, Fhdr& h, size_t& n)
+{
+  Cursor cur(p, len);
+  cur.varint(h.hflags).varint(h.size);
+  if (cur.ok() && (h.hflags & hf_range) != 0) {
+    cur.varint(h.offset).varint(h.total);
+  }
+  if (cur.ok() && (h.hflags & hf_hash) != 0) {
+    cur.u64v(h.hash);
+  }
+  if (cur.ok() && (h.hflags & hf_src) != 0) {
+    cur.u64v(h.src);
+  }
+  Pres const res{ cur.str(h.name, name_max).res(n) };
+  // range must be inside of the file.
+  if (res == Pres::OK && (h.hflags & hf_range) != 0 &&
+      (h.offset > h.total || h.size > h.total - h.offset))
+  {
+    return Pres::BAD;
+  }
+  return res;
+}
+
+} // namespace wndx::mqlqd::proto
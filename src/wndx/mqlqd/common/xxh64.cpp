@@ -0,0 +1,127 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/xxh64.hpp"
+
+#include <bit>
+#include <cstring>
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+constexpr u64 p1{ 0x9E3779B185EBCA87ULL };
+constexpr u64 p2{ 0xC2B2AE3D27D4EB4FULL };
+constexpr u64 p3{ 0x165667B19E3779F9ULL };
+constexpr u64 p4{ 0x85EBCA77C2B2AE63ULL };
+constexpr u64 p5{ 0x27D4EB2F165667C5ULL };
+
+/// \brief little-endian load. (hash must not depend on the host)
+/// the loop is recognized by the compilers => single load on the LE hosts.
+template <typename T>
+[[nodiscard]] u64 load_le(char const* p) noexcept
+{
+  T v{ 0 };
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    // NOLINTNEXTLINE(*-pointer-arithmetic)
+    v |= static_cast<T>(static_cast<T>(static_cast<u8>(p[i])) << (8U * i));
+  }
+  return v;
+}
+
+[[nodiscard]] u64 round(u64 acc, u64 const input) noexcept
+{
+  acc += input * p2;
+  acc  = std::rotl(acc, 31);
+  return acc * p1;
+}
+
+[[nodiscard]] u64 merge(u64 acc, u64 const val) noexcept
+{
+  acc ^= round(0, val);
+  return acc * p1 + p4;
+}
+
+} // namespace
+
+Xxh64::Xxh64(u64 const seed) noexcept
+    : m_acc{ seed + p1 + p2, seed + p2, seed, seed - p1 }
+    , m_seed{ seed }
+{
+}
+
+void Xxh64::update(char const* data, size_t len) noexcept
+{
+  m_total += len;
+  if (m_buf_len + len < m_buf.size()) {
+    std::memcpy(m_buf.data() + m_buf_len, data, len);
+    m_buf_len += len;
+    return;
+  }
+  auto const stripe{ [this](char const* p) {
+    for (size_t i = 0; i < m_acc.size(); ++i) {
+      m_acc[i] = round(m_acc[i], load_le<u64>(p + i * 8)); // NOLINT(*-magic-numbers)
+    }
+  } };
+  if (m_buf_len > 0) { // complete the buffered stripe.
+    size_t const n{ m_buf.size() - m_buf_len };
+    std::memcpy(m_buf.data() + m_buf_len, data, n);
+    stripe(m_buf.data());
+    data      += n;
+    len       -= n;
+    m_buf_len  = 0;
+  }
+  for (; len >= m_buf.size(); data += m_buf.size(), len -= m_buf.size()) {
+    stripe(data);
+  }
+  std::memcpy(m_buf.data(), data, len);
+  m_buf_len = len;
+}
+
+// NOLINTBEGIN(*-magic-numbers)
+[[nodiscard]] u64 Xxh64::digest() const noexcept
+{
+  u64 h{ 0 };
+  if (m_total >= m_buf.size()) {
+    h = std::rotl(m_acc[0], 1) + std::rotl(m_acc[1], 7) +
+        std::rotl(m_acc[2], 12) + std::rotl(m_acc[3], 18);
+    for (u64 const acc : m_acc) {
+      h = merge(h, acc);
+    }
+  } else {
+    h = m_seed + p5;
+  }
+  h += m_total;
+  char const* p{ m_buf.data() };
+  size_t      len{ m_buf_len };
+  for (; len >= 8; p += 8, len -= 8) {
+    h ^= round(0, load_le<u64>(p));
+    h  = std::rotl(h, 27) * p1 + p4;
+  }
+  if (len >= 4) {
+    h ^= load_le<u32>(p) * p1;
+    h  = std::rotl(h, 23) * p2 + p3;
+    p += 4;
+    len -= 4;
+  }
+  for (; len > 0; ++p, --len) {
+    h ^= static_cast<u8>(*p) * p5;
+    h  = std::rotl(h, 11) * p1;
+  }
+  h ^= h >> 33;
+  h *= p2;
+  h ^= h >> 29;
+  h *= p3;
+  h ^= h >> 32;
+  return h;
+}
+// NOLINTEND(*-magic-numbers)
+
+[[nodiscard]] u64 xxh64(char const* data, size_t const len, u64 const seed) noexcept
+{
+  Xxh64 h{ seed };
+  h.update(data, len);
+  return h.digest();
+}
+
+} // namespace wndx::mqlqd
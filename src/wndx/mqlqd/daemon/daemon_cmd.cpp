@@ -6,12 +6,16 @@
 
 #include "wndx/mqlqd/config.hpp"
 #include "wndx/mqlqd/file.hpp" // IWYU pragma: keep
+#include "wndx/mqlqd/io.hpp"
 
 #include <cxxopts.hpp>
 
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 
 // clang-format off
@@ -50,6 +54,20 @@ namespace wndx::mqlqd {
                  "(default: " + fmt::to_string<port_t>(mqlqd::cfg::port) + ')',
        cxxopts::value<port_t>())
 
+      ("w,workers", "Number of worker threads, each with own SO_REUSEPORT "
+                    "listening socket. (default: 1)",
+       cxxopts::value<unsigned>(), "N")
+
+      ("e,engine", "I/O engine of the event loop: epoll | uring "
+                   "(io_uring, fallback to epoll). (default: epoll)",
+       cxxopts::value<cmd_opt_t>(), "name")
+
+      ("durability", "When received files are flushed to the stable storage "
+                     "before the client is told: none | batch (one syncfs "
+                     "per group of the sessions) | file (fdatasync of each "
+                     "file). (default: none)",
+       cxxopts::value<cmd_opt_t>(), "mode")
+
       ("h,help", "Show usage help.")
       ("u,urge", "Log urgency level. (All messages </> Only critical)",
        cxxopts::value<int>(), "1-7");
@@ -94,28 +112,91 @@ namespace wndx::mqlqd {
     port_t const port{ cmd_opts.count("port") ? cmd_opts["port"].as<port_t>()
                                               : mqlqd::cfg::port };
 
-    /// Work infinitely as the daemon till one of the stop signals received.
-    /// Also - till the error: return code, errno msg, everything is logged,
-    /// nothing suppressed.)
-    /// TODO: make this daemon (file server) loop more optimal.
-    for (;;) {
-      Fserver fserver{ port, storage_dir };
+    /// number of the worker threads, each runs own file server (event loop).
+    unsigned const workers{ cmd_opts.count("workers")
+                                ? cmd_opts["workers"].as<unsigned>()
+                                : 1U };
+    if (workers < 1 || workers > mqlqd::cfg::workers_max) {
+      WNDX_LOG(LL::ERRO, "{}: --workers must be in range [1, {}]\n",
+               rc::ERRO_CMD_OPT, mqlqd::cfg::workers_max);
+      return rc::ERRO_CMD_OPT;
+    }
+
+    /// I/O engine of the file server event loop.
+    cmd_opt_t const engine_name{ cmd_opts.count("engine")
+                                     ? cmd_opts["engine"].as<cmd_opt_t>()
+                                     : "epoll" };
+    if (engine_name != "epoll" && engine_name != "uring") {
+      WNDX_LOG(LL::ERRO, "{}: unknown --engine '{}'\n", rc::ERRO_CMD_OPT,
+               engine_name);
+      return rc::ERRO_CMD_OPT;
+    }
+    Engine const engine{ engine_name == "uring" ? Engine::URING
+                                                : Engine::EPOLL };
+
+    /// durability of the received files. (group commit: per worker)
+    cmd_opt_t const durability_name{
+      cmd_opts.count("durability") ? cmd_opts["durability"].as<cmd_opt_t>()
+                                   : "none"
+    };
+    Durability durability{ Durability::NONE };
+    if (durability_name == "batch") {
+      durability = Durability::BATCH;
+    } else if (durability_name == "file") {
+      durability = Durability::FILE;
+    } else if (durability_name != "none") {
+      WNDX_LOG(LL::ERRO, "{}: unknown --durability '{}'\n", rc::ERRO_CMD_OPT,
+               durability_name);
+      return rc::ERRO_CMD_OPT;
+    }
+
+    /// each connection is the fd => as many as the hard limit allows.
+    long const nofile{ io::raise_nofile() };
+    if (nofile != -1) {
+      WNDX_LOG(LL::NTFY, "max open files: {}\n", nofile);
+    }
+
+    /// long-lived file servers, which serve all clients concurrently.
+    /// With many workers - kernel distributes connections between them.
+    std::vector<std::unique_ptr<Fserver>> vfservers;
+    vfservers.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+      auto& fserver{ vfservers.emplace_back(
+          std::make_unique<Fserver>(port, storage_dir, workers > 1, engine)) };
+      fserver->set_durability(durability);
       // initialize file server.
-      rc = fserver.init();
+      rc = fserver->init();
       if (rc != rc::SUCCESS) {
         return rc;
       }
+    }
 
-      /// attempt to receive info of the upcoming transmission of the files.
-      rc = fserver.recv_files_info();
-      if (rc != rc::SUCCESS) {
-        return rc;
+    /// Work infinitely as the daemon till one of the stop signals received.
+    /// Also - till the error: return code, errno msg, everything is logged,
+    /// nothing suppressed.)
+    /// The fatal error of one worker stops the others => the daemon exits
+    /// with its code instead of serving by the part of the workers.
+    std::vector<sane::rc> vrc(workers, rc::INIT);
+    auto const            work{ [&vfservers, &vrc](unsigned const i) {
+      vrc[i] = vfservers[i]->run();
+      if (vrc[i] != rc::SUCCESS) {
+        WNDX_LOG(LL::CRIT, "worker {} finished: {}\n", i, vrc[i]);
+        for (auto const& fserver : vfservers) {
+          fserver->stop();
+        }
       }
-
-      /// server is ready to accept provided files => start accepting files.
-      rc = fserver.recv_files();
-      if (rc != rc::SUCCESS) {
-        return rc;
+    } };
+    {
+      std::vector<std::jthread> vthreads;
+      vthreads.reserve(workers - 1);
+      for (unsigned i = 1; i < workers; ++i) {
+        vthreads.emplace_back(work, i);
+      }
+      work(0); // main thread is the first worker.
+    } // join threads
+    for (auto const wrc : vrc) {
+      if (wrc != rc::SUCCESS) {
+        return wrc;
       }
     }
 
@@ -3,26 +3,234 @@
 
 #include "wndx/mqlqd/fserver.hpp"
 
+#include "wndx/mqlqd/config.hpp"
 #include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/io.hpp"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
 extern "C" {
 
 #include <arpa/inet.h>   // inet_pton(), inet_ntoa()
+#include <fcntl.h>       // open(2)
 #include <netdb.h>
 #include <netinet/in.h>  // Internet domain sockets | sockaddr(3type)
 #include <netinet/tcp.h> // TCP protocol | tcp(7)
+#include <sys/eventfd.h> // eventfd(2)
 #include <sys/socket.h>
+#include <sys/stat.h> // mkdir(2)
 #include <sys/types.h>
-#include <unistd.h> // | close(2).
+#include <unistd.h> // | close(2), syncfs(2), read(2), write(2).
 
 } // extern "C"
 
 namespace wndx::mqlqd {
 
-Fserver::Fserver(port_t port, fs::path storage_dir) noexcept
+namespace {
+
+/// \brief flushes of the storage requested by the workers, done by the
+/// helper thread. Requests arriving while the flush is in flight are merged
+/// into the next round => one syncfs(2) per storage for all of them.
+class Syncer final
+{
+public:
+  Syncer(Syncer&&)                 = delete;
+  Syncer(Syncer const&)            = delete;
+  Syncer& operator=(Syncer&&)      = delete;
+  Syncer& operator=(Syncer const&) = delete;
+
+  Syncer()
+      : m_thread{ [this]() { run(); } }
+  {
+  }
+
+  ~Syncer() noexcept
+  {
+    {
+      std::lock_guard const lock{ m_mtx };
+      m_stop = true;
+    }
+    m_cv.notify_all();
+  }
+
+  /// \brief flush the storage, then signal the fd_done. (eventfd(2))
+  void request(fs::path const& dir, int const fd_done)
+  {
+    {
+      std::lock_guard const lock{ m_mtx };
+      m_vpending.push_back({ dir, fd_done });
+    }
+    m_cv.notify_one();
+  }
+
+  /// \brief the requester is gone => its fd_done is not signaled anymore.
+  void cancel(int const fd_done)
+  {
+    std::lock_guard const lock{ m_mtx };
+    auto const            same{ [fd_done](Sreq const& req) {
+      return req.fd_done == fd_done;
+    } };
+    std::erase_if(m_vpending, same);
+    std::erase_if(m_vround, same);
+  }
+
+private:
+  struct Sreq
+  {
+    fs::path dir;
+    int      fd_done{ -1 };
+  };
+
+  void run()
+  {
+    std::unique_lock lock{ m_mtx };
+    for (;;) {
+      m_cv.wait(lock, [this]() { return m_stop || !m_vpending.empty(); });
+      if (m_stop) {
+        return;
+      }
+      m_vround.swap(m_vpending);
+      std::vector<fs::path> vdirs;
+      for (auto const& req : m_vround) {
+        if (std::find(vdirs.begin(), vdirs.end(), req.dir) == vdirs.end()) {
+          vdirs.push_back(req.dir);
+        }
+      }
+      lock.unlock();
+      std::vector<u64> vres;
+      for (auto const& dir : vdirs) {
+        vres.push_back(flush(dir) == 0 ? 1 : 2);
+      }
+      lock.lock();
+      // cancelled requests are already removed. (their fds may be closed)
+      for (auto const& req : m_vround) {
+        auto const idx{ std::find(vdirs.begin(), vdirs.end(), req.dir) -
+                        vdirs.begin() };
+        if (write(req.fd_done, &vres[idx], sizeof(u64)) == -1) {
+          log_g.errnum(errno, "[FAIL] Syncer write()");
+        }
+      }
+      m_vround.clear();
+    }
+  }
+
+  /// \brief one flush of the file system for all files of the storage.
+  /// (data & names)
+  ///
+  /// \return 0 on success, -1 on error. (errno msg is logged)
+  [[nodiscard]] static int flush(fs::path const& dir)
+  {
+    // NOLINTNEXTLINE(*-vararg)
+    int fd{ open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+#ifdef __linux__
+    int const rc_sync{ fd == -1 ? -1 : syncfs(fd) };
+#else
+    sync();
+    int const rc_sync{ fd == -1 ? -1 : 0 };
+#endif // __linux__
+    if (rc_sync == -1) {
+      log_g.errnum(errno, "[FAIL] group_commit() syncfs()");
+    }
+    io::close_fd(fd, "group_commit() fd");
+    return rc_sync;
+  }
+
+  std::mutex              m_mtx;
+  std::condition_variable m_cv;
+  std::vector<Sreq>       m_vpending; // requested since the last round.
+  std::vector<Sreq>       m_vround;   // flushed right now.
+  bool                    m_stop{ false };
+  std::jthread            m_thread; // the last: started when all are ready.
+};
+
+[[nodiscard]] Syncer& syncer()
+{
+  static Syncer syncer;
+  return syncer;
+}
+
+} // namespace
+
+Sigworker::~Sigworker() noexcept
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  io::close_fd(m_fd, "Sigworker m_fd");
+}
+
+[[nodiscard]] int Sigworker::init()
+{
+  m_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_fd == -1) {
+    log_g.errnum(errno, "[FAIL] Sigworker init() eventfd()");
+    return -1;
+  }
+  return 0;
+}
+
+void Sigworker::push(Sjob job)
+{
+  {
+    std::lock_guard const lock{ m_mtx };
+    m_vtodo.push_back(std::move(job));
+  }
+  if (!m_thread.joinable()) {
+    m_thread = std::thread{ [this]() { run(); } };
+  }
+  m_cv.notify_one();
+}
+
+[[nodiscard]] std::vector<Sjob> Sigworker::done()
+{
+  u64 num{ 0 };
+  if (read(m_fd, &num, sizeof(num)) == -1 && errno != EAGAIN) {
+    log_g.errnum(errno, "[FAIL] Sigworker done() read()");
+  }
+  std::vector<Sjob>     vdone;
+  std::lock_guard const lock{ m_mtx };
+  vdone.swap(m_vdone);
+  return vdone;
+}
+
+void Sigworker::run()
+{
+  std::unique_lock lock{ m_mtx };
+  for (;;) {
+    m_cv.wait(lock, [this]() { return m_stop || !m_vtodo.empty(); });
+    if (m_stop) {
+      return;
+    }
+    Sjob job{ std::move(m_vtodo.front()) };
+    m_vtodo.pop_front();
+    lock.unlock();
+    job.run(); // reads the old copies.
+    lock.lock();
+    m_vdone.push_back(std::move(job));
+    u64 const one{ 1 };
+    if (write(m_fd, &one, sizeof(one)) == -1) {
+      log_g.errnum(errno, "[FAIL] Sigworker write()");
+    }
+  }
+}
+
+Fserver::Fserver(port_t port, fs::path storage_dir, bool reuseport,
+                 Engine engine) noexcept
     : m_port{ port }
+    , m_reuseport{ reuseport }
+    , m_engine{ engine }
     , m_storage_dir{ std::move(storage_dir) }
 {
   WNDX_LOG(LL::DBUG, "INSIDE ctor Fserver()\n");
@@ -31,172 +239,242 @@ Fserver::Fserver(port_t port, fs::path storage_dir) noexcept
 Fserver::~Fserver() noexcept
 {
   WNDX_LOG(LL::DBUG, "INSIDE dtor ~Fserver()\n");
-  // TODO: close_fd() | close(2) wrapper
+  // sessions close their connected sockets.
+  m_sessions.clear();
   // close file descriptors. ref: close(2).
-  if (m_fd_con > 0) {
-    m_rc = close(m_fd_con);
-    switch (m_rc) {
-    case -1: log_g.errnum(errno, "[FAIL] m_fd_con close()"); break;
-    case 0 : WNDX_LOG(LL::DBUG, "[ OK ] m_fd_con close()\n"); break;
-    default:
-      WNDX_LOG(LL::CRIT, "UNEXPECTED return code: m_fd_con close() -> {}\n",
-               m_rc);
-    }
-    m_fd_con = -1;
-  }
-  if (m_fd > 0) {
-    m_rc = close(m_fd);
-    switch (m_rc) {
-    case -1: log_g.errnum(errno, "[FAIL] m_fd close()"); break;
-    case 0 : WNDX_LOG(LL::DBUG, "[ OK ] m_fd close()\n"); break;
-    default:
-      WNDX_LOG(LL::CRIT, "UNEXPECTED return code: m_fd close() -> {}\n", m_rc);
-    }
-    m_fd = -1;
+  io::close_fd(m_fd, "m_fd");
+  io::close_fd(m_fd_spare, "m_fd_spare");
+  io::close_fd(m_fd_stop, "m_fd_stop");
+  if (m_syncing) {
+    syncer().cancel(m_fd_synced);
   }
-  // extra new line to split log messages
-  // between the old & new class instance by the empty line.
-  // For the daemon mode -> file server (in the infinite loop).
-  WNDX_LOG(LL::DBUG, "END OF dtor ~Fserver()\n\n");
+  io::close_fd(m_fd_synced, "m_fd_synced");
+  WNDX_LOG(LL::DBUG, "END OF dtor ~Fserver()\n");
 }
 
 /// \return host address or empty string on error.
-[[nodiscard]] std::string Fserver::host_addr_ipv4() const noexcept
+[[nodiscard]] std::string
+Fserver::host_addr_ipv4(struct sockaddr_in const& sa) noexcept
 {
-  std::string str(m_addrlen, '\0'); // null-terminated string required
-  if (!inet_ntop(AF_INET, &(m_sockaddr_in.sin_addr), str.data(), m_addrlen)) {
+  std::string str(INET_ADDRSTRLEN, '\0'); // null-terminated string required
+  if (!inet_ntop(AF_INET, &(sa.sin_addr), str.data(), INET_ADDRSTRLEN)) {
     log_g.errnum(errno, "[FAIL] convert host_addr_ipv4()");
     return {};
   }
-  str.pop_back(); // remove null-terminator
+  str.resize(std::strlen(str.c_str())); // remove null-terminator(s)
   return str;
 }
 
-[[nodiscard]] int Fserver::recv_num_files_total()
+[[nodiscard]] rc Fserver::run()
 {
-  ssize_t nbytes =
-      recv(m_fd_con, &m_num_files_total, sizeof(m_num_files_total), 0);
-  if (nbytes != sizeof(m_num_files_total)) {
-    switch (nbytes) { // NOLINT(hicpp-multiway-paths-covered)
-    case -1:
-      log_g.errnum(errno,
-                   "[FAIL] to recv() m_num_files_total, error occurred:");
-      return -1;
-    default:
-      WNDX_LOG(LL::ERRO,
-               "[FAIL] recv m_num_files_total out of all bytes: {}/{}\n",
-               nbytes, sizeof(m_num_files_total));
-    }
-    return -2;
+  rc const res{ m_engine == Engine::URING ? run_uring() : run_epoll() };
+  if (res != rc::SUCCESS) {
+    // SO_REUSEPORT: the kernel would keep queueing connections to the socket
+    // nobody accepts anymore => they go to the other workers from now on.
+    io::close_fd(m_fd, "m_fd");
   }
-  WNDX_LOG(LL::DBUG, "[ OK ] recv_num_files_total() : {}\n", m_num_files_total);
-  return 0;
+  return res;
 }
 
-[[nodiscard]] rc Fserver::recv_files_info()
+void Fserver::stop() noexcept
 {
-  // recv m_num_files_total so that the server knows how many files to expect
-  m_rc = recv_num_files_total();
-  if (m_rc != 0) {
-    return rc::UNIX_SOCK_RECV_ERRO;
+  u64 const one{ 1 };
+  if (write(m_fd_stop, &one, sizeof(one)) == -1) {
+    log_g.errnum(errno, "[FAIL] stop() write()");
   }
-  // reserve in order to avoid potential reallocations later. (if many files)
-  m_vfiles.reserve(m_num_files_total);
+}
 
-  for (size_t i = 0; i < m_num_files_total; i++) {
-    m_rc = recv_file_info(i);
-    if (m_rc != 0) {
+[[nodiscard]] rc Fserver::run_epoll()
+{
+  m_engine = Engine::EPOLL;
+  if (m_buf.empty()) {
+    m_buf = m_pool.take(cfg::chunk_size);
+    if (m_buf.empty()) {
+      return rc::FAILURE;
+    }
+  }
+  std::vector<Pevent> vpev;
+  std::vector<int>    vdone;
+  for (;;) {
+    m_rc = m_poller.wait(vpev, group_timeout());
+    if (m_rc == -1) {
       return rc::UNIX_SOCK_RECV_ERRO;
     }
+    for (auto const& pev : vpev) {
+      if (pev.fd == m_fd_stop) {
+        WNDX_LOG(LL::NTFY, "[ OK ] run() - server stopped\n");
+        return rc::SUCCESS;
+      }
+      if (pev.fd == m_fd) {
+        if (accept_connections() != 0) {
+          return rc::UNIX_SOCK_CONN_ERRO;
+        }
+        continue;
+      }
+      if (pev.fd == m_sigworker.fd()) {
+        vdone.clear();
+        sigs_done(vdone);
+        for (int const fd_con : vdone) {
+          close_session(fd_con);
+        }
+        continue;
+      }
+      if (pev.fd == m_fd_synced) {
+        vdone.clear();
+        group_synced(vdone);
+        for (int const fd_con : vdone) {
+          close_session(fd_con);
+        }
+        continue;
+      }
+      auto const it{ m_sessions.find(pev.fd) };
+      if (it == m_sessions.end()) {
+        continue; // already closed during this iteration.
+      }
+      Fsession& session{ *it->second };
+      m_rc = 0;
+      if ((pev.events & pev_out) != 0) {
+        m_rc = session.on_writable();
+      }
+      // recv also reports the error/hang up condition of the socket.
+      if (m_rc == 0 && (pev.events & ~pev_out) != 0) {
+        m_rc = session.on_readable(m_buf.span());
+      }
+      if (m_rc != 0) {
+        close_session(pev.fd);
+        continue;
+      }
+      if (session.want_sigs()) {
+        offload(session);
+      }
+      if (session.want_sync()) {
+        hold(pev.fd, session);
+      }
+      // watch for the writability only while there are pending replies.
+      if ((session.want_write() || (pev.events & pev_out) != 0) &&
+          m_poller.mod(pev.fd, session.want_write() ? pev_in | pev_out
+                                                    : pev_in) != 0)
+      {
+        close_session(pev.fd);
+      }
+    }
+    if (group_timeout() == 0) {
+      group_commit();
+    }
   }
-  WNDX_LOG(LL::INFO,
-           "[ OK ] received info of the upcoming transfer of the files\n");
-  return rc::SUCCESS;
 }
 
-[[nodiscard]] int Fserver::recv_file_info(size_t const i)
+void Fserver::close_session(int fd_con)
 {
-  WNDX_LOG(LL::DBUG, "INSIDE recv_file_info() : {}\n", i);
-  file::Finfo finfo{};
-  m_rc = recv_loop<file::Finfo>(m_fd_con, &finfo, sizeof(finfo));
-  if (m_rc != 0) {
-    WNDX_LOG(LL::ERRO, "[FAIL] recv_file_info() in recv_loop() -> {} : {}\n",
-             m_rc, finfo);
-    return m_rc;
-  }
-  WNDX_LOG(LL::INFO, "[ OK ] recv_file_info() : {}\n", finfo);
-  file::File File(finfo, m_storage_dir_sub);
-  m_vfiles.emplace_back(File);
-  // m_vfiles.emplace_back(finfo, m_storage_dir_sub);
-#if 0 // even for debug - too verbose
-  WNDX_LOG(LL::DBUG, "\ti - {} : {}\n", i, m_vfiles.at(i));
-#endif
-  return 0;
+  if (m_engine == Engine::EPOLL) {
+    m_poller.del(fd_con);
+  }
+  m_sessions.erase(fd_con);
+  std::erase(m_vgroup, fd_con);
+  std::erase(m_vsyncing, fd_con);
+  std::erase(m_vwriting, fd_con);
+  WNDX_LOG(LL::INFO, "active sessions: {}\n", m_sessions.size());
 }
 
-[[nodiscard]] rc Fserver::recv_files()
+void Fserver::offload(Fsession& session)
 {
-  for (size_t i = 0; i < m_num_files_total; i++) {
-    m_rc = recv_file(i);
-    if (m_rc != 0) {
-      return rc::UNIX_SOCK_RECV_ERRO;
+  m_sigworker.push(session.take_sigs(++m_sigs_seq));
+}
+
+void Fserver::sigs_done(std::vector<int>& vdone)
+{
+  for (auto& job : m_sigworker.done()) {
+    auto const it{ m_sessions.find(job.fd_con) };
+    if (it == m_sessions.end() || it->second->sigs_id() != job.id) {
+      continue; // the session is already gone.
+    }
+    Fsession& session{ *it->second };
+    // files complete right away are committed. (nothing is in flight)
+    if (session.sigs_done(job) != 0 || session.writes_done() != 0) {
+      vdone.push_back(job.fd_con);
+      continue;
+    }
+    if (session.want_sync()) {
+      hold(job.fd_con, session);
+    }
+    if (session.on_writable() != 0) { // error, or finished.
+      vdone.push_back(job.fd_con);
+    } else if (m_engine == Engine::URING && session.want_write()) {
+      m_vwriting.push_back(job.fd_con);
+    } else if (m_engine == Engine::EPOLL && session.want_write() &&
+               m_poller.mod(job.fd_con, pev_in | pev_out) != 0)
+    {
+      vdone.push_back(job.fd_con);
     }
   }
-  WNDX_LOG(LL::NTFY, "[ OK ] all files are received: {}/{}\n",
-           m_num_files_total, m_num_files_total);
-  return rc::SUCCESS;
 }
 
-[[nodiscard]] int Fserver::recv_file(size_t const i)
+void Fserver::hold(int const fd_con, Fsession const& session)
 {
-  // reference variable to the needed file. (partially complete obj, which lacks
-  // file content). here we recv the last missing element - contents of the file
-  // as the block of memory.
-  file::File& file = m_vfiles.at(i);
-  WNDX_LOG(LL::INFO, "INSIDE recv_file() : {}\n", file);
-
-  // TODO: it will be cool to make - "the small buffer optimization"
-  //       => fixed size buffer on the stack for the small files.
-  m_rc = static_cast<int>(file.alloc());
-  if (m_rc != 0) {
-    return m_rc;
+  if (std::find(m_vgroup.begin(), m_vgroup.end(), fd_con) != m_vgroup.end() ||
+      std::find(m_vsyncing.begin(), m_vsyncing.end(), fd_con) !=
+          m_vsyncing.end())
+  {
+    return; // already waits.
   }
-  m_rc = recv_loop(m_fd_con, file.memory(), file.size());
-  if (m_rc != 0) {
-    WNDX_LOG(LL::ERRO, "[FAIL] recv_file() in recv_loop() -> {} : {}\n", m_rc,
-             file);
-    return m_rc;
+  if (!m_group_due) { // the first one opens the time window of the group.
+    m_group_due = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(cfg::group_commit_ms);
   }
-  WNDX_LOG(LL::STAT, "[ OK ] recv_file() : {}\n", file);
+  m_vgroup.push_back(fd_con);
+  m_group_bytes += session.committed();
+}
 
-  // write file to the storage dir.
-  m_rc = static_cast<int>(file.write());
-  if (m_rc != 0) {
-    return m_rc;
+[[nodiscard]] int Fserver::group_timeout() const noexcept
+{
+  if (!m_group_due || m_syncing) {
+    return -1;
   }
-  return 0;
+  if (m_group_bytes >= cfg::group_commit_bytes) {
+    return 0;
+  }
+  auto const left{ std::chrono::ceil<std::chrono::milliseconds>(
+      *m_group_due - std::chrono::steady_clock::now()) };
+  return static_cast<int>(std::max<i64>(left.count(), 0));
+}
+
+void Fserver::group_commit()
+{
+  WNDX_LOG(LL::INFO, "group commit: {} sessions, {} B\n", m_vgroup.size(),
+           m_group_bytes);
+  m_vsyncing.swap(m_vgroup);
+  m_vgroup.clear();
+  m_group_bytes = 0;
+  m_group_due.reset();
+  m_syncing = true;
+  syncer().request(m_storage_dir, m_fd_synced);
 }
 
-template <typename T>
-[[nodiscard]] int Fserver::recv_loop(int fd, void* buf, size_t len)
+void Fserver::group_synced(std::vector<int>& vdone)
 {
-  T*      bufptr{ static_cast<T*>(buf) };
-  size_t  toread{ len };
-  ssize_t nbytes{ -1 }; // nbytes recv || -1 - error val. ref: recv(2).
-  // loop till all bytes are recv or till the error.
-  while ((nbytes = recv(fd, bufptr, toread, 0)) > 0) {
-    switch (nbytes) {
-    case -1: log_g.errnum(errno, "[FAIL] recv() error occurred"); return -1;
-    case 0:
-      WNDX_LOG(LL::WARN, "[FAIL] recv() -> 0 - orderly shutdown!\n");
-      return -2;
-    default: WNDX_LOG(LL::DBUG, "nbytes recv_loop() :  {}\n", nbytes);
+  u64 res{ 0 };
+  if (read(m_fd_synced, &res, sizeof(res)) == -1) {
+    if (errno != EAGAIN) {
+      log_g.errnum(errno, "[FAIL] group_synced() read()");
     }
-    bufptr += nbytes;                      // next position to read into
-    toread -= static_cast<size_t>(nbytes); // read less next time
+    return;
   }
-  WNDX_LOG(LL::DBUG, "[ OK ] recv_loop() finished\n");
-  return 0;
+  m_syncing = false;
+  for (int const fd_con : m_vsyncing) {
+    Fsession& session{ *m_sessions.at(fd_con) };
+    session.synced();
+    // not flushed => files are not reported as received. (no final reply)
+    if (res != 1 || session.on_writable() != 0) {
+      vdone.push_back(fd_con);
+    } else if (m_engine == Engine::URING && session.want_write()) {
+      m_vwriting.push_back(fd_con);
+    } else if (m_engine == Engine::EPOLL && session.want_write() &&
+               m_poller.mod(fd_con, pev_in | pev_out) != 0)
+    {
+      vdone.push_back(fd_con);
+    }
+  }
+  m_vsyncing.clear();
 }
 
 [[nodiscard]] int Fserver::create_socket()
@@ -208,6 +486,30 @@ template <typename T>
     log_g.errnum(errno, "[FAIL] socket()");
     return -1;
   }
+  // the listening socket is long-lived => allow fast restarts of the daemon.
+  int const optval{ 1 };
+  if (setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) ==
+      -1)
+  {
+    log_g.errnum(errno, "[FAIL] setsockopt() SO_REUSEADDR");
+    return -1;
+  }
+  if (m_reuseport) {
+#ifdef SO_REUSEPORT
+    if (setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) ==
+        -1)
+    {
+      log_g.errnum(errno, "[FAIL] setsockopt() SO_REUSEPORT");
+      return -1;
+    }
+#else
+    WNDX_LOG(LL::ERRO, "[FAIL] SO_REUSEPORT is not supported by the platform\n");
+    return -1;
+#endif // SO_REUSEPORT
+  }
+  if (io::set_nonblock(m_fd) != 0) {
+    return -1;
+  }
   WNDX_LOG(LL::DBUG, "[ OK ] socket()\n");
   return m_fd; // return file descriptor
 }
@@ -236,32 +538,87 @@ template <typename T>
   case 0:
     WNDX_LOG(LL::INFO,
              "[ OK ] marked socket to accept incoming connection requests\n");
-    break;
-  default: WNDX_LOG(LL::CRIT, "UNEXPECTED return code: listen() -> {}\n", m_rc);
-  }
-  if (m_fd_con == 0) {
     WNDX_LOG(LL::NTFY, "backlog: {} (Max queue len of pending connections)\n",
              m_backlog);
+    break;
+  default: WNDX_LOG(LL::CRIT, "UNEXPECTED return code: listen() -> {}\n", m_rc);
   }
   return m_rc;
 }
 
-[[nodiscard]] int Fserver::accept_connection()
+[[nodiscard]] int Fserver::accept_connections()
 {
-  // casts are the necessity! ref: bind(2), accept(2)
-  // NOLINTNEXTLINE(*-reinterpret-cast)
-  m_fd_con = accept(m_fd, reinterpret_cast<struct sockaddr*>(&m_sockaddr_in),
-                    &m_addrlen);
-  switch (m_fd_con) {
-  case -1: log_g.errnum(errno, "[FAIL] accept()"); break;
-  case 0 : WNDX_LOG(LL::WARN, "[DOUBT] accept() -> 0 ???\n"); break;
-  default:
-    WNDX_LOG(LL::DBUG, "[ OK ] accept() - new connected socket created\n");
-  }
-  if (m_fd_con > 0) {
-    WNDX_LOG(LL::NTFY, "accepted connection from: {}\n", host_addr_ipv4());
-  }
-  return m_fd_con;
+  for (;;) {
+    struct sockaddr_in sa{};
+    socklen_t          salen{ sizeof(sa) };
+    // casts are the necessity! ref: bind(2), accept(2)
+    // NOLINTNEXTLINE(*-reinterpret-cast)
+    int fd_con{ accept(m_fd, reinterpret_cast<struct sockaddr*>(&sa), &salen) };
+    if (fd_con == -1) {
+      switch (errno) {
+      case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+      case EWOULDBLOCK:
+#endif
+        return 0; // all pending connections are accepted.
+      case EMFILE:
+      case ENFILE:
+        log_g.errnum(errno, "[FAIL] accept()");
+        shed_connection();
+        return 0;
+      case EINTR:
+      case ECONNABORTED:
+      case ENOBUFS:
+      case ENOMEM:
+      case EPERM:
+      case EPROTO:
+        // not fatal for the server, only for the pending connection.
+        log_g.errnum(errno, "[FAIL] accept()");
+        return 0;
+      default: log_g.errnum(errno, "[FAIL] accept()"); return -1;
+      }
+    }
+    std::string const peer{ host_addr_ipv4(sa) };
+    WNDX_LOG(LL::NTFY, "accepted connection from: {}\n", peer);
+
+    fs::path dir{};
+    if (mkdir_sub_storage(peer, dir) != rc::SUCCESS) {
+      io::close_fd(fd_con, "fd_con");
+      continue;
+    }
+    // long-lived sessions may be idle for long => detect the dead peers.
+    static_cast<void>(io::set_keepalive(fd_con));
+    auto session{ std::make_unique<Fsession>(fd_con, peer, dir, m_pool,
+                                             m_hcache) };
+    session->set_durability(m_durability);
+    if (m_engine == Engine::URING) {
+      // recv of io_uring respects O_NONBLOCK (-EAGAIN) => the socket is kept
+      // blocking, replies never block the loop. (send(MSG_DONTWAIT))
+      session->set_deferred_writes(true);
+      m_vaccepted.push_back(fd_con);
+    } else if (io::set_nonblock(fd_con) != 0 ||
+               m_poller.add(fd_con, pev_in) != 0)
+    {
+      continue; // session dtor closes the connected socket.
+    }
+    m_sessions.emplace(fd_con, std::move(session));
+    WNDX_LOG(LL::INFO, "active sessions: {}\n", m_sessions.size());
+  }
+}
+
+void Fserver::shed_connection() noexcept
+{
+  if (m_fd_spare == -1) {
+    return;
+  }
+  io::close_fd(m_fd_spare, "m_fd_spare");
+  int fd_con{ accept(m_fd, nullptr, nullptr) };
+  if (fd_con != -1) {
+    WNDX_LOG(LL::WARN, "out of fds => pending connection is closed\n");
+    io::close_fd(fd_con, "fd_con");
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  m_fd_spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
 }
 
 [[nodiscard]] rc Fserver::init()
@@ -290,16 +647,36 @@ template <typename T>
     return rc::UNIX_SOCK_LSTN_ERRO;
   }
 
-  m_rc = accept_connection();
-  if (m_rc < 1) { // a non negative integer on success (excluding 0?)
-    WNDX_LOG(LL::ERRO, "[FAIL] in init() : accept_connection()\n");
-    return rc::UNIX_SOCK_CONN_ERRO;
+  // NOLINTNEXTLINE(*-vararg)
+  m_fd_spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  if (m_fd_spare == -1) {
+    log_g.errnum(errno, "[FAIL] in init() : spare fd open()");
   }
 
-  rc rc = mkdir_sub_storage();
-  if (rc != rc::SUCCESS) {
-    WNDX_LOG(LL::ERRO, "[FAIL] in init() : mkdir_sub_storage()\n");
-    return rc;
+  m_fd_stop = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_fd_stop == -1) {
+    log_g.errnum(errno, "[FAIL] in init() : eventfd()");
+    return rc::UNIX_SOCK_LSTN_ERRO;
+  }
+
+  m_fd_synced = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (m_fd_synced == -1) {
+    log_g.errnum(errno, "[FAIL] in init() : eventfd()");
+    return rc::UNIX_SOCK_LSTN_ERRO;
+  }
+
+  if (m_sigworker.init() != 0) {
+    return rc::UNIX_SOCK_LSTN_ERRO;
+  }
+
+  m_rc = m_poller.init();
+  if (m_rc != 0 || m_poller.add(m_fd, pev_in) != 0 ||
+      m_poller.add(m_fd_stop, pev_in) != 0 ||
+      m_poller.add(m_fd_synced, pev_in) != 0 ||
+      m_poller.add(m_sigworker.fd(), pev_in) != 0)
+  {
+    WNDX_LOG(LL::ERRO, "[FAIL] in init() : m_poller\n");
+    return rc::UNIX_SOCK_LSTN_ERRO;
   }
 
   WNDX_LOG(LL::STAT, "[ OK ] init() - server initialized\n");
@@ -319,16 +696,20 @@ template <typename T>
   return 0;
 }
 
-[[nodiscard]] rc Fserver::mkdir_sub_storage()
+[[nodiscard]] rc Fserver::mkdir_sub_storage(std::string const& peer,
+                                            fs::path&          dir)
 {
   // TODO: MAC/UID additionally.
-  fs::path const new_sub_storage_dir{ m_storage_dir_sub / host_addr_ipv4() };
-
-  rc rc = file::mkdir(new_sub_storage_dir, fs::perms::owner_all);
-  if (rc != rc::SUCCESS) {
-    return rc;
+  fs::path const new_sub_storage_dir{ m_storage_dir / peer };
+
+  // sub-storage may already exist from the previous session of the peer,
+  // or may be created right now by the other worker => EEXIST is not an error.
+  // (permissions for owner only are set atomically with the creation)
+  if (::mkdir(new_sub_storage_dir.c_str(), S_IRWXU) == -1 && errno != EEXIST) {
+    log_g.errnum(errno, "[FAIL] mkdir_sub_storage() mkdir()");
+    return rc::FAILURE;
   }
-  m_storage_dir_sub = new_sub_storage_dir;
+  dir = new_sub_storage_dir;
   return rc::SUCCESS;
 }
 
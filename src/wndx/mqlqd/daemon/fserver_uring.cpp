@@ -0,0 +1,458 @@
+/// io_uring(7) event loop of the file server. (Engine::URING)
+/// Built only if liburing is found at configure time (MQLQD_HAS_IO_URING),
+/// otherwise the file server falls back to the epoll event loop.
+
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/fserver.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/io.hpp"
+
+#include <fmt/format.h>
+
+#ifndef MQLQD_HAS_IO_URING
+#define MQLQD_HAS_IO_URING 0 // NOLINT(*-macro-usage)
+#endif // MQLQD_HAS_IO_URING
+
+#if MQLQD_HAS_IO_URING
+#include <cerrno>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+
+#include <liburing.h>
+#include <poll.h>    // POLLIN, POLLOUT
+#include <sys/uio.h> // struct iovec
+
+} // extern "C"
+#endif // MQLQD_HAS_IO_URING
+
+namespace wndx::mqlqd {
+
+#if MQLQD_HAS_IO_URING
+
+namespace {
+
+/// kind of the submitted operation. (stored in the user data of the SQE)
+enum class Uop : u8
+{
+  ACCEPT,  // listening socket is ready to accept.
+  READY,   // connection is readable => recv when the buffer is free.
+  RECV,    // recv into the registered buffer of the connection.
+  SEND,    // connection is writable => send the rest of the replies.
+  WRITE,   // write of the received file content from the registered buffer.
+  TIMEOUT, // end of the time window of the group commit.
+  SYNCED,  // the flush of the group is done. (m_fd_synced)
+  SIGS,    // delta signatures are done. (m_sigworker)
+  STOP,    // the stop() is signaled.
+};
+
+/// user data layout: [ Uop : 8 | index of the Wop : 24 | fd : 32 ].
+[[nodiscard]] constexpr u64 udata(Uop op, int fd, size_t idx = 0) noexcept
+{
+  return (static_cast<u64>(op) << 56U) |
+         ((static_cast<u64>(idx) & 0xFFFFFFU) << 32U) | static_cast<u32>(fd);
+}
+[[nodiscard]] constexpr Uop udata_op(u64 ud) noexcept
+{
+  return static_cast<Uop>(ud >> 56U);
+}
+[[nodiscard]] constexpr size_t udata_idx(u64 ud) noexcept
+{
+  return static_cast<size_t>((ud >> 32U) & 0xFFFFFFU);
+}
+[[nodiscard]] constexpr int udata_fd(u64 ud) noexcept
+{
+  return static_cast<int>(static_cast<u32>(ud));
+}
+
+/// \brief io_uring instance with the registered (fixed) receive buffers.
+class Uring final
+{
+public:
+  Uring(Uring&&)                 = delete;
+  Uring(Uring const&)            = delete;
+  Uring& operator=(Uring&&)      = delete;
+  Uring& operator=(Uring const&) = delete;
+  Uring()                        = default;
+
+  ~Uring() noexcept
+  {
+    if (m_init) {
+      io_uring_queue_exit(&m_ring);
+    }
+  }
+
+  /// \param  pool - memory of the registered buffers. (huge pages)
+  /// \return 0 on success, else -errno.
+  [[nodiscard]] int init(Bpool& pool)
+  {
+    int ret{ io_uring_queue_init(cfg::uring_entries, &m_ring, 0) };
+    if (ret < 0) {
+      return ret;
+    }
+    m_init = true;
+    m_pool = pool.take(cfg::uring_bufs * cfg::chunk_size);
+    if (m_pool.empty()) {
+      return -ENOMEM;
+    }
+    std::vector<struct iovec> iovs(cfg::uring_bufs);
+    for (size_t i = 0; i < iovs.size(); ++i) {
+      iovs[i].iov_base = m_pool.data() + (i * cfg::chunk_size);
+      iovs[i].iov_len  = cfg::chunk_size;
+      m_vfree.push_back(static_cast<int>(i));
+    }
+    ret = io_uring_register_buffers(&m_ring, iovs.data(),
+                                    static_cast<unsigned>(iovs.size()));
+    return ret < 0 ? ret : 0;
+  }
+
+  /// \brief get SQE, submit already queued SQEs if the SQ ring is full.
+  [[nodiscard]] struct io_uring_sqe* sqe()
+  {
+    struct io_uring_sqe* sqe{ io_uring_get_sqe(&m_ring) };
+    if (sqe == nullptr) {
+      io_uring_submit(&m_ring);
+      sqe = io_uring_get_sqe(&m_ring);
+    }
+    return sqe;
+  }
+
+  [[nodiscard]] char* buf(int slot) noexcept
+  {
+    return m_pool.data() + (static_cast<size_t>(slot) * cfg::chunk_size);
+  }
+
+  /// \return index of the free registered buffer, -1 if all are in use.
+  [[nodiscard]] int acquire() noexcept
+  {
+    if (m_vfree.empty()) {
+      return -1;
+    }
+    int const slot{ m_vfree.back() };
+    m_vfree.pop_back();
+    return slot;
+  }
+
+  void release(int& slot) noexcept
+  {
+    if (slot >= 0) {
+      m_vfree.push_back(slot);
+      slot = -1;
+    }
+  }
+
+  [[nodiscard]] struct io_uring* ring() noexcept { return &m_ring; }
+
+private:
+  struct io_uring   m_ring{};
+  bool              m_init{ false };
+  Buf               m_pool;  // memory of the registered buffers.
+  std::vector<int>  m_vfree; // indexes of the free registered buffers.
+};
+
+/// \brief io_uring state of the connection.
+struct Uconn
+{
+  int              slot{ -1 };         // registered buffer (-1 none).
+  bool             closing{ false };   // close when the writes are completed.
+  bool             failed{ false };    // a write failed => nothing committed.
+  bool             streaming{ false }; // the last recv filled the buffer.
+  bool             sending{ false };   // waits for the writability.
+  std::vector<Wop> vwops;              // writes in flight.
+  size_t           pending{ 0 };       // number of the writes in flight.
+};
+
+} // namespace
+
+[[nodiscard]] rc Fserver::run_uring()
+{
+  Uring uring{};
+  int   ret{ uring.init(m_pool) };
+  if (ret < 0) {
+    log_g.errnum(-ret, "[FAIL] io_uring init, fallback to the epoll engine");
+    return run_epoll();
+  }
+  WNDX_LOG(LL::NTFY, "[ OK ] io_uring engine: {} registered buffers\n",
+           cfg::uring_bufs);
+
+  // idle & slow connections wait for the readiness without the buffer
+  // => buffers are used only by the connections with the data to recv.
+  std::unordered_map<int, Uconn> uconns;
+  std::vector<int>               vready; // readable, wait for the buffer.
+
+  auto const arm_accept{ [&uring, this]() {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, m_fd, POLLIN);
+    io_uring_sqe_set_data64(sqe, udata(Uop::ACCEPT, m_fd));
+  } };
+
+  auto const arm_ready{ [&uring](int fd) {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, fd, POLLIN);
+    io_uring_sqe_set_data64(sqe, udata(Uop::READY, fd));
+  } };
+
+  auto const arm_recv{ [&uring](int fd, Uconn& uc) {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_read_fixed(sqe, fd, uring.buf(uc.slot), cfg::chunk_size, 0,
+                             uc.slot);
+    io_uring_sqe_set_data64(sqe, udata(Uop::RECV, fd));
+  } };
+
+  // replies not sent at once wait for the writability. (never blocks)
+  auto const arm_send{ [&uring](int fd, Uconn& uc) {
+    if (uc.sending) {
+      return;
+    }
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, fd, POLLOUT);
+    io_uring_sqe_set_data64(sqe, udata(Uop::SEND, fd));
+    uc.sending = true;
+  } };
+
+  /// all writes of the connection are completed => recv more or close.
+  auto const writes_done{ [&uring, &uconns, &vready, &arm_ready, &arm_send,
+                            this](int fd) {
+    Uconn&    uc{ uconns.at(fd) };
+    Fsession& session{ *m_sessions.at(fd) };
+    if (uc.failed) {
+      session.writes_failed();
+    }
+    if (session.writes_done() != 0) {
+      uc.closing = true;
+    }
+    uc.vwops.clear();
+    uring.release(uc.slot);
+    // replies follow the writes => the Verdict covers the committed files.
+    if (!uc.closing && session.want_write() && session.on_writable() == -1) {
+      uc.closing = true;
+    }
+    if (!uc.closing && session.want_write()) {
+      arm_send(fd, uc);
+      if (session.state() == Sstate::DONE) {
+        return; // closed when the final reply is sent.
+      }
+    }
+    if (!uc.closing && session.want_sync()) {
+      hold(fd, session);
+      if (session.state() == Sstate::DONE) {
+        return; // recv is not armed: the peer waits for the final reply.
+      }
+    }
+    if (uc.closing || session.state() == Sstate::DONE) {
+      uconns.erase(fd);
+      close_session(fd);
+      return;
+    }
+    // more of the stream is likely queued => no wait for the readiness.
+    if (uc.streaming) {
+      vready.push_back(fd);
+    } else {
+      arm_ready(fd);
+    }
+  } };
+
+  struct __kernel_timespec ts{}; // of the armed timeout of the group.
+  bool                     timer{ false };
+  std::vector<int>         vdone;
+
+  auto const arm_synced{ [&uring, this]() {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, m_fd_synced, POLLIN);
+    io_uring_sqe_set_data64(sqe, udata(Uop::SYNCED, m_fd_synced));
+  } };
+
+  auto const arm_sigs{ [&uring, this]() {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, m_sigworker.fd(), POLLIN);
+    io_uring_sqe_set_data64(sqe, udata(Uop::SIGS, m_sigworker.fd()));
+  } };
+
+  arm_accept();
+  arm_synced();
+  arm_sigs();
+  {
+    struct io_uring_sqe* sqe{ uring.sqe() };
+    io_uring_prep_poll_add(sqe, m_fd_stop, POLLIN);
+    io_uring_sqe_set_data64(sqe, udata(Uop::STOP, m_fd_stop));
+  }
+  for (;;) {
+    for (int const fd : m_vaccepted) {
+      uconns.emplace(fd, Uconn{});
+      arm_ready(fd);
+    }
+    m_vaccepted.clear();
+    for (int const fd : m_vwriting) {
+      arm_send(fd, uconns.at(fd));
+    }
+    m_vwriting.clear();
+    // arm recv of the readable connections while there are free buffers.
+    while (!vready.empty()) {
+      Uconn& uc{ uconns.at(vready.back()) };
+      uc.slot = uring.acquire();
+      if (uc.slot == -1) {
+        break;
+      }
+      arm_recv(vready.back(), uc);
+      vready.pop_back();
+    }
+
+    ret = io_uring_submit_and_wait(uring.ring(), 1);
+    if (ret < 0 && ret != -EINTR) {
+      log_g.errnum(-ret, "[FAIL] io_uring_submit_and_wait()");
+      return rc::UNIX_SOCK_RECV_ERRO;
+    }
+
+    unsigned             head{ 0 };
+    unsigned             ncqe{ 0 };
+    struct io_uring_cqe* cqe{ nullptr };
+    io_uring_for_each_cqe(uring.ring(), head, cqe)
+    {
+      ++ncqe;
+      u64 const ud{ io_uring_cqe_get_data64(cqe) };
+      int const res{ cqe->res };
+      int const fd{ udata_fd(ud) };
+      switch (udata_op(ud)) {
+      case Uop::ACCEPT:
+        if (accept_connections() != 0) {
+          return rc::UNIX_SOCK_CONN_ERRO;
+        }
+        arm_accept();
+        break;
+      case Uop::READY: // errors & hangups are seen by the recv.
+        if (uconns.contains(fd)) {
+          vready.push_back(fd);
+        }
+        break;
+      case Uop::RECV: {
+        Uconn&    uc{ uconns.at(fd) };
+        Fsession& session{ *m_sessions.at(fd) };
+        if (res <= 0) {
+          if (res < 0) {
+            log_g.errnum(-res, "[FAIL] io_uring recv");
+          } else if (!session.idle()) {
+            WNDX_LOG(LL::WARN, "[FAIL] recv() -> 0 - orderly shutdown!\n");
+          }
+          uc.closing = true;
+          writes_done(fd);
+          break;
+        }
+        uc.streaming = static_cast<size_t>(res) == cfg::chunk_size;
+        if (session.feed(uring.buf(uc.slot), static_cast<size_t>(res)) != 0) {
+          uc.closing = true;
+        }
+        if (session.want_sigs()) {
+          offload(session);
+        }
+        uc.vwops.swap(session.wops());
+        for (size_t i = 0; i < uc.vwops.size(); ++i) {
+          Wop const&           wop{ uc.vwops[i] };
+          struct io_uring_sqe* sqe{ uring.sqe() };
+          io_uring_prep_write_fixed(sqe, wop.fd, wop.data,
+                                    static_cast<unsigned>(wop.len),
+                                    static_cast<u64>(wop.off), uc.slot);
+          io_uring_sqe_set_data64(sqe, udata(Uop::WRITE, fd, i));
+        }
+        uc.pending = uc.vwops.size();
+        if (uc.pending == 0) {
+          writes_done(fd);
+        }
+        break;
+      }
+      case Uop::SEND: { // errors & hangups are seen by the send.
+        auto const it{ uconns.find(fd) };
+        if (it == uconns.end()) {
+          break;
+        }
+        Uconn&    uc{ it->second };
+        Fsession& session{ *m_sessions.at(fd) };
+        uc.sending = false;
+        if (session.on_writable() == 0) {
+          if (session.want_write()) {
+            arm_send(fd, uc);
+          }
+        } else if (uc.slot != -1) { // recv or writes in flight.
+          uc.closing = true;
+        } else {
+          std::erase(vready, fd);
+          uconns.erase(fd);
+          close_session(fd);
+        }
+        break;
+      }
+      case Uop::TIMEOUT: timer = false; break;
+      case Uop::SYNCED:
+        vdone.clear();
+        group_synced(vdone);
+        for (int const fd_done : vdone) {
+          uconns.erase(fd_done);
+          close_session(fd_done);
+        }
+        arm_synced();
+        break;
+      case Uop::SIGS:
+        vdone.clear();
+        sigs_done(vdone);
+        for (int const fd_done : vdone) {
+          uconns.erase(fd_done);
+          close_session(fd_done);
+        }
+        arm_sigs();
+        break;
+      case Uop::STOP:
+        WNDX_LOG(LL::NTFY, "[ OK ] run() - server stopped\n");
+        return rc::SUCCESS;
+      case Uop::WRITE: {
+        Uconn&     uc{ uconns.at(fd) };
+        Wop const& wop{ uc.vwops.at(udata_idx(ud)) };
+        if (res < 0) {
+          log_g.errnum(-res, "[FAIL] io_uring write");
+          uc.failed = true;
+        } else if (static_cast<size_t>(res) < wop.len) {
+          // short write => complete the rest synchronously. (rare case)
+          auto const n{ static_cast<size_t>(res) };
+          if (io::pwrite_loop(wop.fd, wop.data + n, wop.len - n,
+                              wop.off + res) != 0)
+          {
+            uc.failed = true;
+          }
+        }
+        // the current file may miss the content too => the session ends.
+        uc.closing = uc.closing || uc.failed;
+        if (--uc.pending == 0) {
+          writes_done(fd);
+        }
+        break;
+      }
+      }
+    }
+    io_uring_cq_advance(uring.ring(), ncqe);
+
+    int const due{ group_timeout() };
+    if (due == 0) {
+      group_commit();
+    } else if (due > 0 && !timer) {
+      ts.tv_sec  = due / 1000;
+      ts.tv_nsec = static_cast<long long>(due % 1000) * 1000 * 1000;
+      struct io_uring_sqe* sqe{ uring.sqe() };
+      io_uring_prep_timeout(sqe, &ts, 0, 0);
+      io_uring_sqe_set_data64(sqe, udata(Uop::TIMEOUT, m_fd));
+      timer = true;
+    }
+  }
+}
+
+#else // built without liburing
+
+[[nodiscard]] rc Fserver::run_uring()
+{
+  WNDX_LOG(LL::WARN, "built without io_uring, fallback to the epoll engine\n");
+  return run_epoll();
+}
+
+#endif // MQLQD_HAS_IO_URING
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,1477 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/fsession.hpp"
+
+#include "wndx/mqlqd/codec.hpp"
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/crc32c.hpp"
+#include "wndx/mqlqd/delta.hpp"
+#include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/io.hpp"
+#include "wndx/mqlqd/proto.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio> // rename(3)
+#include <cstring>
+#include <iterator> // std::prev
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+extern "C" {
+
+#include <fcntl.h> // open(2), fallocate(2), linkat(2)
+#include <sys/socket.h>
+#include <sys/stat.h> // stat(2), mkdir(2)
+#include <sys/types.h>
+#include <unistd.h> // ftruncate(2), unlink(2), read(2), fdatasync(2), getpid(2)
+
+} // extern "C"
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// \brief FNV-1a hash. (stable between the runs & builds of the daemon)
+[[nodiscard]] u64 fnv1a(sv_t const s) noexcept
+{
+  u64 h{ 0xCBF29CE484222325ULL };
+  for (char const c : s) {
+    h ^= static_cast<u8>(c);
+    h *= 0x100000001B3ULL;
+  }
+  return h;
+}
+
+/// \brief relative path of the file inside of the sub-storage. (fl_tree)
+/// never trust the peer: only the plain components => no dir traversal.
+///
+/// \return empty path if the name is not valid.
+[[nodiscard]] fs::path tree_name(std::string const& name)
+{
+  fs::path rel;
+  for (size_t pos = 0;;) {
+    size_t const end{ name.find('/', pos) };
+    sv_t const   comp{ sv_t(name).substr(pos, end - pos) };
+    if (comp.empty() || comp == "." || comp == "..") {
+      return {};
+    }
+    rel /= comp;
+    if (end == std::string::npos) {
+      return rel;
+    }
+    pos = end + 1;
+  }
+}
+
+/// \brief make the missing dirs of the relative path inside of the base dir.
+/// (owner only, as the storage itself; symlinks are never followed)
+[[nodiscard]] int make_dirs(fs::path const& base, fs::path const& rel)
+{
+  fs::path dir{ base };
+  for (auto const& comp : rel) {
+    dir /= comp;
+    if (::mkdir(dir.c_str(), S_IRWXU) == 0) {
+      continue;
+    }
+    struct stat st{};
+    if (errno != EEXIST || ::lstat(dir.c_str(), &st) == -1) {
+      log_g.errnum(errno, "[FAIL] make_dirs() mkdir()");
+      return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+      WNDX_LOG(LL::ERRO, "[FAIL] make_dirs() not a dir : {}\n", dir);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/// \brief give the name to the anonymous file. (O_TMPFILE)
+[[nodiscard]] int link_fd(int const fd, fs::path const& path) noexcept
+{
+  std::string const proc{ fmt::format("/proc/self/fd/{}", fd) };
+  for (int i = 0; i < 2; ++i) {
+    if (linkat(AT_FDCWD, proc.c_str(), AT_FDCWD, path.c_str(),
+               AT_SYMLINK_FOLLOW) == 0)
+    {
+      return 0;
+    }
+    if (errno != EEXIST) {
+      break;
+    }
+    static_cast<void>(::unlink(path.c_str())); // stale. (e.g. crash)
+  }
+  log_g.errnum(errno, "[FAIL] commit_file() linkat()");
+  return -1;
+}
+
+/// \brief checksum of the partial file: the running crc32c of its content,
+/// saved when the session is interrupted => the resumed content is not read.
+[[nodiscard]] fs::path crc_path(fs::path part)
+{
+  return part.replace_extension(".crc");
+}
+
+/// \brief save the running crc32c of the first off bytes of the partial file.
+void save_crc(fs::path const& part, u64 const off, u32 const crc)
+{
+  std::string const line{ fmt::format("{} {:08x}\n", off, crc) };
+  fs::path const    path{ crc_path(part) };
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  int fd{ open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+               S_IRUSR | S_IWUSR) };
+  if (fd == -1 || io::pwrite_loop(fd, line.data(), line.size(), 0) != 0) {
+    log_g.errnum(errno, "[FAIL] save_crc() : partial file is received again");
+    static_cast<void>(::unlink(path.c_str()));
+  }
+  io::close_fd(fd, "save_crc() fd");
+}
+
+/// \brief load the saved crc32c of the partial file of the size.
+///
+/// \return true if it is saved for exactly the size of the partial file.
+[[nodiscard]] bool load_crc(fs::path const& part, u64 const size, u32& crc)
+{
+  // NOLINTNEXTLINE(*-vararg)
+  int fd{ open(crc_path(part).c_str(), O_RDONLY | O_CLOEXEC) };
+  if (fd == -1) {
+    return false;
+  }
+  std::array<char, 64> line{};
+  ssize_t const        n{ read(fd, line.data(), line.size()) };
+  io::close_fd(fd, "load_crc() fd");
+  char const* const end{ line.data() + std::max<ssize_t>(n, 0) };
+  u64               off{ 0 };
+  auto const [p_off, ec_off]{ std::from_chars(line.data(), end, off) };
+  if (ec_off != std::errc{} || p_off == end || *p_off != ' ') {
+    return false;
+  }
+  auto const [p_crc, ec_crc]{ std::from_chars(p_off + 1, end, crc, 16) };
+  return ec_crc == std::errc{} && p_crc != end && *p_crc == '\n' &&
+         off == size;
+}
+
+/// \brief files received as the ranges by the sessions of all workers.
+/// All ranges of the file are written into its shared temporary file, which
+/// takes the final name only when the whole file is verified. The incomplete
+/// one outlives the sessions writing it (the streams of the client connect
+/// one after another), it is removed when it is stale: no session wrote it
+/// for cfg::range_stale seconds. (checked by the next acquire() or release())
+class Rfiles final
+{
+public:
+  Rfiles(Rfiles&&)                 = delete;
+  Rfiles(Rfiles const&)            = delete;
+  Rfiles& operator=(Rfiles&&)      = delete;
+  Rfiles& operator=(Rfiles const&) = delete;
+  ~Rfiles() noexcept               = default;
+
+  Rfiles() noexcept = default;
+
+  /// \brief the session writes the range of the file. (before it is opened)
+  ///
+  /// \param ref - first range of the file written by the session.
+  void acquire(std::string const& tmp, u64 const total, bool const ref)
+  {
+    std::lock_guard const lock{ m_mtx };
+    sweep();
+    Rfile& rfile{ m_rfiles[tmp] };
+    if (rfile.complete) { // the next transfer of the same file.
+      rfile.complete = false;
+      rfile.vdone.clear();
+    }
+    rfile.total = total;
+    rfile.refs += ref ? 1 : 0;
+  }
+
+  /// \brief the range is written & verified.
+  ///
+  /// \return true when the whole file is => it takes the final name.
+  [[nodiscard]] bool add(std::string const& tmp, u64 const off, u64 const len)
+  {
+    std::lock_guard const lock{ m_mtx };
+    auto const            it{ m_rfiles.find(tmp) };
+    if (it == m_rfiles.end() || it->second.complete) {
+      return false;
+    }
+    Rfile& rfile{ it->second };
+    // the same range may be received again. (e.g. the retried transfer)
+    u64 end{ off + len };
+    u64 beg{ off };
+    auto next{ rfile.vdone.upper_bound(beg) };
+    if (next != rfile.vdone.begin() && std::prev(next)->second >= beg) {
+      --next;
+      beg = next->first;
+    }
+    while (next != rfile.vdone.end() && next->first <= end) {
+      end  = std::max(end, next->second);
+      next = rfile.vdone.erase(next);
+    }
+    rfile.vdone[beg] = end;
+    rfile.complete   = rfile.vdone.size() == 1 &&
+                     rfile.vdone.begin()->first == 0 &&
+                     rfile.vdone.begin()->second >= rfile.total;
+    return rfile.complete;
+  }
+
+  /// \brief the session is finished => the incomplete file which is not
+  /// written by any session anymore waits for the other streams.
+  void release(std::string const& tmp)
+  {
+    std::lock_guard const lock{ m_mtx };
+    auto const            it{ m_rfiles.find(tmp) };
+    if (it != m_rfiles.end() && --it->second.refs == 0) {
+      if (it->second.complete) {
+        m_rfiles.erase(it);
+      } else {
+        it->second.idle = std::chrono::steady_clock::now();
+      }
+    }
+    sweep();
+  }
+
+private:
+  struct Rfile
+  {
+    u64                total{ 0 };
+    std::map<u64, u64> vdone; // verified: [off, end) by the off.
+    unsigned           refs{ 0 };
+    bool               complete{ false };
+    // since the last session writing it is gone. (refs == 0)
+    std::chrono::steady_clock::time_point idle{};
+  };
+
+  /// \brief remove the stale incomplete files. (final failure)
+  void sweep()
+  {
+    auto const now{ std::chrono::steady_clock::now() };
+    std::erase_if(m_rfiles, [now](auto const& entry) {
+      Rfile const& rfile{ entry.second };
+      if (rfile.refs > 0 || rfile.complete ||
+          now - rfile.idle < std::chrono::seconds(cfg::range_stale))
+      {
+        return false;
+      }
+      WNDX_LOG(LL::WARN, "[FAIL] incomplete ranges are stale => removed : "
+                         "{}\n",
+               entry.first);
+      static_cast<void>(::unlink(entry.first.c_str()));
+      return true;
+    });
+  }
+
+  std::mutex                             m_mtx;
+  std::unordered_map<std::string, Rfile> m_rfiles;
+};
+
+[[nodiscard]] Rfiles& rfiles()
+{
+  static Rfiles rfiles;
+  return rfiles;
+}
+
+/// \brief flush the entries of the dir. (e.g. the renamed file)
+[[nodiscard]] int sync_dir(fs::path const& dir) noexcept
+{
+  // NOLINTNEXTLINE(*-vararg)
+  int fd{ open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+  int rc{ fd == -1 ? -1 : fsync(fd) };
+  if (rc == -1) {
+    log_g.errnum(errno, "[FAIL] commit_file() fsync() of the dir");
+  }
+  io::close_fd(fd, "sync_dir() fd");
+  return rc;
+}
+
+} // namespace
+
+Fsession::Fsession(int fd_con, std::string peer, fs::path storage_dir,
+                   Bpool& pool, Hcache& hcache) noexcept
+    : m_fd_con{ fd_con }
+    , m_peer{ std::move(peer) }
+    , m_storage_dir_sub{ std::move(storage_dir) }
+    , m_pool{ pool }
+    , m_hcache{ hcache }
+{
+  WNDX_LOG(LL::DBUG, "INSIDE ctor Fsession() : {}\n", m_peer);
+}
+
+Fsession::~Fsession() noexcept
+{
+  if (!idle()) {
+    WNDX_LOG(LL::WARN, "[FAIL] session is incomplete: {} ({}/{} files)\n",
+             m_peer, m_base + m_idx, m_num_files_total);
+  }
+  // writes were not performed (e.g. error) => contents are not committed.
+  bool const written{ m_vwops.empty() };
+  if (!written) {
+    for (auto& done : m_vdone) {
+      done.keep = false;
+    }
+  }
+  m_end = false; // nobody to reply to.
+  static_cast<void>(writes_done()); // failures are logged, nobody to tell.
+  // incomplete file: the anonymous one is gone with its fd, the named
+  // temporary one is removed & the partial one is kept for the resume.
+  // (with the checksum of its content, if it is completely written)
+  if (m_fd_out != -1 && !m_tmp.empty() && !resumable()) {
+    static_cast<void>(::unlink(m_tmp.c_str()));
+  } else if (m_fd_out != -1 && !m_tmp.empty() && crc() && written) {
+    save_crc(m_tmp, static_cast<u64>(m_off), m_crc);
+  }
+  io::close_fd(m_fd_out, "m_fd_out");
+  io::close_fd(m_fd_basis, "m_fd_basis");
+  io::close_fd(m_fd_con, "m_fd_con");
+  for (auto const& tmp : m_vranged) {
+    rfiles().release(tmp);
+  }
+  WNDX_LOG(LL::DBUG, "END OF dtor ~Fsession() : {}\n\n", m_peer);
+}
+
+[[nodiscard]] int Fsession::on_readable(std::span<char> buf)
+{
+  ssize_t const nbytes{ recv(m_fd_con, buf.data(), buf.size(), 0) };
+  switch (nbytes) {
+  case -1:
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0; // spurious readiness, wait for the next one.
+    }
+    log_g.errnum(errno, "[FAIL] recv() error occurred");
+    return -1;
+  case 0:
+    if (idle()) {
+      return 1;
+    }
+    WNDX_LOG(LL::WARN, "[FAIL] recv() -> 0 - orderly shutdown! {}\n", m_peer);
+    return -2;
+  default: WNDX_LOG(LL::DBUG, "nbytes on_readable() : {}\n", nbytes);
+  }
+  if (feed(buf.data(), static_cast<size_t>(nbytes)) != 0) {
+    return -1;
+  }
+  // opportunistic: replies are small => usually sent right away.
+  if (want_write()) {
+    return on_writable();
+  }
+  return m_state == Sstate::DONE && m_synced ? 1 : 0;
+}
+
+[[nodiscard]] int Fsession::on_writable()
+{
+  // MSG_DONTWAIT: the socket of the io_uring engine is blocking.
+  while (want_write()) {
+    ssize_t const nbytes{ send(m_fd_con, m_out.data() + m_out_off,
+                               m_out.size() - m_out_off,
+                               MSG_NOSIGNAL | MSG_DONTWAIT) };
+    if (nbytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0; // wait for the next writability.
+      }
+      log_g.errnum(errno, "[FAIL] send() error occurred");
+      return -1;
+    }
+    m_out_off += static_cast<size_t>(nbytes);
+  }
+  m_out.clear();
+  m_out_off = 0;
+  return m_state == Sstate::DONE && m_synced ? 1 : 0;
+}
+
+[[nodiscard]] int Fsession::feed(char const* data, size_t len)
+{
+  using proto::Pres;
+  Pres res{ Pres::OK };
+  while (len > 0) {
+    switch (m_state) {
+    case Sstate::DETECT:
+      if (!take_hdr(data, len, sizeof(proto::magic))) {
+        return 0;
+      }
+      on_detect();
+      break;
+    case Sstate::HELLO: {
+      proto::Hello hello{};
+      res = take_msg(data, len, [&hello](char const* p, size_t n, size_t& k) {
+        return proto::decode(p, n, hello, k);
+      });
+      if (res == Pres::OK && on_hello(hello) != 0) {
+        return -1;
+      }
+      break;
+    }
+    case Sstate::NUM_FILES:
+      if (m_version == 0) {
+        if (!take_hdr(data, len, sizeof(m_num_files_total))) {
+          return 0;
+        }
+        std::memcpy(&m_num_files_total, m_hdr.data(),
+                    sizeof(m_num_files_total));
+        m_hdr.clear();
+      } else {
+        u64 num{ 0 };
+        res = take_msg(data, len, [&num](char const* p, size_t n, size_t& k) {
+          return proto::get_varint(p, n, num, k);
+        });
+        if (res != Pres::OK) {
+          break;
+        }
+        m_num_files_total = num;
+      }
+      WNDX_LOG(LL::DBUG, "[ OK ] recv_num_files_total() : {}\n",
+               m_num_files_total);
+      // reserve in order to avoid potential reallocations later.
+      // (bounded: the count is not trusted until the headers arrive)
+      m_vfiles.reserve(std::min<size_t>(m_num_files_total, cfg::batch_iov_max));
+      m_state = Sstate::FINFO;
+      if (m_num_files_total == 0) { // e.g. keepalive of the idle session.
+        on_end();
+      }
+      break;
+    case Sstate::FINFO:
+      if (m_version == 0) {
+        if (!take_hdr(data, len, sizeof(file::Finfo))) {
+          return 0;
+        }
+        if (on_finfo() != 0) {
+          return -1;
+        }
+        break;
+      }
+      {
+        proto::Fhdr fhdr{};
+        res = take_msg(data, len, [&fhdr](char const* p, size_t n, size_t& k) {
+          return proto::decode(p, n, fhdr, k);
+        });
+        if (res != Pres::OK) {
+          break;
+        }
+        if ((fhdr.hflags & proto::hf_end) != 0) {
+          on_end();
+          break;
+        }
+        WNDX_LOG(LL::INFO, "[ OK ] recv_file_hdr() : {} : {}\n", fhdr.name,
+                 fhdr.size);
+        if ((fhdr.hflags & proto::hf_zframe) != 0 && !m_codec) {
+          WNDX_LOG(LL::ERRO, "[FAIL] compressed content without the codec\n");
+          return -1;
+        }
+        m_range = (fhdr.hflags & proto::hf_range) != 0;
+        if (m_range && !pipelined()) {
+          WNDX_LOG(LL::ERRO, "[FAIL] range outside of the pipelined session\n");
+          return -1;
+        }
+        m_range_off   = static_cast<off_t>(fhdr.offset);
+        m_range_total = static_cast<off_t>(fhdr.total);
+        if (add_file(fhdr.name, fhdr.size, fhdr.hflags, fhdr.hash,
+                     fhdr.src) != 0)
+        {
+          return -1;
+        }
+      }
+      break;
+    case Sstate::SIGS:
+      WNDX_LOG(LL::ERRO, "[FAIL] unexpected bytes before the Sigs: {} : {}\n",
+               len, m_peer);
+      return -1;
+    case Sstate::PAYLOAD:
+      if (on_payload(data, len) != 0) {
+        return -1;
+      }
+      break;
+    case Sstate::DONE:
+      WNDX_LOG(LL::ERRO, "[FAIL] unexpected bytes after the finish: {} : {}\n",
+               len, m_peer);
+      return -1;
+    }
+    switch (res) {
+    case Pres::OK: break;
+    case Pres::MORE: return 0; // all bytes are consumed, wait for more.
+    case Pres::BAD:
+      WNDX_LOG(LL::ERRO, "[FAIL] malformed message : {}\n", m_peer);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+[[nodiscard]] bool Fsession::take_hdr(char const*& data, size_t& len,
+                                      size_t const hdr_len)
+{
+  size_t const n{ std::min(len, hdr_len - m_hdr.size()) };
+  m_hdr.append(data, n);
+  data += n;
+  len  -= n;
+  return m_hdr.size() == hdr_len;
+}
+
+template <typename Fn>
+[[nodiscard]] proto::Pres Fsession::take_msg(char const*& data, size_t& len,
+                                             Fn&& decode)
+{
+  using proto::Pres;
+  size_t n{ 0 };
+  if (m_hdr.empty()) { // common case: whole message is in the received bytes.
+    Pres const res{ decode(data, len, n) };
+    if (res == Pres::OK) {
+      data += n;
+      len  -= n;
+    }
+    if (res != Pres::MORE) {
+      return res;
+    }
+  }
+  // message spans many recv() => accumulate & decode from the m_hdr.
+  size_t const prev{ m_hdr.size() };
+  size_t const k{ std::min(len, proto::hdr_max - prev) };
+  m_hdr.append(data, k);
+  Pres const res{ decode(m_hdr.data(), m_hdr.size(), n) };
+  switch (res) {
+  case Pres::OK: // consume only the rest of the message.
+    data += n - prev;
+    len  -= n - prev;
+    m_hdr.clear();
+    break;
+  case Pres::MORE:
+    data += k;
+    len  -= k;
+    if (m_hdr.size() == proto::hdr_max) {
+      return Pres::BAD;
+    }
+    break;
+  case Pres::BAD: break;
+  }
+  return res;
+}
+
+void Fsession::on_detect()
+{
+  u32    mg{ 0 };
+  size_t n{ 0 };
+  static_cast<void>(proto::get_u32le(m_hdr.data(), m_hdr.size(), mg, n));
+  if (mg == proto::magic) {
+    m_state = Sstate::HELLO; // keep the magic, it is a part of the Hello.
+    return;
+  }
+  // legacy peer: bytes are the beginning of the num_files_total => keep them.
+  WNDX_LOG(LL::INFO, "legacy protocol (v0) : {}\n", m_peer);
+  m_version = 0;
+  m_state   = Sstate::NUM_FILES;
+}
+
+[[nodiscard]] int Fsession::on_hello(proto::Hello const& hello)
+{
+  if (hello.version == 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] invalid protocol version 0 : {}\n", m_peer);
+    return -1;
+  }
+  // speak the older one of the two versions & only the supported features.
+  m_version = std::min(hello.version, proto::version);
+  m_flags   = hello.flags & proto::fl_supported;
+  // the Plan is the reply to all headers => not in the pipelined session.
+  if (pipelined()) {
+    m_flags &= ~proto::fl_resume;
+  } else {
+    m_flags &= ~proto::fl_publish; // ranges are pipelined.
+  }
+  // neither the source nor the content of the partial file can be verified
+  // => the content of the other source may be resumed silently.
+  if ((m_flags & (proto::fl_src | proto::fl_crc)) == 0) {
+    m_flags &= ~proto::fl_resume;
+  }
+  if (!resumable()) {
+    m_flags &= ~proto::fl_src;
+  }
+  // "have it" replies are the offsets of the Plan & the Sigs follow it.
+  if (!resumable()) {
+    m_flags &= ~(proto::fl_dedup | proto::fl_delta);
+  }
+  // codecs depend on the libraries found at build time.
+  m_flags &= ~(proto::fl_zstd | proto::fl_lz4) | codec::available();
+  // single codec per session. (zstd is preferred)
+  codec::Ctype const ctype{ codec::from_flags(m_flags) };
+  m_flags &= ~(proto::fl_zstd | proto::fl_lz4) | codec::to_flag(ctype);
+  if (ctype != codec::Ctype::NONE) {
+    m_codec = std::make_unique<codec::Codec>(ctype);
+  }
+  m_uid = hello.uid;
+  proto::Hello ack{};
+  ack.version = m_version;
+  ack.flags   = m_flags;
+  proto::encode_ack(m_out, ack);
+  WNDX_LOG(LL::INFO, "[ OK ] recv_hello() : v{} flags {:#x} uid {} : {}\n",
+           m_version, m_flags, hello.uid, m_peer);
+  // pipelined: headers are interleaved with the contents => no count upfront.
+  m_state = pipelined() ? Sstate::FINFO : Sstate::NUM_FILES;
+  return 0;
+}
+
+[[nodiscard]] int Fsession::on_finfo()
+{
+  file::Finfo finfo{};
+  std::memcpy(&finfo, m_hdr.data(), sizeof(finfo));
+  m_hdr.clear();
+  // never trust the peer: guarantee null-terminator.
+  finfo.m_fname[file::fname_max_len - 1] = '\0'; // NOLINT(*-array-index)
+  WNDX_LOG(LL::INFO, "[ OK ] recv_file_info() : {}\n", finfo);
+  // NOLINTNEXTLINE(*-array-to-pointer-decay, hicpp-no-array-decay)
+  return add_file(fs::path(finfo.m_fname), finfo.m_block_size);
+}
+
+[[nodiscard]] int Fsession::add_file(fs::path const& name, size_t const size,
+                                     u64 const hflags, u64 const hash,
+                                     u64 const src)
+{
+  // never trust the peer: forbid the dir traversal.
+  fs::path const fname{ tree() ? tree_name(name.string()) : name.filename() };
+  if (fname.empty() || fname == "." || fname == "..") {
+    WNDX_LOG(LL::ERRO, "[FAIL] invalid file name : {} : {}\n", name.string(),
+             m_peer);
+    return -1;
+  }
+  // files of the same dir usually come one after another.
+  fs::path const dir{ fname.parent_path() };
+  if (!dir.empty() && dir != m_dir_made) {
+    if (make_dirs(m_storage_dir_sub, dir) != 0) {
+      return -1;
+    }
+    m_dir_made = dir;
+  }
+  // pipelined: the previous files are finished (the Fdone is self-contained)
+  // => only the current one is kept, the Verdict needs only the indexes.
+  if (pipelined()) {
+    m_base += m_vfiles.size();
+    m_idx   = 0;
+    m_vfiles.clear();
+    m_vhflags.clear();
+    m_vhash.clear();
+  }
+  m_vfiles.emplace_back(m_storage_dir_sub / fname, size, fname);
+  m_vhflags.push_back(hflags);
+  m_vhash.push_back(hash);
+  if (resumable()) {
+    m_vsrc.push_back((hflags & proto::hf_src) != 0 ? src : 0);
+  }
+  if (pipelined()) { // content of the file follows right away.
+    m_num_files_total = m_base + m_vfiles.size();
+    m_state           = Sstate::PAYLOAD;
+    return open_next_file();
+  }
+  if (m_vfiles.size() < m_num_files_total) {
+    return 0;
+  }
+  WNDX_LOG(LL::INFO,
+           "[ OK ] received info of the upcoming transfer of the files\n");
+  if (resumable()) {
+    make_plan();
+  }
+  m_idx = 0;
+  if (want_sigs()) { // contents follow the Sigs. (see: sigs_done())
+    m_state = Sstate::SIGS;
+    return 0;
+  }
+  m_state = Sstate::PAYLOAD;
+  return open_next_file();
+}
+
+[[nodiscard]] int Fsession::open_next_file()
+{
+  for (; m_idx < m_vfiles.size(); ++m_idx) {
+    file::File const& file{ m_vfiles[m_idx] };
+    if (!m_vhave.empty() && m_vhave[m_idx] != 0) {
+      WNDX_LOG(LL::STAT, "[ OK ] dedup: up to date : {}\n", file);
+      continue;
+    }
+    WNDX_LOG(LL::INFO, "INSIDE recv_file() : {}\n", file);
+    m_crc = 0;
+    ++m_seq;
+    if ((m_range ? open_range(file) : open_file(file)) != 0) {
+      return -1;
+    }
+    // delta replaces the framing of the content.
+    m_delta  = !m_vdelta.empty() && m_vdelta[m_idx] != 0;
+    m_dhdr   = true;
+    m_zframe = !m_delta && (m_vhflags[m_idx] & proto::hf_zframe) != 0;
+    m_zhdr   = true;
+    if (m_delta) {
+      // NOLINTNEXTLINE(*-vararg)
+      m_fd_basis = open(file.path().c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat st{};
+      if (m_fd_basis == -1 || fstat(m_fd_basis, &st) == -1) {
+        log_g.errnum(errno, "[FAIL] recv_file() open() of the old copy");
+        return -1;
+      }
+      m_basis_size = static_cast<u64>(st.st_size);
+    }
+    if (m_left > 0) {
+      return 0;
+    }
+    // nothing (left) to receive => file is complete right away.
+    if (finish_file() != 0) {
+      return -1;
+    }
+  }
+  if (pipelined()) { // wait for the next header.
+    m_state = Sstate::FINFO;
+    return 0;
+  }
+  on_end();
+  return 0;
+}
+
+[[nodiscard]] int Fsession::open_file(file::File const& file)
+{
+  size_t const off{ m_vplan.empty() ? 0 : m_vplan[m_idx] };
+  int const    flags{ O_WRONLY };
+  if (resumable()) {
+    // received content is kept in the partial file between sessions.
+    m_tmp = part_path(m_idx);
+    // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+    m_fd_out = open(m_tmp.c_str(), O_CREAT | O_CLOEXEC | flags,
+                    S_IRUSR | S_IWUSR);
+    // loaded by the make_plan() => stale from now on.
+    static_cast<void>(::unlink(crc_path(m_tmp).c_str()));
+  } else {
+    m_fd_out = open_tmp(file, flags);
+  }
+  if (m_fd_out == -1) {
+    log_g.errnum(errno, "[FAIL] recv_file() open()");
+    return -1;
+  }
+  // drop the content past the planned offset. (e.g. torn tail)
+  if (resumable() && ftruncate(m_fd_out, static_cast<off_t>(off)) == -1) {
+    log_g.errnum(errno, "[FAIL] recv_file() ftruncate()");
+    return -1;
+  }
+  m_left = file.size() - off;
+  m_off  = static_cast<off_t>(off);
+  if (preallocate(m_left) != 0) {
+    return -1;
+  }
+  // checksum is of the whole content => continues from the resumed part.
+  if (crc() && m_left > 0 && off > 0) {
+    m_crc = m_vpart_crc[m_idx];
+  }
+  return 0;
+}
+
+[[nodiscard]] int Fsession::open_tmp(file::File const& file, int const flags)
+{
+  m_tmp.clear();
+#ifdef O_TMPFILE
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  int const fd{ open(file.path().parent_path().c_str(),
+                     O_TMPFILE | O_CLOEXEC | flags, S_IRUSR | S_IWUSR) };
+  // not supported by the file system (or the kernel) => the named one.
+  if (fd != -1 || (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL))
+  {
+    return fd;
+  }
+#endif // O_TMPFILE
+  m_tmp = tmp_path(file, m_seq);
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  return open(m_tmp.c_str(), O_CREAT | O_TRUNC | O_CLOEXEC | flags,
+              S_IRUSR | S_IWUSR);
+}
+
+[[nodiscard]] fs::path Fsession::tmp_path(file::File const& file,
+                                          size_t const      seq) const
+{
+  // unique per file of the live session. (sessions of all workers)
+  return file.path().parent_path() /
+         fmt::format(".mqlqd.{}.{}.{}.tmp", getpid(), m_fd_con, seq);
+}
+
+[[nodiscard]] int Fsession::preallocate(size_t const len)
+{
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+  if (len < cfg::prealloc_min) {
+    return 0;
+  }
+  // size is kept => size of the partial file is the received content.
+  if (fallocate(m_fd_out, FALLOC_FL_KEEP_SIZE, m_off,
+                static_cast<off_t>(len)) == -1)
+  {
+    if (errno == ENOSPC) {
+      log_g.errnum(errno, "[FAIL] recv_file() fallocate()");
+      return -1;
+    }
+    // not supported by the file system => not fatal.
+  }
+#else
+  static_cast<void>(len);
+#endif // __linux__ && FALLOC_FL_KEEP_SIZE
+  return 0;
+}
+
+[[nodiscard]] int Fsession::zout()
+{
+  if (m_zout.empty()) {
+    m_zout = m_pool.take(cfg::chunk_size);
+  }
+  return m_zout.empty() ? -1 : 0;
+}
+
+[[nodiscard]] int Fsession::open_range(file::File const& file)
+{
+  m_range = false;
+  // other ranges of the file may be written concurrently by the other
+  // sessions => never truncate the content, only fix the size of the file.
+  // (shared temporary file: takes the final name when all are verified)
+  m_range_tmp = file.path().parent_path() /
+                fmt::format(".mqlqd.{:016x}.range",
+                            fnv1a(fmt::format("{}\n{}", file.path().string(),
+                                              m_range_total)));
+  std::string const key{ m_range_tmp.string() };
+  bool const        ref{ std::find(m_vranged.begin(), m_vranged.end(), key) ==
+                  m_vranged.end() };
+  rfiles().acquire(key, static_cast<u64>(m_range_total), ref);
+  if (ref) {
+    m_vranged.push_back(key);
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  m_fd_out = open(m_range_tmp.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC,
+                  S_IRUSR | S_IWUSR);
+  if (m_fd_out == -1) {
+    log_g.errnum(errno, "[FAIL] open_range() open()");
+    return -1;
+  }
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+  // reserve the whole file once => ranges do not fragment it.
+  // (posix_fallocate(3) would write every block if it is not supported)
+  if (fallocate(m_fd_out, FALLOC_FL_KEEP_SIZE, 0, m_range_total) == -1 &&
+      errno == ENOSPC)
+  {
+    log_g.errnum(errno, "[FAIL] open_range() fallocate()");
+    return -1;
+  }
+#endif // __linux__ && FALLOC_FL_KEEP_SIZE
+  if (ftruncate(m_fd_out, m_range_total) == -1) {
+    log_g.errnum(errno, "[FAIL] open_range() ftruncate()");
+    return -1;
+  }
+  WNDX_LOG(LL::INFO, "recv range [{}, +{}) of {} B\n", m_range_off,
+           file.size(), m_range_total);
+  m_left = file.size();
+  m_off  = m_range_off;
+  return 0;
+}
+
+[[nodiscard]] int Fsession::finish_file()
+{
+  io::close_fd(m_fd_basis, "m_fd_basis"); // delta: old copy is replaced.
+  Fdone done{ take_file(true) };
+  if (m_deferred) { // commit later, when the writes are performed.
+    m_vdone.push_back(std::move(done));
+  } else if (commit_file(done) != 0) {
+    return -1;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] recv_file() : {}\n", m_vfiles[m_idx]);
+  return 0;
+}
+
+[[nodiscard]] Fdone Fsession::take_file(bool const keep)
+{
+  u64 const hflags{ m_vhflags[m_idx] };
+  bool const range{ (hflags & proto::hf_range) != 0 };
+  Fdone      done{ .fd     = m_fd_out,
+                   .file   = m_vfiles[m_idx],
+                   .tmp    = !keep  ? fs::path{}
+                             : range ? std::move(m_range_tmp)
+                                     : std::move(m_tmp),
+                   .hflags = hflags,
+                   .hash   = m_vhash[m_idx],
+                   .seq    = m_seq,
+                   .idx    = m_base + m_idx,
+                   .off    = range ? m_range_off : 0,
+                   .keep   = keep };
+  m_fd_out = -1;
+  m_tmp.clear();
+  m_range_tmp.clear();
+  return done;
+}
+
+int Fsession::commit_file(Fdone& done) noexcept
+{
+  file::File const& file{ done.file };
+  bool const        flush{ m_durability == Durability::FILE };
+  int               rc{ done.keep ? 0 : -1 };
+  if (rc == 0 && flush && fdatasync(done.fd) == -1) {
+    log_g.errnum(errno, "[FAIL] commit_file() fdatasync()");
+    rc = -1;
+  }
+  // other ranges of the file may be written by the other sessions
+  // => the shared one takes the final name after the last of them.
+  bool const range{ (done.hflags & proto::hf_range) != 0 };
+  if (rc == 0 && range &&
+      rfiles().add(done.tmp.string(), static_cast<u64>(done.off),
+                   file.size()))
+  {
+    if (::rename(done.tmp.c_str(), file.path().c_str()) == -1) {
+      log_g.errnum(errno, "[FAIL] commit_file() rename() of the ranges");
+      rc = -1;
+    } else {
+      m_vpub.push_back(done.idx); // confirmed to the client. (fl_publish)
+    }
+  }
+  if (rc == 0 && !range) {
+    fs::path tmp{ std::move(done.tmp) };
+    if (tmp.empty()) { // anonymous => named in the same dir first.
+      tmp = tmp_path(file, done.seq);
+      rc  = link_fd(done.fd, tmp);
+    }
+    // readers see the old content or the new one, never the partial one.
+    if (rc == 0 && ::rename(tmp.c_str(), file.path().c_str()) == -1) {
+      log_g.errnum(errno, "[FAIL] commit_file() rename()");
+      rc = -1;
+    }
+  }
+  if (rc == 0 && flush) {
+    rc = sync_dir(file.path().parent_path());
+  }
+  io::close_fd(done.fd, "m_fd_out");
+  if (rc == 0) {
+    m_committed += file.size();
+  }
+  if (rc == 0 && dedup() && (done.hflags & proto::hf_hash) != 0) {
+    index_file(file, done.hash);
+  }
+  if (rc != 0 && done.keep) {
+    WNDX_LOG(LL::ERRO, "[FAIL] commit_file() : {}\n", file);
+  }
+  return rc;
+}
+
+[[nodiscard]] fs::path Fsession::part_path(size_t const idx) const
+{
+  // keyed by the identity of the client + file name + size (+ source).
+  file::File const& file{ m_vfiles[idx] };
+  std::string       id{ fmt::format("{}\n{}\n{}", m_uid, file.name().string(),
+                                    file.size()) };
+  if (idx < m_vsrc.size() && m_vsrc[idx] != 0) {
+    id += fmt::format("\n{:016x}", m_vsrc[idx]);
+  }
+  u64 const key{ fnv1a(id) };
+  return m_storage_dir_sub / fmt::format(".mqlqd.{:016x}.part", key);
+}
+
+void Fsession::make_plan()
+{
+  m_vplan.assign(m_vfiles.size(), 0);
+  if (dedup()) {
+    m_vhave.assign(m_vfiles.size(), 0);
+    // nullptr is not fatal: everything is sent.
+    m_index = m_hcache.get(m_storage_dir_sub);
+  }
+  if (delta()) {
+    m_vdelta.assign(m_vfiles.size(), 0);
+  }
+  if (crc()) {
+    m_vpart_crc.assign(m_vfiles.size(), 0);
+  }
+  u64 received{ 0 };
+  for (size_t i = 0; i < m_vfiles.size(); ++i) {
+    m_vplan[i] = dedup_plan(i);
+    struct stat    st{};
+    fs::path const part{ part_path(i) };
+    if (m_vplan[i] == 0 && ::stat(part.c_str(), &st) == 0 &&
+        static_cast<u64>(st.st_size) <= m_vfiles[i].size())
+    {
+      m_vplan[i] = static_cast<u64>(st.st_size);
+      // the checksum of the received content is unknown => received again.
+      if (crc() && m_vplan[i] > 0 &&
+          !load_crc(part, m_vplan[i], m_vpart_crc[i]))
+      {
+        WNDX_LOG(LL::WARN, "partial file without the checksum : {}\n",
+                 m_vfiles[i]);
+        m_vplan[i] = 0;
+      }
+    }
+    // nothing is received yet => the old copy may be the basis.
+    if (delta() && m_vplan[i] == 0 && m_vfiles[i].size() > 0) {
+      m_sjob.vpaths.push_back(m_vfiles[i].path());
+      m_sjob.vfsigs.emplace_back().idx = i;
+    }
+    received += m_vplan[i];
+  }
+  proto::encode_plan(m_out, m_vplan);
+  WNDX_LOG(LL::INFO, "[ OK ] send_plan() : {} B already received : {}\n",
+           received, m_peer);
+  // the old copies are read off the event loop. (see: want_sigs())
+  if (delta() && !want_sigs()) {
+    proto::encode_sigs(m_out, {});
+  }
+}
+
+void Sjob::run()
+{
+  static constexpr size_t sig_len{ sizeof(u32) + sizeof(u64) };
+  std::vector<proto::Fsigs> vdone;
+  size_t                    len{ proto::varint_max }; // of the Sigs body.
+  for (size_t i = 0; i < vpaths.size(); ++i) {
+    fs::path const& path{ vpaths[i] };
+    // NOLINTNEXTLINE(*-vararg)
+    int         fd{ open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    struct stat st{};
+    if (fd == -1 || fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        static_cast<u64>(st.st_size) < cfg::delta_file_min)
+    {
+      io::close_fd(fd, "Sjob::run() fd");
+      continue; // not fatal: the whole content is sent.
+    }
+    auto const   size{ static_cast<u64>(st.st_size) };
+    size_t const flen{ (3 * proto::varint_max) +
+                       static_cast<size_t>(size / delta::block_size(size) *
+                                           sig_len) };
+    if (len + flen > proto::reply_max) {
+      WNDX_LOG(LL::WARN, "delta: Sigs reply is full => sent whole : {}\n",
+               path.string());
+      io::close_fd(fd, "Sjob::run() fd");
+      continue;
+    }
+    proto::Fsigs fsigs{};
+    fsigs.idx = vfsigs[i].idx;
+    int const rc{ delta::signatures(fd, size, fsigs) };
+    io::close_fd(fd, "Sjob::run() fd");
+    if (rc != 0) {
+      continue;
+    }
+    WNDX_LOG(LL::DBUG, "[ OK ] delta_sigs() : {} x {} B : {}\n",
+             fsigs.vsig.size(), fsigs.block, path.string());
+    len += flen;
+    vdone.push_back(std::move(fsigs));
+  }
+  vfsigs = std::move(vdone);
+}
+
+[[nodiscard]] Sjob Fsession::take_sigs(u64 const id)
+{
+  Sjob job{ std::move(m_sjob) };
+  m_sjob     = Sjob{};
+  m_sigs_id  = id;
+  job.fd_con = m_fd_con;
+  job.id     = id;
+  return job;
+}
+
+[[nodiscard]] int Fsession::sigs_done(Sjob& job)
+{
+  if (m_state != Sstate::SIGS || job.id != m_sigs_id) {
+    return 0; // not waited for anymore.
+  }
+  m_sigs_id = 0;
+  for (auto const& fsigs : job.vfsigs) {
+    m_vdelta[fsigs.idx] = 1;
+  }
+  proto::encode_sigs(m_out, job.vfsigs);
+  WNDX_LOG(LL::INFO, "[ OK ] send_sigs() : {} files as the delta : {}\n",
+           job.vfsigs.size(), m_peer);
+  m_idx   = 0;
+  m_state = Sstate::PAYLOAD;
+  return open_next_file();
+}
+
+[[nodiscard]] u64 Fsession::dedup_plan(size_t const idx)
+{
+  file::File const& file{ m_vfiles[idx] };
+  if (!m_index || (m_vhflags[idx] & proto::hf_hash) == 0 || file.size() == 0) {
+    return 0;
+  }
+  u64 const         hash{ m_vhash[idx] };
+  std::string const name{ file.name().string() };
+  if (m_index->has(name, file.size(), hash)) {
+    m_vhave[idx] = 1;
+    return file.size();
+  }
+  // same content under the other name => local copy instead of the transfer.
+  std::string const other{ m_index->find(file.size(), hash) };
+  if (other.empty()) {
+    return 0;
+  }
+  // NOLINTNEXTLINE(*-vararg)
+  int fd_in{ open((m_storage_dir_sub / other).c_str(), O_RDONLY | O_CLOEXEC) };
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  int fd_out{ open(part_path(idx).c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR) };
+  int rc{ fd_in == -1 || fd_out == -1 ? -1 : 0 };
+  if (rc == 0) {
+    rc = io::copy_loop(fd_in, 0, fd_out, 0, file.size());
+  }
+  io::close_fd(fd_in, "dedup_plan() fd_in");
+  io::close_fd(fd_out, "dedup_plan() fd_out");
+  if (rc != 0) {
+    WNDX_LOG(LL::WARN, "dedup: local copy failed => sent : {}\n", file);
+    return 0;
+  }
+  WNDX_LOG(LL::STAT, "[ OK ] dedup: local copy of {} : {}\n", other, file);
+  return file.size();
+}
+
+void Fsession::index_file(file::File const& file, u64 const hash)
+{
+  if (m_index && m_index->add(file.name().string(), file.size(), hash) != 0)
+  {
+    WNDX_LOG(LL::WARN, "dedup: file is not indexed : {}\n", file);
+  }
+}
+
+void Fsession::on_end()
+{
+  // deferred commits decide the Verdict => it waits for them.
+  m_end       = true;
+  m_end_files = m_num_files_total;
+  if (m_vdone.empty()) {
+    reply_end();
+  }
+  // nothing written since the last flush => nothing to wait for.
+  // (FILE: the deferred commits release the reply, see: writes_done())
+  switch (m_durability) {
+  case Durability::BATCH:
+    m_synced = m_committed == 0 && m_vdone.empty();
+    break;
+  case Durability::FILE: m_synced = m_vdone.empty(); break;
+  case Durability::NONE: m_synced = true; break;
+  }
+  if (batches()) {
+    next_batch();
+    return;
+  }
+  m_state = Sstate::DONE;
+}
+
+void Fsession::reply_end()
+{
+  m_end = false;
+  if (publish()) {
+    proto::encode_verdict(m_out, m_vbad, m_vpub);
+  } else if (crc()) {
+    proto::encode_verdict(m_out, m_vbad);
+  }
+  if (!m_vbad.empty()) {
+    WNDX_LOG(LL::WARN, "[FAIL] checksum mismatch: {}/{} files : {}\n",
+             m_vbad.size(), m_end_files, m_peer);
+  } else {
+    WNDX_LOG(LL::NTFY, "[ OK ] all files are received: {}/{} : {}\n",
+             m_end_files, m_end_files, m_peer);
+  }
+  m_vbad.clear();
+  m_vpub.clear();
+}
+
+void Fsession::next_batch()
+{
+  m_num_files_total = 0;
+  m_idx             = 0;
+  m_base            = 0;
+  m_vfiles.clear();
+  m_vplan.clear();
+  m_vhflags.clear();
+  m_vhash.clear();
+  m_vsrc.clear();
+  m_vhave.clear();
+  m_sjob    = Sjob{};
+  m_sigs_id = 0;
+  m_vdelta.clear();
+  // idle till the next transfer => the buffers are given back to the pool.
+  m_zin     = Buf{};
+  m_zin_len = 0;
+  m_zout    = Buf{};
+  m_state   = pipelined() ? Sstate::FINFO : Sstate::NUM_FILES;
+}
+
+[[nodiscard]] bool Fsession::idle() const noexcept
+{
+  if (m_state == Sstate::DONE) {
+    return true;
+  }
+  // between the transfers: nothing of the next one is received yet.
+  return batches() && m_num_files_total == 0 && m_vfiles.empty() &&
+         m_hdr.empty() &&
+         (m_state == Sstate::NUM_FILES || m_state == Sstate::FINFO);
+}
+
+[[nodiscard]] int Fsession::on_payload(char const*& data, size_t& len)
+{
+  if (m_trailer) {
+    return on_trailer(data, len);
+  }
+  if (m_delta) {
+    return on_dpayload(data, len);
+  }
+  if (m_zframe) {
+    return on_zpayload(data, len);
+  }
+  size_t const n{ std::min(len, m_left) };
+  if (write_out(data, n, true) != 0) {
+    return -1;
+  }
+  data += n;
+  len  -= n;
+  return m_left > 0 ? 0 : next_file();
+}
+
+[[nodiscard]] int Fsession::on_zpayload(char const*& data, size_t& len)
+{
+  using proto::Pres;
+  if (m_zhdr) {
+    Pres const res{ take_msg(data, len,
+                             [this](char const* p, size_t n, size_t& k) {
+                               return proto::decode(p, n, m_zblk, k);
+                             }) };
+    if (res == Pres::MORE) {
+      return 0;
+    }
+    if (res == Pres::BAD || m_zblk.raw == 0 || m_zblk.raw > cfg::chunk_size ||
+        m_zblk.raw > m_left || m_zblk.clen > m_codec->bound(m_zblk.raw))
+    {
+      WNDX_LOG(LL::ERRO, "[FAIL] malformed compressed block : {}\n",
+               m_vfiles[m_idx]);
+      return -1;
+    }
+    m_zhdr = false;
+    return 0;
+  }
+  if (m_zblk.clen == 0) { // incompressible block => raw bytes.
+    size_t const n{ std::min(len, static_cast<size_t>(m_zblk.raw)) };
+    if (write_out(data, n, true) != 0) {
+      return -1;
+    }
+    data       += n;
+    len        -= n;
+    m_zblk.raw -= n;
+  } else {
+    auto const  clen{ static_cast<size_t>(m_zblk.clen) };
+    char const* src{ data };
+    if (m_zin_len > 0 || len < clen) { // block spans many recv().
+      if (m_zin.empty()) {
+        m_zin = m_pool.take(m_codec->bound(cfg::chunk_size));
+        if (m_zin.empty()) {
+          return -1;
+        }
+      }
+      size_t const n{ std::min(len, clen - m_zin_len) };
+      std::memcpy(m_zin.data() + m_zin_len, data, n);
+      m_zin_len += n;
+      data      += n;
+      len       -= n;
+      if (m_zin_len < clen) {
+        return 0;
+      }
+      src = m_zin.data();
+    } else {
+      data += clen;
+      len  -= clen;
+    }
+    auto const raw{ static_cast<size_t>(m_zblk.raw) };
+    if (zout() != 0) {
+      return -1;
+    }
+    if (m_codec->decompress(src, clen, m_zout.data(), raw) != 0) {
+      WNDX_LOG(LL::ERRO, "[FAIL] decompress : {}\n", m_vfiles[m_idx]);
+      return -1;
+    }
+    m_zin_len  = 0;
+    m_zblk.raw = 0;
+    // m_zout is reused by the next block => never deferred.
+    if (write_out(m_zout.data(), raw, false) != 0) {
+      return -1;
+    }
+  }
+  if (m_zblk.raw > 0) {
+    return 0;
+  }
+  m_zhdr = true;
+  return m_left > 0 ? 0 : next_file();
+}
+
+[[nodiscard]] int Fsession::on_dpayload(char const*& data, size_t& len)
+{
+  using proto::Pres;
+  if (m_dhdr) {
+    Pres const res{ take_msg(data, len,
+                             [this](char const* p, size_t n, size_t& k) {
+                               return proto::decode(p, n, m_dop, k);
+                             }) };
+    if (res == Pres::MORE) {
+      return 0;
+    }
+    bool const copy{ m_dop.kind == proto::Dkind::COPY };
+    if (res == Pres::BAD || m_dop.len == 0 || m_dop.len > m_left ||
+        (copy && (m_dop.off > m_basis_size ||
+                  m_dop.len > m_basis_size - m_dop.off)))
+    {
+      WNDX_LOG(LL::ERRO, "[FAIL] malformed delta : {}\n", m_vfiles[m_idx]);
+      return -1;
+    }
+    if (!copy) {
+      m_dhdr = false;
+      return 0;
+    }
+    // block(s) of the old copy => copied locally. (never deferred)
+    if (copy_basis(static_cast<off_t>(m_dop.off),
+                   static_cast<size_t>(m_dop.len)) != 0)
+    {
+      WNDX_LOG(LL::ERRO, "[FAIL] delta copy : {}\n", m_vfiles[m_idx]);
+      return -1;
+    }
+    return m_left > 0 ? 0 : next_file();
+  }
+  size_t const n{ std::min(len, static_cast<size_t>(m_dop.len)) };
+  if (write_out(data, n, true) != 0) {
+    return -1;
+  }
+  data      += n;
+  len       -= n;
+  m_dop.len -= n;
+  if (m_dop.len > 0) {
+    return 0;
+  }
+  m_dhdr = true;
+  return m_left > 0 ? 0 : next_file();
+}
+
+[[nodiscard]] int Fsession::copy_basis(off_t off, size_t const n)
+{
+  if (!crc()) {
+    if (io::copy_loop(m_fd_basis, off, m_fd_out, m_off, n) != 0) {
+      return -1;
+    }
+    m_left -= n;
+    m_off  += static_cast<off_t>(n);
+    return 0;
+  }
+  // checksum is of the reconstructed content => copied through the buffer.
+  if (zout() != 0) {
+    return -1;
+  }
+  for (size_t left = n; left > 0;) {
+    size_t const k{ std::min(left, m_zout.size()) };
+    if (io::pread_loop(m_fd_basis, m_zout.data(), k, off) != 0 ||
+        write_out(m_zout.data(), k, false) != 0)
+    {
+      return -1;
+    }
+    off  += static_cast<off_t>(k);
+    left -= k;
+  }
+  return 0;
+}
+
+[[nodiscard]] int Fsession::write_out(char const* data, size_t const n,
+                                      bool const stable)
+{
+  if (crc()) { // while the received bytes are hot in the cache.
+    m_crc = crc32c(m_crc, data, n);
+  }
+  if (m_deferred && stable) {
+    m_vwops.push_back({ m_fd_out, data, n, m_off });
+  } else if (io::pwrite_loop(m_fd_out, data, n, m_off) != 0) {
+    WNDX_LOG(LL::ERRO, "[FAIL] recv_file() write : {}\n", m_vfiles[m_idx]);
+    return -1;
+  }
+  m_left -= n;
+  m_off  += static_cast<off_t>(n);
+  return 0;
+}
+
+[[nodiscard]] int Fsession::next_file()
+{
+  // content is complete => its checksum follows.
+  if (crc() && !m_trailer) {
+    m_trailer = true;
+    return 0;
+  }
+  m_trailer = false;
+  if (finish_file() != 0) {
+    return -1;
+  }
+  ++m_idx;
+  return open_next_file();
+}
+
+[[nodiscard]] int Fsession::on_trailer(char const*& data, size_t& len)
+{
+  if (!take_hdr(data, len, sizeof(u32))) {
+    return 0;
+  }
+  u32    sum{ 0 };
+  size_t n{ 0 };
+  static_cast<void>(proto::get_u32le(m_hdr.data(), m_hdr.size(), sum, n));
+  m_hdr.clear();
+  if (sum == m_crc) {
+    WNDX_LOG(LL::DBUG, "[ OK ] crc32c {:08x} : {}\n", sum, m_vfiles[m_idx]);
+    return next_file();
+  }
+  WNDX_LOG(LL::ERRO, "[FAIL] crc32c {:08x} != {:08x} (sent) : {} : {}\n",
+           m_crc, sum, m_vfiles[m_idx], m_peer);
+  discard_file();
+  m_trailer = false;
+  ++m_idx;
+  return open_next_file();
+}
+
+void Fsession::discard_file()
+{
+  m_vbad.push_back(m_base + m_idx);
+  io::close_fd(m_fd_basis, "m_fd_basis");
+  // the named (temporary or partial) file is removed, the anonymous one is
+  // gone with its fd & the shared one of the range is kept. (other ranges)
+  if (!m_tmp.empty() && ::unlink(m_tmp.c_str()) == -1) {
+    log_g.errnum(errno, "[FAIL] discard_file() unlink()");
+  }
+  Fdone done{ take_file(false) };
+  if (m_deferred) { // writes in flight => closed after them.
+    m_vdone.push_back(std::move(done));
+  } else {
+    static_cast<void>(commit_file(done)); // only closed.
+  }
+}
+
+int Fsession::writes_done() noexcept
+{
+  m_vwops.clear();
+  int rc{ 0 };
+  for (auto& done : m_vdone) {
+    // discarded ones (not kept) are only closed & already reported.
+    if (commit_file(done) != 0 && done.keep) {
+      rc = -1;
+    }
+  }
+  m_vdone.clear();
+  if (m_end) {
+    reply_end();
+  }
+  // each file is flushed by its commit => the final reply is released.
+  if (rc == 0 && m_durability == Durability::FILE) {
+    m_synced = true;
+  }
+  return rc;
+}
+
+void Fsession::writes_failed() noexcept
+{
+  for (auto& done : m_vdone) {
+    if (!done.keep) {
+      continue; // discarded => already reported.
+    }
+    done.keep = false;
+    m_vbad.push_back(done.idx);
+    // the shared file of the range is kept. (other ranges, see: discard_file)
+    if ((done.hflags & proto::hf_range) == 0 && !done.tmp.empty() &&
+        ::unlink(done.tmp.c_str()) == -1)
+    {
+      log_g.errnum(errno, "[FAIL] writes_failed() unlink()");
+    }
+  }
+}
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,236 @@
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/hindex.hpp"
+
+#include "wndx/mqlqd/io.hpp"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdio> // rename(3)
+#include <fstream>
+#include <iterator>
+
+extern "C" {
+
+#include <fcntl.h>    // open(2)
+#include <sys/stat.h> // stat(2)
+#include <unistd.h>   // getpid(2)
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// \brief log line: "hash(hex) size mtime name\n".
+[[nodiscard]] std::string to_line(std::string const& name, Hentry const& e)
+{
+  return fmt::format("{:016x} {} {} {}\n", e.hash, e.size, e.mtime, name);
+}
+
+/// \return false on the malformed line. (e.g. torn by the crash)
+[[nodiscard]] bool from_line(std::string const& line, std::string& name,
+                             Hentry& e)
+{
+  char const*       p{ line.data() };
+  char const* const end{ line.data() + line.size() };
+  // number followed by the space.
+  auto const field{ [&p, end](u64& v, int const base) {
+    auto const [ptr, ec]{ std::from_chars(p, end, v, base) };
+    if (ec != std::errc{} || ptr == end || *ptr != ' ') {
+      return false;
+    }
+    p = ptr + 1; // NOLINT(*-pointer-arithmetic)
+    return true;
+  } };
+  if (!field(e.hash, 16) || !field(e.size, 10) || !field(e.mtime, 10)) {
+    return false;
+  }
+  name.assign(p, end);
+  return !name.empty();
+}
+
+/// \return modification time of the file in ns, 0 if it does not exist.
+[[nodiscard]] u64 mtime_of(fs::path const& path, u64& size) noexcept
+{
+  struct stat st{};
+  if (::stat(path.c_str(), &st) == -1 || !S_ISREG(st.st_mode)) {
+    return 0;
+  }
+  size = static_cast<u64>(st.st_size);
+  return static_cast<u64>(st.st_mtim.tv_sec) * 1'000'000'000ULL +
+         static_cast<u64>(st.st_mtim.tv_nsec);
+}
+
+} // namespace
+
+Hindex::Hindex(fs::path dir) noexcept
+    : m_dir{ std::move(dir) }
+    , m_path{ m_dir / log_name }
+{
+}
+
+[[nodiscard]] int Hindex::load()
+{
+  struct stat st{};
+  if (::stat(m_path.c_str(), &st) == -1) {
+    return 0; // nothing is indexed yet.
+  }
+  if (static_cast<u64>(st.st_ino) != m_ino ||
+      static_cast<u64>(st.st_size) < m_loaded)
+  {
+    m_map.clear(); // rewritten => read from the beginning.
+    m_by_hash.clear();
+    m_lines  = 0;
+    m_loaded = 0;
+    m_ino    = static_cast<u64>(st.st_ino);
+  }
+  if (static_cast<u64>(st.st_size) == m_loaded) {
+    return 0;
+  }
+  std::ifstream ifs{ m_path };
+  if (!ifs.seekg(static_cast<std::streamoff>(m_loaded))) {
+    return 0;
+  }
+  std::string const tail{ std::istreambuf_iterator<char>{ ifs }, {} };
+  std::string       line;
+  std::string       name;
+  Hentry            e{};
+  // only the complete lines: the entry may be appended right now.
+  for (size_t pos{ 0 }, eol{ 0 };
+       (eol = tail.find('\n', pos)) != std::string::npos; pos = eol + 1)
+  {
+    m_loaded += eol + 1 - pos;
+    ++m_lines;
+    line.assign(tail, pos, eol - pos);
+    if (!from_line(line, name, e)) {
+      continue;
+    }
+    m_map[name]       = e;
+    m_by_hash[e.hash] = name;
+  }
+  WNDX_LOG(LL::DBUG, "[ OK ] Hindex::load() : {} entries : {}\n", m_map.size(),
+           m_path);
+  // NOLINTNEXTLINE(*-magic-numbers)
+  if (m_lines > 64 && m_lines > 2 * m_map.size()) {
+    return compact();
+  }
+  return 0;
+}
+
+[[nodiscard]] bool Hindex::fresh(std::string const& name,
+                                 Hentry const&      e) const
+{
+  u64 size{ 0 };
+  u64 const mtime{ mtime_of(m_dir / name, size) };
+  return mtime != 0 && mtime == e.mtime && size == e.size;
+}
+
+[[nodiscard]] bool Hindex::has(std::string const& name, u64 const size,
+                               u64 const hash) const
+{
+  auto const it{ m_map.find(name) };
+  return it != m_map.end() && it->second.hash == hash &&
+         it->second.size == size && fresh(name, it->second);
+}
+
+[[nodiscard]] std::string Hindex::find(u64 const size, u64 const hash) const
+{
+  auto const it{ m_by_hash.find(hash) };
+  if (it == m_by_hash.end() || !has(it->second, size, hash)) {
+    return {};
+  }
+  return it->second;
+}
+
+[[nodiscard]] int Hindex::add(std::string const& name, u64 const size,
+                              u64 const hash)
+{
+  // the line-oriented log can not hold such names => not indexed.
+  if (name.find('\n') != std::string::npos) {
+    return 0;
+  }
+  Hentry e{ .hash = hash, .size = size, .mtime = 0 };
+  u64    st_size{ 0 };
+  e.mtime = mtime_of(m_dir / name, st_size);
+  if (e.mtime == 0 || st_size != size) {
+    WNDX_LOG(LL::WARN, "Hindex::add() stored file mismatch : {}\n", name);
+    return 0;
+  }
+  std::string const line{ to_line(name, e) };
+  // NOLINTNEXTLINE(*-vararg, hicpp-signed-bitwise)
+  int fd{ open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+               S_IRUSR | S_IWUSR) };
+  if (fd == -1) {
+    log_g.errnum(errno, "[FAIL] Hindex::add() open()");
+    return -1;
+  }
+  int const rc{ io::write_loop(fd, line.data(), line.size()) };
+  // the entry is the next one of the log => not read again by the load().
+  struct stat st{};
+  if (rc == 0 && fstat(fd, &st) == 0 &&
+      static_cast<u64>(st.st_ino) == m_ino &&
+      static_cast<u64>(st.st_size) == m_loaded + line.size())
+  {
+    m_loaded += line.size();
+  }
+  io::close_fd(fd, "Hindex::add() fd");
+  if (rc != 0) {
+    return -1;
+  }
+  m_map[name]     = e;
+  m_by_hash[hash] = name;
+  ++m_lines;
+  return 0;
+}
+
+[[nodiscard]] int Hindex::compact()
+{
+  // entries appended by the other sessions meanwhile may be lost
+  // => only the dedup opportunity is lost, the index is a cache.
+  // unique name: sessions of the dir on the other workers may compact too.
+  static std::atomic<u64> seq{ 0 };
+  fs::path const          tmp{ m_dir / fmt::format("{}.{}.{}.tmp", log_name,
+                                                    getpid(), seq++) };
+  {
+    std::ofstream ofs{ tmp, std::ios::trunc };
+    for (auto const& [name, e] : m_map) {
+      ofs << to_line(name, e);
+    }
+    if (!ofs.flush()) {
+      WNDX_LOG(LL::ERRO, "[FAIL] Hindex::compact() write : {}\n", tmp);
+      static_cast<void>(::unlink(tmp.c_str()));
+      return -1;
+    }
+  }
+  struct stat st{};
+  if (::stat(tmp.c_str(), &st) == -1 ||
+      ::rename(tmp.c_str(), m_path.c_str()) == -1)
+  {
+    log_g.errnum(errno, "[FAIL] Hindex::compact() rename()");
+    static_cast<void>(::unlink(tmp.c_str()));
+    return -1;
+  }
+  m_loaded = static_cast<u64>(st.st_size);
+  m_ino    = static_cast<u64>(st.st_ino);
+  WNDX_LOG(LL::INFO, "[ OK ] Hindex::compact() : {} -> {} entries\n", m_lines,
+           m_map.size());
+  m_lines = m_map.size();
+  return 0;
+}
+
+[[nodiscard]] Hindex* Hcache::get(fs::path const& dir)
+{
+  auto& index{ m_indexes[dir.string()] };
+  if (!index) {
+    index = std::make_unique<Hindex>(dir);
+  }
+  // kept on error: the other sessions may still use it.
+  return index->load() == 0 ? index.get() : nullptr;
+}
+
+} // namespace wndx::mqlqd
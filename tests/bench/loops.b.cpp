@@ -0,0 +1,355 @@
+/// send/recv loops in isolation: socketpairs, pipes & the loopback TCP.
+/// Sweeps the chunk size, SO_SNDBUF/SO_RCVBUF (pipe: F_SETPIPE_SZ), the
+/// coalescing of the header & content (MSG_MORE/TCP_CORK) & the log level.
+/// Report: bench_loops --benchmark_out=loops.csv --benchmark_out_format=csv
+
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/io.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+extern "C" {
+
+#include <arpa/inet.h>   // htonl()
+#include <fcntl.h>       // pipe2(2), F_SETPIPE_SZ
+#include <netinet/in.h>  // Internet domain sockets | sockaddr(3type)
+#include <netinet/tcp.h> // TCP_CORK | tcp(7)
+#include <sys/socket.h>  // socketpair(2), setsockopt(2)
+#include <unistd.h>      // read(2)
+
+} // extern "C"
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// bytes sent per iteration. (by the chunks of the size)
+constexpr size_t total{ 64 * 1024 * 1024 };
+
+/// size of the header sent before each content. (Fhdr alike)
+constexpr size_t hdr_size{ 16 };
+
+/// \brief connected pair of the fds: sending & receiving ends.
+struct Fdpair
+{
+  Fdpair(Fdpair&&)                 = delete;
+  Fdpair(Fdpair const&)            = delete;
+  Fdpair& operator=(Fdpair&&)      = delete;
+  Fdpair& operator=(Fdpair const&) = delete;
+  Fdpair()                         = default;
+
+  ~Fdpair() noexcept
+  {
+    io::close_fd(tx, "tx");
+    io::close_fd(rx, "rx");
+  }
+
+  [[nodiscard]] bool ok() const noexcept { return tx != -1 && rx != -1; }
+
+  int tx{ -1 };
+  int rx{ -1 };
+};
+
+/// \brief set the kernel buffers of the socket. (0 - default)
+void set_bufs(int const fd, int const bufsize) noexcept
+{
+  if (bufsize > 0) {
+    static_cast<void>(
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize)));
+    static_cast<void>(
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize)));
+  }
+}
+
+void unix_pair(Fdpair& fds, int const bufsize) noexcept
+{
+  std::array<int, 2> sv{ -1, -1 };
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv.data()) == -1) {
+    log_g.errnum(errno, "[FAIL] socketpair()");
+    return;
+  }
+  fds.tx = sv[0];
+  fds.rx = sv[1];
+  set_bufs(fds.tx, bufsize);
+  set_bufs(fds.rx, bufsize);
+}
+
+void pipe_pair(Fdpair& fds, int const bufsize) noexcept
+{
+  std::array<int, 2> pv{ -1, -1 };
+  if (pipe2(pv.data(), O_CLOEXEC) == -1) {
+    log_g.errnum(errno, "[FAIL] pipe2()");
+    return;
+  }
+  fds.rx = pv[0];
+  fds.tx = pv[1];
+  if (bufsize > 0) { // NOLINTNEXTLINE(*-vararg)
+    static_cast<void>(fcntl(fds.tx, F_SETPIPE_SZ, bufsize));
+  }
+}
+
+/// \brief connected TCP sockets over the loopback. (ephemeral port)
+void tcp_pair(Fdpair& fds, int const bufsize) noexcept
+{
+  struct sockaddr_in sa{};
+  sa.sin_family      = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t salen{ sizeof(sa) };
+  int       fd_lsn{ socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0) };
+  fds.tx = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  set_bufs(fd_lsn, bufsize); // inherited by the accepted socket.
+  set_bufs(fds.tx, bufsize);
+  // casts are the necessity! ref: bind(2), accept(2)
+  // NOLINTBEGIN(*-reinterpret-cast)
+  auto* const addr{ reinterpret_cast<struct sockaddr*>(&sa) };
+  if (fd_lsn == -1 || fds.tx == -1 || bind(fd_lsn, addr, salen) == -1 ||
+      listen(fd_lsn, 1) == -1 || getsockname(fd_lsn, addr, &salen) == -1 ||
+      connect(fds.tx, addr, salen) == -1)
+  {
+    log_g.errnum(errno, "[FAIL] tcp_pair()");
+  } else {
+    fds.rx = accept4(fd_lsn, nullptr, nullptr, SOCK_CLOEXEC);
+  }
+  // NOLINTEND(*-reinterpret-cast)
+  io::close_fd(fd_lsn, "fd_lsn");
+}
+
+/// \brief read exactly len bytes. (pipe: recv(2) is for the sockets only)
+[[nodiscard]] int read_loop(int const fd, char* buf, size_t len) noexcept
+{
+  while (len > 0) {
+    ssize_t const nbytes{ read(fd, buf, len) };
+    if (nbytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (nbytes <= 0) {
+      return -1;
+    }
+    buf += nbytes;
+    len -= static_cast<size_t>(nbytes);
+  }
+  return 0;
+}
+
+/// \brief how the header & the content are given to the kernel.
+enum class Coalesce : u8
+{
+  NONE, // two send() calls. (Nagle may delay the content)
+  MORE, // header with MSG_MORE.
+  CORK, // both under TCP_CORK.
+};
+
+/// \brief total bytes per iteration: send_loop() by the chunks, while the
+/// receiver recv_loop() them by the chunks. (args: chunk, SO_*BUF)
+void bm_unix(benchmark::State& state)
+{
+  auto const chunk{ static_cast<size_t>(state.range(0)) };
+  Fdpair     fds;
+  unix_pair(fds, static_cast<int>(state.range(1)));
+  if (!fds.ok()) {
+    state.SkipWithError("socketpair");
+    return;
+  }
+  std::vector<char> sbuf(chunk, 'x');
+  std::vector<char> rbuf(chunk);
+  for (auto _ : state) {
+    std::jthread const rx{ [&] {
+      for (size_t n = 0; n < total; n += chunk) {
+        if (io::recv_loop(fds.rx, rbuf.data(), chunk) != 0) {
+          break;
+        }
+      }
+    } };
+    for (size_t n = 0; n < total; n += chunk) {
+      if (io::send_loop(fds.tx, sbuf.data(), chunk) != 0) {
+        state.SkipWithError("send_loop");
+        shutdown(fds.tx, SHUT_WR); // the receiver stops.
+        break;
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(total));
+}
+
+/// \brief as the bm_unix, but the pipe: write_loop() & read(2).
+/// (args: chunk, F_SETPIPE_SZ)
+void bm_pipe(benchmark::State& state)
+{
+  auto const chunk{ static_cast<size_t>(state.range(0)) };
+  Fdpair     fds;
+  pipe_pair(fds, static_cast<int>(state.range(1)));
+  if (!fds.ok()) {
+    state.SkipWithError("pipe");
+    return;
+  }
+  std::vector<char> sbuf(chunk, 'x');
+  std::vector<char> rbuf(chunk);
+  for (auto _ : state) {
+    std::jthread const rx{ [&] {
+      for (size_t n = 0; n < total; n += chunk) {
+        if (read_loop(fds.rx, rbuf.data(), chunk) != 0) {
+          break;
+        }
+      }
+    } };
+    for (size_t n = 0; n < total; n += chunk) {
+      if (io::write_loop(fds.tx, sbuf.data(), chunk) != 0) {
+        state.SkipWithError("write_loop");
+        io::close_fd(fds.tx, "tx"); // the receiver stops.
+        break;
+      }
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(total));
+}
+
+/// \brief header & content of the chunk size per message over the loopback
+/// TCP, as the client sends the files. (args: chunk, SO_*BUF)
+void bm_tcp(benchmark::State& state, Coalesce const coalesce)
+{
+  auto const chunk{ static_cast<size_t>(state.range(0)) };
+  Fdpair     fds;
+  tcp_pair(fds, static_cast<int>(state.range(1)));
+  if (!fds.ok()) {
+    state.SkipWithError("tcp_pair");
+    return;
+  }
+  int const         more{ coalesce == Coalesce::MORE ? MSG_MORE : 0 };
+  size_t const      nmsg{ std::max<size_t>(total / (hdr_size + chunk), 1) };
+  std::vector<char> hdr(hdr_size, 'h');
+  std::vector<char> sbuf(chunk, 'x');
+  std::vector<char> rbuf(hdr_size + chunk);
+  for (auto _ : state) {
+    std::jthread const rx{ [&] {
+      for (size_t n = 0; n < nmsg; ++n) {
+        if (io::recv_loop(fds.rx, rbuf.data(), rbuf.size()) != 0) {
+          break;
+        }
+      }
+    } };
+    for (size_t n = 0; n < nmsg; ++n) {
+      int cork{ 1 };
+      if (coalesce == Coalesce::CORK) {
+        static_cast<void>(
+            setsockopt(fds.tx, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork)));
+      }
+      if (io::send_loop(fds.tx, hdr.data(), hdr.size(), more) != 0 ||
+          io::send_loop(fds.tx, sbuf.data(), chunk) != 0)
+      {
+        state.SkipWithError("send_loop");
+        shutdown(fds.tx, SHUT_WR); // the receiver stops.
+        break;
+      }
+      if (coalesce == Coalesce::CORK) {
+        cork = 0;
+        static_cast<void>(
+            setsockopt(fds.tx, IPPROTO_TCP, TCP_CORK, &cork, sizeof(cork)));
+      }
+    }
+  }
+  auto const nbytes{ static_cast<int64_t>(nmsg * (hdr_size + chunk)) };
+  state.SetBytesProcessed(state.iterations() * nbytes);
+  state.counters["msgs/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations()) * static_cast<double>(nmsg),
+      benchmark::Counter::kIsRate);
+}
+
+/// \brief bm_unix at the log urgency level: the per-iteration DBUG messages
+/// are formatted & written only at LL::DBUG. (run with 2>/dev/null)
+/// (args: chunk, SO_*BUF, level)
+void bm_unix_log(benchmark::State& state)
+{
+  LL const urgency{ static_cast<int>(state.range(2)) };
+  log_g.set_urgency(urgency);
+  bm_unix(state);
+  log_g.set_urgency(LL::ERRO);
+}
+
+void chunks_bufs(benchmark::internal::Benchmark* bm)
+{
+  bm->ArgNames({ "chunk", "buf" });
+  for (int64_t const buf : { 0, 256 * 1024, 4 * 1024 * 1024 }) {
+    for (int64_t chunk = 4096; chunk <= 1024 * 1024; chunk *= 4) {
+      bm->Args({ chunk, buf });
+    }
+  }
+}
+
+void pipe_sizes(benchmark::internal::Benchmark* bm)
+{
+  bm->ArgNames({ "chunk", "pipe" });
+  for (int64_t const size : { 0, 1024 * 1024 }) {
+    for (int64_t chunk = 4096; chunk <= 1024 * 1024; chunk *= 4) {
+      bm->Args({ chunk, size });
+    }
+  }
+}
+
+void messages(benchmark::internal::Benchmark* bm)
+{
+  bm->ArgNames({ "chunk", "buf" });
+  for (int64_t const buf : { 0, 4 * 1024 * 1024 }) {
+    for (int64_t const chunk : { 256, 4096, 65536 }) {
+      bm->Args({ chunk, buf });
+    }
+  }
+}
+
+void levels(benchmark::internal::Benchmark* bm)
+{
+  bm->ArgNames({ "chunk", "buf", "level" });
+  for (LL const urgency : { LL::DBUG, LL::ERRO }) {
+    bm->Args({ 4096, 64 * 1024, static_cast<int64_t>(urgency) });
+  }
+}
+
+// NOLINTBEGIN(*-avoid-non-const-global-variables, cert-err58-cpp)
+BENCHMARK(bm_unix)
+    ->Apply(chunks_bufs)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_pipe)
+    ->Apply(pipe_sizes)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_tcp, none, Coalesce::NONE)
+    ->Apply(messages)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_tcp, more, Coalesce::MORE)
+    ->Apply(messages)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_tcp, cork, Coalesce::CORK)
+    ->Apply(messages)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_unix_log)
+    ->Apply(levels)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// NOLINTEND(*-avoid-non-const-global-variables, cert-err58-cpp)
+
+} // namespace
+
+} // namespace wndx::mqlqd
+
+int main(int argc, char** argv)
+{
+  wndx::sane::log_g.set_urgency(wndx::sane::LL::ERRO);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
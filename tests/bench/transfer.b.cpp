@@ -0,0 +1,169 @@
+/// transfer throughput: in-process file server & client over the loopback.
+/// Run: bench_transfer [--benchmark_filter=...] (storage under the temp dir)
+
+#include "wndx/mqlqd/aliases.hpp"
+
+#include "wndx/mqlqd/fclient.hpp"
+#include "wndx/mqlqd/file.hpp"
+#include "wndx/mqlqd/fserver.hpp"
+#include "wndx/mqlqd/proto.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+constexpr port_t bench_port{ 42169 };
+
+[[nodiscard]] fs::path bench_dir()
+{
+  return fs::temp_directory_path() / "mqlqd_bench";
+}
+
+/// \brief file server run by its own thread, till the end of the process.
+class Bserver final
+{
+public:
+  Bserver(Bserver&&)                 = delete;
+  Bserver(Bserver const&)            = delete;
+  Bserver& operator=(Bserver&&)      = delete;
+  Bserver& operator=(Bserver const&) = delete;
+
+  ~Bserver() noexcept
+  {
+    if (m_thread.joinable()) {
+      m_fserver.stop();
+      m_thread.join();
+    }
+    std::error_code ec{};
+    fs::remove_all(m_dir, ec);
+  }
+
+  Bserver()
+      : m_dir{ bench_dir() / "store" }
+      , m_fserver{ bench_port, m_dir }
+  {
+    fs::create_directories(m_dir);
+    if (m_fserver.init() == rc::SUCCESS) {
+      m_thread = std::thread{ [this] { static_cast<void>(m_fserver.run()); } };
+    }
+  }
+
+  [[nodiscard]] bool running() const noexcept { return m_thread.joinable(); }
+
+private:
+  fs::path    m_dir;
+  Fserver     m_fserver;
+  std::thread m_thread;
+};
+
+[[nodiscard]] Bserver& server()
+{
+  static Bserver bserver;
+  return bserver;
+}
+
+/// \brief count source files of the size bytes. (created once, kept)
+[[nodiscard]] std::vector<file::File> source(size_t const size,
+                                             size_t const count,
+                                             Tmode const  tmode)
+{
+  fs::path const dir{ bench_dir() /
+                      ("src_" + std::to_string(size) + "x" +
+                       std::to_string(count)) };
+  fs::create_directories(dir);
+  std::vector<char> content(size);
+  for (size_t i = 0; i < size; ++i) { // not compressible by the page cache.
+    content[i] = static_cast<char>((i * 2654435761U) >> 13U);
+  }
+  std::vector<file::File> vfiles;
+  vfiles.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    fs::path const  fp{ dir / ("f" + std::to_string(i)) };
+    std::error_code ec{};
+    if (fs::file_size(fp, ec) != size || ec) {
+      std::ofstream{ fp, std::ios::binary }.write(
+          content.data(), static_cast<std::streamsize>(size));
+    }
+    file::File& file{ vfiles.emplace_back(fp, size) };
+    if (tmode == Tmode::BUFFERED) {
+      static_cast<void>(file.map());
+    }
+  }
+  return vfiles;
+}
+
+/// \brief one session per iteration: connect, send all files & wait for the
+/// Verdict of the server. (i.e. the files are written by the server)
+void bm_transfer(benchmark::State& state, Tmode const tmode)
+{
+  auto const size{ static_cast<size_t>(state.range(0)) };
+  auto const count{ static_cast<size_t>(state.range(1)) };
+  if (!server().running()) {
+    state.SkipWithError("server is not initialized");
+    return;
+  }
+  std::vector<file::File> const vfiles{ source(size, count, tmode) };
+  for (auto _ : state) {
+    Fclient fclient{ "127.0.0.1", bench_port, tmode };
+    if (fclient.init(proto::fl_pipeline | proto::fl_crc) != rc::SUCCESS ||
+        fclient.send_files(vfiles) != rc::SUCCESS)
+    {
+      state.SkipWithError("transfer failed");
+      break;
+    }
+  }
+  auto const nfiles{ static_cast<int64_t>(state.iterations()) *
+                     static_cast<int64_t>(count) };
+  state.SetBytesProcessed(nfiles * static_cast<int64_t>(size));
+  state.counters["files/s"] = benchmark::Counter(
+      static_cast<double>(nfiles), benchmark::Counter::kIsRate);
+}
+
+/// \brief distributions of the file sizes: many small, many medium, one large.
+/// (scaled down from 1 KiB x 100k, 1 MiB x 1k & 4 GiB x 1 to fit the temp dir)
+void distributions(benchmark::internal::Benchmark* bm)
+{
+  bm->ArgNames({ "size", "files" });
+  bm->Args({ 1024, 10'000 });
+  bm->Args({ 1024 * 1024, 256 });
+  bm->Args({ 256 * 1024 * 1024, 1 });
+}
+
+// NOLINTBEGIN(*-avoid-non-const-global-variables, cert-err58-cpp)
+BENCHMARK_CAPTURE(bm_transfer, buffered, Tmode::BUFFERED)
+    ->Apply(distributions)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_transfer, chunked, Tmode::CHUNKED)
+    ->Apply(distributions)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(bm_transfer, sendfile, Tmode::SENDFILE)
+    ->Apply(distributions)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// NOLINTEND(*-avoid-non-const-global-variables, cert-err58-cpp)
+
+} // namespace
+
+} // namespace wndx::mqlqd
+
+int main(int argc, char** argv)
+{
+  wndx::sane::log_g.set_urgency(wndx::sane::LL::ERRO);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
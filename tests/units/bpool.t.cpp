@@ -0,0 +1,82 @@
+#include "wndx/mqlqd/bpool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring> // memset
+#include <utility>
+
+
+namespace wndx::mqlqd {
+
+TEST(bpool, size_classes)
+{
+  ASSERT_EQ(Bpool::class_size(0), 4096U);
+  ASSERT_EQ(Bpool::class_size(1), 4096U);
+  ASSERT_EQ(Bpool::class_size(4096), 4096U);
+  ASSERT_EQ(Bpool::class_size(4097), 8192U);
+  ASSERT_EQ(Bpool::class_size(cfg::chunk_size), cfg::chunk_size);
+  ASSERT_EQ(Bpool::class_size(cfg::chunk_size + 1), 2 * cfg::chunk_size);
+}
+
+TEST(bpool, buffers_are_recycled)
+{
+  Bpool pool;
+  char* data{ nullptr };
+  {
+    Buf const buf{ pool.take(cfg::chunk_size) };
+    ASSERT_FALSE(buf.empty());
+    ASSERT_EQ(buf.size(), cfg::chunk_size);
+    std::memset(buf.data(), 0x5A, buf.size()); // writable.
+    data = buf.data();
+  }
+  Buf const again{ pool.take(cfg::chunk_size - 100) }; // the same class.
+  ASSERT_EQ(again.data(), data);
+  ASSERT_EQ(pool.hits(), 1U);
+  ASSERT_EQ(pool.misses(), 1U);
+  Buf const other{ pool.take(1) }; // another class => newly mapped.
+  ASSERT_NE(other.data(), data);
+  ASSERT_EQ(pool.misses(), 2U);
+}
+
+TEST(bpool, keep_max)
+{
+  Bpool pool{ 4096 };
+  {
+    Buf const buf1{ pool.take(4096) };
+    Buf const buf2{ pool.take(4096) };
+  } // only one is kept.
+  Buf const buf1{ pool.take(4096) };
+  Buf const buf2{ pool.take(4096) };
+  ASSERT_EQ(pool.hits(), 1U);
+  ASSERT_EQ(pool.misses(), 3U);
+}
+
+TEST(bpool, move)
+{
+  Bpool pool;
+  Buf   buf1{ pool.take(100) };
+  char* data{ buf1.data() };
+  Buf   buf2{ std::move(buf1) };
+  ASSERT_TRUE(buf1.empty()); // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(buf2.data(), data);
+  Buf buf3;
+  ASSERT_TRUE(buf3.empty());
+  buf3 = std::move(buf2);
+  ASSERT_EQ(buf3.data(), data);
+  buf3 = Buf{}; // given back.
+  buf3 = pool.take(100);
+  ASSERT_EQ(buf3.data(), data);
+  ASSERT_EQ(pool.hits(), 1U);
+}
+
+TEST(bpool, large_buffer)
+{
+  Bpool        pool;
+  size_t const size{ cfg::uring_bufs * cfg::chunk_size };
+  Buf const    buf{ pool.take(size) };
+  ASSERT_FALSE(buf.empty());
+  ASSERT_EQ(buf.size(), size);
+  std::memset(buf.data(), 0, buf.size());
+}
+
+} // namespace wndx::mqlqd
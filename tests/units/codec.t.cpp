@@ -0,0 +1,105 @@
+#include "wndx/mqlqd/codec.hpp"
+
+#include "wndx/mqlqd/proto.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+using codec::Codec;
+using codec::Ctype;
+
+namespace {
+
+/// \return codecs built into this binary.
+[[nodiscard]] std::vector<Ctype> built_in()
+{
+  std::vector<Ctype> vctype;
+  for (Ctype const ctype : { Ctype::ZSTD, Ctype::LZ4 }) {
+    if ((codec::available() & codec::to_flag(ctype)) != 0) {
+      vctype.push_back(ctype);
+    }
+  }
+  return vctype;
+}
+
+[[nodiscard]] std::string text(size_t const len)
+{
+  std::string out;
+  for (size_t i = 0; out.size() < len; ++i) {
+    out += std::to_string(i);
+    out += '\n';
+  }
+  out.resize(len);
+  return out;
+}
+
+[[nodiscard]] std::string noise(size_t const len)
+{
+  std::mt19937_64 gen{ 42 }; // NOLINT(*-magic-numbers)
+  std::string     out(len, '\0');
+  for (auto& ch : out) {
+    ch = static_cast<char>(gen());
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(codec, parse)
+{
+  Ctype ctype{ Ctype::NONE };
+  ASSERT_EQ(codec::parse("zstd", ctype), 0);
+  ASSERT_EQ(ctype, Ctype::ZSTD);
+  ASSERT_EQ(codec::parse("lz4", ctype), 0);
+  ASSERT_EQ(ctype, Ctype::LZ4);
+  ASSERT_EQ(codec::parse("none", ctype), 0);
+  ASSERT_EQ(ctype, Ctype::NONE);
+  ASSERT_EQ(codec::parse("gzip", ctype), -1);
+}
+
+TEST(codec, flags_prefer_zstd)
+{
+  ASSERT_EQ(codec::from_flags(proto::fl_zstd | proto::fl_lz4), Ctype::ZSTD);
+  ASSERT_EQ(codec::from_flags(proto::fl_lz4), Ctype::LZ4);
+  ASSERT_EQ(codec::from_flags(proto::fl_pipeline), Ctype::NONE);
+  ASSERT_EQ(codec::available() & ~(proto::fl_zstd | proto::fl_lz4), 0U);
+}
+
+TEST(codec, roundtrip)
+{
+  std::string const src{ text(cfg::chunk_size) };
+  for (Ctype const ctype : built_in()) {
+    Codec             cdc{ ctype };
+    std::vector<char> dst(cdc.bound(src.size()));
+    size_t const clen{ cdc.compress(src.data(), src.size(), dst.data(),
+                                    dst.size()) };
+    ASSERT_GT(clen, 0);
+    ASSERT_LT(clen, src.size());
+
+    std::string got(src.size(), '\0');
+    ASSERT_EQ(cdc.decompress(dst.data(), clen, got.data(), got.size()), 0);
+    ASSERT_EQ(got, src);
+    // size mismatch => malformed block.
+    ASSERT_EQ(cdc.decompress(dst.data(), clen, got.data(), got.size() - 1), -1);
+  }
+}
+
+TEST(codec, incompressible_is_raw)
+{
+  std::string const src{ noise(cfg::chunk_size) };
+  for (Ctype const ctype : built_in()) {
+    Codec             cdc{ ctype };
+    std::vector<char> dst(cdc.bound(src.size()));
+    ASSERT_EQ(cdc.compress(src.data(), src.size(), dst.data(), dst.size()), 0);
+    ASSERT_FALSE(cdc.worth(src.data(), cfg::comp_sample));
+    ASSERT_TRUE(cdc.worth(text(cfg::comp_sample).data(), cfg::comp_sample));
+  }
+}
+
+} // namespace wndx::mqlqd
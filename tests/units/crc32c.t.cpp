@@ -0,0 +1,56 @@
+#include "wndx/mqlqd/crc32c.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+/// \brief bit by bit reference. (slow, obviously correct)
+[[nodiscard]] u32 crc32c_ref(std::string const& s)
+{
+  u32 crc{ ~0U };
+  for (char const c : s) {
+    crc ^= static_cast<u8>(c);
+    for (int i = 0; i < 8; ++i) {
+      crc = (crc >> 1U) ^ ((crc & 1U) != 0 ? 0x82F63B78U : 0U);
+    }
+  }
+  return ~crc;
+}
+
+} // namespace
+
+TEST(crc32c, reference_vectors)
+{
+  // RFC 3720 (iSCSI), B.4.
+  ASSERT_EQ(crc32c(0, "", 0), 0U);
+  ASSERT_EQ(crc32c(0, "123456789", 9), 0xE3069283U);
+  std::string const zeros(32, '\0');
+  ASSERT_EQ(crc32c(0, zeros.data(), zeros.size()), 0x8A9136AAU);
+  std::string const ones(32, '\xFF');
+  ASSERT_EQ(crc32c(0, ones.data(), ones.size()), 0x62A8AB43U);
+}
+
+TEST(crc32c, streaming_equals_oneshot)
+{
+  // long enough for the interleaved lanes of the hardware implementation.
+  std::string s;
+  for (size_t i = 0; i < 100000; ++i) {
+    s += static_cast<char>((i * 2654435761U) >> 13U);
+  }
+  u32 const whole{ crc32c(0, s.data(), s.size()) };
+  ASSERT_EQ(whole, crc32c_ref(s));
+  for (size_t const step : { 1U, 7U, 255U, 4096U, 24577U, 65536U }) {
+    u32 crc{ 0 };
+    for (size_t off = 0; off < s.size(); off += step) {
+      crc = crc32c(crc, s.data() + off, std::min(step, s.size() - off));
+    }
+    ASSERT_EQ(crc, whole);
+  }
+}
+
+} // namespace wndx::mqlqd
@@ -0,0 +1,117 @@
+#include "wndx/mqlqd/delta.hpp"
+
+#include "wndx/mqlqd/config.hpp"
+#include "wndx/mqlqd/proto.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+
+namespace wndx::mqlqd {
+
+namespace {
+
+[[nodiscard]] std::string noise(size_t const len, unsigned const seed)
+{
+  std::mt19937_64 gen{ seed };
+  std::string     out(len, '\0');
+  for (auto& ch : out) {
+    ch = static_cast<char>(gen());
+  }
+  return out;
+}
+
+/// \brief signatures of the old content. (via the temporary file)
+[[nodiscard]] proto::Fsigs sigs_of(std::string const& old)
+{
+  proto::Fsigs fsigs{};
+  std::FILE*   tmp{ std::tmpfile() };
+  EXPECT_NE(tmp, nullptr);
+  EXPECT_EQ(std::fwrite(old.data(), 1, old.size(), tmp), old.size());
+  EXPECT_EQ(std::fflush(tmp), 0);
+  EXPECT_EQ(delta::signatures(fileno(tmp), old.size(), fsigs), 0);
+  static_cast<void>(std::fclose(tmp));
+  return fsigs;
+}
+
+/// \brief apply the delta as the server does. (literal bytes are counted)
+[[nodiscard]] std::string apply(std::string const& old, std::string const& cur,
+                                size_t& literal)
+{
+  proto::Fsigs const  fsigs{ sigs_of(old) };
+  delta::Sigset const sigset{ fsigs };
+  delta::Scanner      scanner{ cur.data(), cur.size(), sigset };
+  proto::Dop          op{};
+  std::string         out;
+  literal = 0;
+  while (scanner.next(op)) {
+    EXPECT_GT(op.len, 0);
+    if (op.kind == proto::Dkind::LITERAL) {
+      EXPECT_LE(op.len, cfg::chunk_size);
+      out     += cur.substr(op.off, op.len);
+      literal += op.len;
+    } else {
+      out += old.substr(op.off, op.len);
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(delta, block_size)
+{
+  ASSERT_EQ(delta::block_size(0), cfg::delta_block_min);
+  ASSERT_EQ(delta::block_size(10ULL << 30U) % 1024, 0);
+  ASSERT_EQ(delta::block_size(1ULL << 50U), proto::block_max);
+}
+
+TEST(delta, rolling_equals_init)
+{
+  std::string const data{ noise(4096, 1) };
+  size_t const      block{ 1000 };
+  delta::Rsum       roll;
+  roll.init(data.data(), block);
+  for (size_t pos = 1; pos + block <= data.size(); ++pos) {
+    roll.roll(data[pos - 1], data[pos + block - 1]);
+    delta::Rsum fresh;
+    fresh.init(data.data() + pos, block);
+    ASSERT_EQ(roll.value(), fresh.value());
+  }
+}
+
+TEST(delta, appended)
+{
+  std::string const old{ noise(1'000'000, 2) };
+  std::string const cur{ old + noise(50'000, 3) };
+  size_t            literal{ 0 };
+  ASSERT_EQ(apply(old, cur, literal), cur);
+  // only the appended bytes & the tail of the old copy (< block).
+  ASSERT_LT(literal, 50'000 + delta::block_size(old.size()));
+}
+
+TEST(delta, modified_inserted_removed)
+{
+  std::string const old{ noise(600'000, 4) };
+  std::string       cur{ old };
+  cur.replace(100'000, 10, "0123456789");
+  cur.insert(300'000, "inserted bytes");
+  cur.erase(500'000, 777);
+  size_t literal{ 0 };
+  ASSERT_EQ(apply(old, cur, literal), cur);
+  ASSERT_LT(literal, 5 * delta::block_size(old.size()));
+}
+
+TEST(delta, unrelated_is_literal)
+{
+  std::string const old{ noise(200'000, 5) };
+  std::string const cur{ noise(700'000, 6) };
+  size_t            literal{ 0 };
+  ASSERT_EQ(apply(old, cur, literal), cur);
+  ASSERT_EQ(literal, cur.size());
+}
+
+} // namespace wndx::mqlqd
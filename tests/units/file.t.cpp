@@ -4,6 +4,7 @@
 
 #include <cstring> // memcpy
 #include <filesystem>
+#include <fstream>
 #include <string>
 #include <system_error>
 
@@ -210,4 +211,30 @@ TEST_F(File_test, copy_and_move)
   ASSERT_EQ(file2.path(), fpath2);
 }
 
+TEST_F(File_test, map_eq_read)
+{
+  auto const file1{ alloc_file("ascii_3.txt") };
+  m_do_alloc = false;
+  auto file2{ alloc_file("ascii_3.txt") };
+  ASSERT_FALSE(file2.mapped());
+  ASSERT_TRUE(file2.map() == rc::SUCCESS);
+  ASSERT_TRUE(file2.mapped());
+  ASSERT_TRUE(file2.memory() == nullptr); // not read into the heap.
+  ASSERT_EQ(0, std::memcmp(file1.data(), file2.data(), file1.size()));
+  auto const file3{ file2 }; // copy shares the mapping.
+  ASSERT_EQ(file2.data(), file3.data());
+}
+
+TEST_F(File_test, map_empty_and_not_regular)
+{
+  fs::path const fpath{ get_tmp_dir() / "empty.txt" };
+  { std::ofstream{ fpath }; }
+  file::File empty{ fpath, 0 };
+  ASSERT_TRUE(empty.map() == rc::SUCCESS);
+  ASSERT_FALSE(empty.mapped());
+  file::File dir{ get_tmp_dir(), 1 };
+  ASSERT_TRUE(dir.map() == rc::FAILURE);
+  ASSERT_FALSE(dir.mapped());
+}
+
 } // namespace wndx::mqlqd
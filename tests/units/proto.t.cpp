@@ -0,0 +1,296 @@
+#include "wndx/mqlqd/proto.hpp"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+
+namespace wndx::mqlqd {
+
+using proto::Pres;
+
+TEST(proto, varint_roundtrip)
+{
+  for (u64 const v : { u64{ 0 }, u64{ 1 }, u64{ 127 }, u64{ 128 },
+                       u64{ 300 }, u64{ 1ULL << 32U },
+                       std::numeric_limits<u64>::max() })
+  {
+    std::string out;
+    proto::put_varint(out, v);
+    u64    got{ 0 };
+    size_t n{ 0 };
+    ASSERT_EQ(proto::get_varint(out.data(), out.size(), got, n), Pres::OK);
+    ASSERT_EQ(got, v);
+    ASSERT_EQ(n, out.size());
+  }
+}
+
+TEST(proto, varint_small_is_one_byte)
+{
+  std::string out;
+  proto::put_varint(out, 127);
+  ASSERT_EQ(out.size(), 1);
+  out.clear();
+  proto::put_varint(out, 128);
+  ASSERT_EQ(out.size(), 2);
+}
+
+TEST(proto, varint_more_and_bad)
+{
+  std::string out;
+  proto::put_varint(out, 1ULL << 40U);
+  u64    got{ 0 };
+  size_t n{ 0 };
+  ASSERT_EQ(proto::get_varint(out.data(), out.size() - 1, got, n), Pres::MORE);
+  std::string const overflow(11, '\xFF');
+  ASSERT_EQ(proto::get_varint(overflow.data(), overflow.size(), got, n),
+            Pres::BAD);
+}
+
+TEST(proto, u32le_byte_order)
+{
+  std::string out;
+  proto::put_u32le(out, proto::magic);
+  ASSERT_EQ(out, "MQLQ");
+}
+
+TEST(proto, hello_roundtrip)
+{
+  proto::Hello hello{};
+  hello.flags = 0xA5U;
+  hello.uid   = "f000::f000:f000:f000:f000";
+  std::string out;
+  proto::encode(out, hello);
+
+  proto::Hello got{};
+  size_t       n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, out.size());
+  ASSERT_EQ(got.version, proto::version);
+  ASSERT_EQ(got.flags, hello.flags);
+  ASSERT_EQ(got.uid, hello.uid);
+  // every truncated prefix must ask for more bytes.
+  for (size_t len = 0; len < out.size(); ++len) {
+    ASSERT_EQ(proto::decode(out.data(), len, got, n), Pres::MORE);
+  }
+}
+
+TEST(proto, hello_bad_magic)
+{
+  std::string out;
+  proto::encode(out, proto::Hello{});
+  out[0] = 'X';
+  proto::Hello got{};
+  size_t       n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::BAD);
+}
+
+TEST(proto, hello_ack_fixed_size)
+{
+  std::string out;
+  proto::encode_ack(out, proto::Hello{});
+  ASSERT_EQ(out.size(), proto::hello_ack_len);
+  proto::Hello got{};
+  size_t       n{ 0 };
+  ASSERT_EQ(proto::decode_ack(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, proto::hello_ack_len);
+}
+
+TEST(proto, fhdr_roundtrip)
+{
+  proto::Fhdr hdr{};
+  hdr.size = 7652;
+  hdr.name = "ascii_3.txt";
+  std::string out;
+  proto::encode(out, hdr);
+  // short name => header is much smaller than the legacy file::Finfo.
+  ASSERT_LT(out.size(), 20);
+
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, out.size());
+  ASSERT_EQ(got.size, hdr.size);
+  ASSERT_EQ(got.name, hdr.name);
+}
+
+TEST(proto, fhdr_range_roundtrip)
+{
+  proto::Fhdr hdr{};
+  hdr.hflags = proto::hf_range;
+  hdr.size   = 1024;
+  hdr.offset = 4096;
+  hdr.total  = 8192;
+  hdr.name   = "big.bin";
+  std::string out;
+  proto::encode(out, hdr);
+
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, out.size());
+  ASSERT_EQ(got.offset, hdr.offset);
+  ASSERT_EQ(got.total, hdr.total);
+  ASSERT_EQ(got.name, hdr.name);
+}
+
+TEST(proto, fhdr_hash_roundtrip)
+{
+  proto::Fhdr hdr{};
+  hdr.hflags = proto::hf_hash;
+  hdr.size   = 7652;
+  hdr.hash   = 0xEF46DB3751D8E999ULL;
+  hdr.name   = "ascii_3.txt";
+  std::string out;
+  proto::encode(out, hdr);
+
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, out.size());
+  ASSERT_EQ(got.hash, hdr.hash);
+  ASSERT_EQ(got.name, hdr.name);
+  // truncated hash => incomplete.
+  ASSERT_EQ(proto::decode(out.data(), 6, got, n), Pres::MORE);
+}
+
+TEST(proto, fhdr_hash_src_roundtrip)
+{
+  proto::Fhdr hdr{};
+  hdr.hflags = proto::hf_hash | proto::hf_src;
+  hdr.size   = 7652;
+  hdr.hash   = 0xEF46DB3751D8E999ULL;
+  hdr.src    = 0x0123456789ABCDEFULL;
+  hdr.name   = "ascii_3.txt";
+  std::string out;
+  proto::encode(out, hdr);
+
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+  ASSERT_EQ(n, out.size());
+  ASSERT_EQ(got.hash, hdr.hash);
+  ASSERT_EQ(got.src, hdr.src);
+  ASSERT_EQ(got.name, hdr.name);
+  // truncated src => incomplete.
+  ASSERT_EQ(proto::decode(out.data(), 14, got, n), Pres::MORE);
+}
+
+TEST(proto, fhdr_range_outside_of_file)
+{
+  proto::Fhdr hdr{};
+  hdr.hflags = proto::hf_range;
+  hdr.size   = 1024;
+  hdr.offset = 8000;
+  hdr.total  = 8192;
+  hdr.name   = "big.bin";
+  std::string out;
+  proto::encode(out, hdr);
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::BAD);
+}
+
+TEST(proto, plan_roundtrip)
+{
+  std::vector<u64> const voff{ 0, 1, 4096, 1ULL << 40U };
+  std::string            out;
+  proto::encode_plan(out, voff);
+  // length prefix followed by the body.
+  u64    len{ 0 };
+  size_t n{ 0 };
+  ASSERT_EQ(proto::get_varint(out.data(), out.size(), len, n), Pres::OK);
+  ASSERT_EQ(n + len, out.size());
+
+  std::vector<u64> got;
+  ASSERT_EQ(proto::decode_plan(out.data() + n, len, got), Pres::OK);
+  ASSERT_EQ(got, voff);
+  ASSERT_EQ(proto::decode_plan(out.data() + n, len - 1, got), Pres::BAD);
+}
+
+TEST(proto, verdict_publish_roundtrip)
+{
+  std::vector<u64> const vidx{ 2, 7 };
+  std::vector<u64> const vpub{ 0, 1ULL << 33U };
+  std::string            out;
+  proto::encode_verdict(out, vidx, vpub);
+  u64    len{ 0 };
+  size_t n{ 0 };
+  ASSERT_EQ(proto::get_varint(out.data(), out.size(), len, n), Pres::OK);
+  ASSERT_EQ(n + len, out.size());
+
+  std::vector<u64> got_idx;
+  std::vector<u64> got_pub;
+  ASSERT_EQ(proto::decode_verdict(out.data() + n, len, got_idx, got_pub),
+            Pres::OK);
+  ASSERT_EQ(got_idx, vidx);
+  ASSERT_EQ(got_pub, vpub);
+  // the plain Verdict has no second list.
+  ASSERT_EQ(proto::decode_verdict(out.data() + n, len, got_idx), Pres::BAD);
+  ASSERT_EQ(proto::decode_verdict(out.data() + n, len - 1, got_idx, got_pub),
+            Pres::BAD);
+}
+
+TEST(proto, dop_roundtrip)
+{
+  for (proto::Dop const op :
+       { proto::Dop{ .kind = proto::Dkind::LITERAL, .len = 300, .off = 0 },
+         proto::Dop{ .kind = proto::Dkind::COPY, .len = 1ULL << 33U,
+                     .off = 4096 } })
+  {
+    std::string out;
+    proto::encode(out, op);
+    proto::Dop got{};
+    size_t     n{ 0 };
+    ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::OK);
+    ASSERT_EQ(n, out.size());
+    ASSERT_EQ(got.kind, op.kind);
+    ASSERT_EQ(got.len, op.len);
+    ASSERT_EQ(got.off, op.off);
+  }
+  char const bad[]{ 2, 1 }; // NOLINT(*-avoid-c-arrays) - unknown op.
+  proto::Dop got{};
+  size_t     n{ 0 };
+  ASSERT_EQ(proto::decode(bad, sizeof(bad), got, n), Pres::BAD);
+}
+
+TEST(proto, sigs_roundtrip)
+{
+  std::vector<proto::Fsigs> vfsigs(2);
+  vfsigs[0].idx   = 3;
+  vfsigs[0].block = 2048;
+  vfsigs[0].vsig  = { { 1, 2 }, { 0xFFFFFFFFU, 1ULL << 63U } };
+  vfsigs[1].idx   = 7;
+  vfsigs[1].block = 4096;
+  std::string out;
+  proto::encode_sigs(out, vfsigs);
+  u64    len{ 0 };
+  size_t n{ 0 };
+  ASSERT_EQ(proto::get_varint(out.data(), out.size(), len, n), Pres::OK);
+  ASSERT_EQ(n + len, out.size());
+
+  std::vector<proto::Fsigs> got;
+  ASSERT_EQ(proto::decode_sigs(out.data() + n, len, got), Pres::OK);
+  ASSERT_EQ(got.size(), 2);
+  ASSERT_EQ(got[0].idx, 3);
+  ASSERT_EQ(got[0].vsig.size(), 2);
+  ASSERT_EQ(got[0].vsig[1].weak, 0xFFFFFFFFU);
+  ASSERT_EQ(got[0].vsig[1].strong, 1ULL << 63U);
+  ASSERT_EQ(got[1].block, 4096);
+  ASSERT_EQ(proto::decode_sigs(out.data() + n, len - 1, got), Pres::BAD);
+}
+
+TEST(proto, fhdr_name_too_long)
+{
+  proto::Fhdr hdr{};
+  hdr.name = std::string(proto::name_max + 1, 'x');
+  std::string out;
+  proto::encode(out, hdr);
+  proto::Fhdr got{};
+  size_t      n{ 0 };
+  ASSERT_EQ(proto::decode(out.data(), out.size(), got, n), Pres::BAD);
+}
+
+} // namespace wndx::mqlqd
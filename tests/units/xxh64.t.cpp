@@ -0,0 +1,34 @@
+#include "wndx/mqlqd/xxh64.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+
+namespace wndx::mqlqd {
+
+TEST(xxh64, reference_vectors)
+{
+  ASSERT_EQ(xxh64("", 0), 0xEF46DB3751D8E999ULL);
+  ASSERT_EQ(xxh64("a", 1), 0xD24EC4F1A98C6E5BULL);
+  ASSERT_EQ(xxh64("abc", 3), 0x44BC2CF5AD770999ULL);
+  std::string const s{ "Nobody inspects the spammish repetition" };
+  ASSERT_EQ(xxh64(s.data(), s.size()), 0xFBCEA83C8A378BF1ULL);
+}
+
+TEST(xxh64, streaming_equals_oneshot)
+{
+  std::string s;
+  for (size_t i = 0; i < 1000; ++i) {
+    s += static_cast<char>(i * 131U);
+  }
+  for (size_t const step : { 1U, 3U, 31U, 32U, 33U, 500U }) {
+    Xxh64 h{ 7 };
+    for (size_t off = 0; off < s.size(); off += step) {
+      h.update(s.data() + off, std::min(step, s.size() - off));
+    }
+    ASSERT_EQ(h.digest(), xxh64(s.data(), s.size(), 7));
+  }
+}
+
+} // namespace wndx::mqlqd